@@ -246,18 +246,18 @@ static int distributeSingleArgSelf(ReducerDistCtx *rdctx, QueryError *status) {
 #define STRINGIFY__(a) #a
 #define RANDOM_SAMPLE_SIZE_STR STRINGIFY_(RANDOM_SAMPLE_SIZE)
 
-/* Distribute QUANTILE into remote RANDOM_SAMPLE and local QUANTILE */
+/* Distribute QUANTILE into remote TDIGEST and local TDIGEST_QUANTILE, which merges the digests */
 static int distributeQuantile(ReducerDistCtx *rdctx, QueryError *status) {
   PLN_Reducer *src = rdctx->srcReducer;
   CHECK_ARG_COUNT(2);
   const char *alias = NULL;
 
-  if (!rdctx->addRemote("RANDOM_SAMPLE", &alias, status, "2", rdctx->srcarg(0),
-                        RANDOM_SAMPLE_SIZE_STR)) {
+  if (!rdctx->addRemote("TDIGEST", &alias, status, "1", rdctx->srcarg(0))) {
     return REDISMODULE_ERR;
   }
 
-  if (!rdctx->addLocal("QUANTILE", status, "2", alias, rdctx->srcarg(1), "AS", src->alias)) {
+  if (!rdctx->addLocal("TDIGEST_QUANTILE", status, "2", alias, rdctx->srcarg(1), "AS",
+                       src->alias)) {
     return REDISMODULE_ERR;
   }
 
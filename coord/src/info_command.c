@@ -25,6 +25,7 @@ static InfoFieldSpec toplevelSpecs_g[] = {
     {.name = "doc_table_size_mb", .type = InfoField_DoubleSum},
     {.name = "sortable_values_size_mb", .type = InfoField_DoubleSum},
     {.name = "key_table_size_mb", .type = InfoField_DoubleSum},
+    {.name = "quantized_vectors_sz_mb", .type = InfoField_DoubleSum},
     {.name = "records_per_doc_avg", .type = InfoField_DoubleAverage},
     {.name = "bytes_per_record_avg", .type = InfoField_DoubleAverage},
     {.name = "offsets_per_term_avg", .type = InfoField_DoubleAverage},
@@ -153,11 +153,54 @@ static void testSplit() {
   }
 }
 
+/**
+ *         cmd = ['FT.AGGREGATE', 'games', '*',
+               'GROUPBY', '1', '@brand',
+               'REDUCE', 'QUANTILE', '2', '@price', '0.5', 'AS', 'q50'
+               ]
+ */
+static void testQuantile() {
+  AREQ *r = AREQ_New();
+  RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(NULL);
+  RMCK::ArgvList vv(ctx, "*",                                                     // nl
+                    "GROUPBY", "1", "@brand",                                     // nl
+                    "REDUCE", "QUANTILE", "2", "@price", "0.5", "AS", "q50"       // nl
+  );
+  QueryError status{QueryErrorCode(0)};
+  int rc = AREQ_Compile(r, vv, vv.size(), &status);
+  if (rc != REDISMODULE_OK) {
+    printf("Couldn't compile: %s\n", QueryError_GetError(&status));
+    abort();
+  }
+
+  rc = AGGPLN_Distribute(&r->ap, &status);
+  assert(rc == REDISMODULE_OK);
+
+  AREQDIST_UpstreamInfo us = {0};
+  rc = AREQ_BuildDistributedPipeline(r, &us, &status);
+  if (rc != REDISMODULE_OK) {
+    printf("Couldn't build distributed pipeline: %s\n", QueryError_GetError(&status));
+  }
+  assert(rc == REDISMODULE_OK);
+  AGPLN_Dump(&r->ap);
+
+  // The shards reply with t-digests, rather than with samples of the values
+  bool hasDigest = false;
+  for (size_t ii = 0; ii < us.nserialized; ++ii) {
+    printf("Serialized[%lu]: %s\n", ii, us.serialized[ii]);
+    hasDigest |= !strcasecmp(us.serialized[ii], "TDIGEST");
+    assert(strcasecmp(us.serialized[ii], "RANDOM_SAMPLE"));
+  }
+  assert(hasDigest);
+  AREQ_Free(r);
+}
+
 int main(int, char **) {
   RMCK_Bootstrap(my_OnLoad, NULL, 0);
   RMCK::init();
   // testAverage();
   testCountDistinct();
+  testQuantile();
 }
 
 //REDISMODULE_INIT_SYMBOLS();
@@ -52,6 +52,9 @@ typedef enum {
   /* FT.AGGREGATE load all fields */
   QEXEC_AGG_LOAD_ALL = 0x20000,
 
+  /* FT.SEARCH WITHOUTCOUNT: the total may be a lower bound of the number of matches */
+  QEXEC_F_NO_TOTAL = 0x40000,
+
 } QEFlags;
 
 #define IsCount(r) ((r)->reqflags & QEXEC_F_NOROWS)
@@ -230,6 +233,16 @@ ResultProcessor *Grouper_GetRP(Grouper *gr);
  */
 void Grouper_AddReducer(Grouper *g, Reducer *r, RLookupKey *dst);
 
+/**
+ * Only yield the first `k` groups when ordered by `sortkey`, which must be the
+ * destination key of a reducer or of a group property. This is used when the
+ * GROUPBY is followed by a SORTBY with a limit, which would discard the other
+ * groups: they are then never written out as rows.
+ *
+ * Returns 0 if the key is not an output of the grouper.
+ */
+int Grouper_SetTopK(Grouper *g, const RLookupKey *sortkey, int ascending, size_t k);
+
 void AREQ_Execute(AREQ *req, RedisModuleCtx *outctx);
 void sendChunk(AREQ *req, RedisModuleCtx *outctx, size_t limit);
 void AREQ_Free(AREQ *req);
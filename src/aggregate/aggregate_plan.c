@@ -115,6 +115,12 @@ static void arrangeDtor(PLN_BaseStep *bstp) {
   if (astp->sortKeys) {
     array_free(astp->sortKeys);
   }
+  if (astp->afterValues) {
+    for (size_t ii = 0; ii < array_len(astp->afterValues); ++ii) {
+      RSValue_Decref(astp->afterValues[ii]);
+    }
+    array_free(astp->afterValues);
+  }
   rm_free(astp->sortkeysLK);
   rm_free(bstp);
 }
@@ -92,6 +92,8 @@ typedef struct {
   int isLimited;                  // Flag if `LIMIT` keyward was used.
   uint64_t offset;                // Seek results. If 0, then no paging is applied
   uint64_t limit;                 // Number of rows to output
+  const char *afterKey;           // SEARCHAFTER: the key of the last document of the previous page
+  RSValue **afterValues;          // SEARCHAFTER: its sort values. array_*
 } PLN_ArrangeStep;
 
 /** LOAD covers any fields not implicitly found within the document */
@@ -9,6 +9,7 @@
 #include "ext/default.h"
 #include "extension.h"
 #include "profile.h"
+#include "numeric_index.h"
 
 /**
  * Ensures that the user has not requested one of the 'extended' features. Extended
@@ -336,6 +337,47 @@ static int parseQueryLegacyArgs(ArgsCursor *ac, RSSearchOptions *options, QueryE
   return ARG_HANDLED;
 }
 
+/* Parse a SEARCHAFTER sort value, in the format of WITHSORTKEYS: '#' prefixes numbers and '$'
+ * prefixes strings. NULL stands for a missing value, and other values are numbers if they parse
+ * as such */
+static RSValue *parseSortValue(const char *s, size_t len) {
+  if (!strcasecmp(s, "NULL")) {
+    return RS_NullVal();
+  } else if (*s == '$') {
+    return RS_NewCopiedString(s + 1, len - 1);
+  }
+  const char *num = *s == '#' ? s + 1 : s;
+  char *end;
+  double d = strtod(num, &end);
+  if (end != num && end == s + len) {
+    return RS_NumVal(d);
+  }
+  return RS_NewCopiedString(s, len);
+}
+
+static int parseSearchAfter(AREQ *req, ArgsCursor *ac, QueryError *status) {
+  PLN_ArrangeStep *arng = AGPLN_GetOrCreateArrangeStep(&req->ap);
+  ArgsCursor subArgs = {0};
+  int rv = AC_GetVarArgs(ac, &subArgs);
+  if (rv != AC_OK) {
+    QERR_MKBADARGS_AC(status, "SEARCHAFTER", rv);
+    return REDISMODULE_ERR;
+  }
+  if (arng->afterValues || AC_NumRemaining(&subArgs) < 2) {
+    QERR_MKBADARGS_FMT(status, "SEARCHAFTER requires a document key and its sort values");
+    return REDISMODULE_ERR;
+  }
+
+  arng->afterKey = AC_GetStringNC(&subArgs, NULL);
+  arng->afterValues = array_new(RSValue *, AC_NumRemaining(&subArgs));
+  while (!AC_IsAtEnd(&subArgs)) {
+    size_t len;
+    const char *s = AC_GetStringNC(&subArgs, &len);
+    arng->afterValues = array_append(arng->afterValues, parseSortValue(s, len));
+  }
+  return REDISMODULE_OK;
+}
+
 static int parseQueryArgs(ArgsCursor *ac, AREQ *req, RSSearchOptions *searchOpts,
                           AggregatePlan *plan, QueryError *status) {
   // Parse query-specific arguments..
@@ -362,6 +404,7 @@ static int parseQueryArgs(ArgsCursor *ac, AREQ *req, RSSearchOptions *searchOpts
       {AC_MKBITFLAG("NOCONTENT", &req->reqflags, QEXEC_F_SEND_NOFIELDS)},
       {AC_MKBITFLAG("NOSTOPWORDS", &searchOpts->flags, Search_NoStopwrods)},
       {AC_MKBITFLAG("EXPLAINSCORE", &req->reqflags, QEXEC_F_SEND_SCOREEXPLAIN)},
+      {AC_MKBITFLAG("WITHOUTCOUNT", &req->reqflags, QEXEC_F_NO_TOTAL)},
       {.name = "PAYLOAD",
        .type = AC_ARGTYPE_STRING,
        .target = &req->ast.udata,
@@ -397,6 +440,11 @@ static int parseQueryArgs(ArgsCursor *ac, AREQ *req, RSSearchOptions *searchOpts
       }
       req->reqflags |= QEXEC_F_SEND_HIGHLIGHT;
 
+    } else if ((req->reqflags & QEXEC_F_IS_SEARCH) && AC_AdvanceIfMatch(ac, "SEARCHAFTER")) {
+      if (parseSearchAfter(req, ac, status) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+      }
+
     } else if ((req->reqflags & QEXEC_F_IS_SEARCH) &&
                ((rv = parseQueryLegacyArgs(ac, searchOpts, status)) != ARG_UNKNOWN)) {
       if (rv == ARG_ERROR) {
@@ -771,6 +819,78 @@ static void applyGlobalFilters(RSSearchOptions *opts, QueryAST *ast, const Redis
   }
 }
 
+/* The number of rows kept by an arrange step's sorter */
+static size_t arrangeLimit(const PLN_ArrangeStep *astp) {
+  size_t limit = astp->offset + astp->limit;
+  return limit ? limit : DEFAULT_LIMIT;
+}
+
+/**
+ * With SEARCHAFTER on an ascending numeric sort key, the sorter skips all the documents with
+ * lower values. Filter them out of the query, so the numeric index seeks past them instead.
+ */
+static void applySearchAfterFilter(AREQ *req, RedisSearchCtx *sctx) {
+  const PLN_ArrangeStep *astp = AGPLN_GetArrangeStep(&req->ap);
+  if (!IsSearch(req) || !astp || !astp->afterValues || !astp->sortKeys ||
+      array_len(astp->sortKeys) != array_len(astp->afterValues) ||
+      !SORTASCMAP_GETASC(astp->sortAscMap, 0) || astp->afterValues[0]->t != RSValue_Number) {
+    return;
+  }
+  const char *name = astp->sortKeys[0];
+  const FieldSpec *fs = IndexSpec_GetField(sctx->spec, name, strlen(name));
+  if (!fs || !FIELD_IS(fs, INDEXFLD_T_NUMERIC)) {
+    return;
+  }
+  NumericFilter *nf = NewNumericFilter(astp->afterValues[0]->numval, NF_INFINITY, 1, 1);
+  nf->fieldName = rm_strdup(fs->name);
+  *array_ensure_tail(&req->searchopts.legacy.filters, NumericFilter *) = nf;
+}
+
+/* Whether the query only matches documents which have a value in a numeric field */
+static int queryHasNumericFilter(const QueryNode *qn, const char *field) {
+  if (qn->type == QN_NUMERIC) {
+    return !strcmp(qn->nn.nf->fieldName, field);
+  } else if (qn->type == QN_PHRASE) {
+    for (size_t ii = 0; ii < QueryNode_NumChildren(qn); ++ii) {
+      if (queryHasNumericFilter(qn->children[ii], field)) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/**
+ * A search sorted by a single sortable numeric field can read the matches by the order of the
+ * field's numeric index, and stop once the sorter has all the rows it keeps. The total is then
+ * only a lower bound, so this is only done if the request does not need it.
+ */
+static void applyNumericSortedScan(AREQ *req, RedisSearchCtx *sctx) {
+  if (!IsSearch(req) || !(req->reqflags & QEXEC_F_NO_TOTAL) || IsCount(req) || IsProfile(req) ||
+      !req->rootiter) {
+    return;
+  }
+  const PLN_ArrangeStep *astp = AGPLN_GetArrangeStep(&req->ap);
+  if (!astp || !astp->sortKeys || array_len(astp->sortKeys) != 1) {
+    return;
+  }
+  const char *name = astp->sortKeys[0];
+  const FieldSpec *fs = IndexSpec_GetField(sctx->spec, name, strlen(name));
+  if (!fs || !FIELD_IS(fs, INDEXFLD_T_NUMERIC) || !FieldSpec_IsSortable(fs)) {
+    return;
+  }
+  int ascending = SORTASCMAP_GETASC(astp->sortAscMap, 0);
+  // Documents without a value sort first in ascending order, but are read last
+  if (ascending && !queryHasNumericFilter(req->ast.root, fs->name)) {
+    return;
+  }
+  IndexIterator *it =
+      NewNumericSortedIterator(sctx, fs->name, req->rootiter, ascending, arrangeLimit(astp));
+  if (it) {
+    req->rootiter = it;
+  }
+}
+
 int AREQ_ApplyContext(AREQ *req, RedisSearchCtx *sctx, QueryError *status) {
   // Sort through the applicable options:
   IndexSpec *index = sctx->spec;
@@ -816,6 +936,7 @@ int AREQ_ApplyContext(AREQ *req, RedisSearchCtx *sctx, QueryError *status) {
   }
 
   QAST_EvalParams(ast, opts, status);
+  applySearchAfterFilter(req, sctx);
   applyGlobalFilters(opts, ast, sctx);
 
   if (!(opts->flags & Search_Verbatim)) {
@@ -828,6 +949,7 @@ int AREQ_ApplyContext(AREQ *req, RedisSearchCtx *sctx, QueryError *status) {
   req->rootiter = QAST_Iterate(ast, opts, sctx, &req->conc, status);
   if (QueryError_HasError(status))
     return REDISMODULE_ERR;
+  applyNumericSortedScan(req, sctx);
   if (IsProfile(req)) {
     // Add a Profile iterators before every iterator in the tree
     Profile_AddIters(&req->rootiter);
@@ -836,7 +958,28 @@ int AREQ_ApplyContext(AREQ *req, RedisSearchCtx *sctx, QueryError *status) {
   return REDISMODULE_OK;
 }
 
-static ResultProcessor *buildGroupRP(PLN_GroupStep *gstp, RLookup *srclookup, QueryError *err) {
+/**
+ * If the group step is directly followed by a SORTBY on a single one of its
+ * outputs, the sorter only keeps a bounded number of groups, so the grouper can
+ * select them itself rather than writing out a row for every group.
+ */
+static void setGroupTopK(AREQ *req, PLN_GroupStep *gstp, Grouper *grp) {
+  const DLLIST_node *next = gstp->base.llnodePln.next;
+  if (IsCount(req) || next == &req->ap.steps) {
+    return;
+  }
+  const PLN_ArrangeStep *astp = DLLIST_ITEM(next, PLN_ArrangeStep, base.llnodePln);
+  if (astp->base.type != PLN_T_ARRANGE || !astp->sortKeys || array_len(astp->sortKeys) != 1) {
+    return;
+  }
+  const RLookupKey *sortkey = RLookup_GetKey(&gstp->lookup, astp->sortKeys[0], RLOOKUP_F_NOINCREF);
+  if (sortkey) {
+    Grouper_SetTopK(grp, sortkey, SORTASCMAP_GETASC(astp->sortAscMap, 0), arrangeLimit(astp));
+  }
+}
+
+static ResultProcessor *buildGroupRP(AREQ *req, PLN_GroupStep *gstp, RLookup *srclookup,
+                                     QueryError *err) {
   const RLookupKey *srckeys[gstp->nproperties], *dstkeys[gstp->nproperties];
   for (size_t ii = 0; ii < gstp->nproperties; ++ii) {
     const char *fldname = gstp->properties[ii] + 1;  // account for the @-
@@ -874,6 +1017,7 @@ static ResultProcessor *buildGroupRP(PLN_GroupStep *gstp, RLookup *srclookup, Qu
     Grouper_AddReducer(grp, rr, dstkey);
   }
 
+  setGroupTopK(req, gstp, grp);
   return Grouper_GetRP(grp);
 }
 
@@ -900,7 +1044,7 @@ static ResultProcessor *getGroupRP(AREQ *req, PLN_GroupStep *gstp, ResultProcess
                                    QueryError *status) {
   AGGPlan *pln = &req->ap;
   RLookup *lookup = AGPLN_GetLookup(pln, &gstp->base, AGPLN_GETLOOKUP_PREV);
-  ResultProcessor *groupRP = buildGroupRP(gstp, lookup, status);
+  ResultProcessor *groupRP = buildGroupRP(req, gstp, lookup, status);
 
   if (!groupRP) {
     return NULL;
@@ -929,6 +1073,46 @@ static ResultProcessor *getGroupRP(AREQ *req, PLN_GroupStep *gstp, ResultProcess
 }
 
 #define _SCORE_LEN 6
+#define _DISTANCE_SUFFIX "_distance"
+
+/* The geo field of a `{field}_distance` key, the distance of a NEAREST geo filter, or NULL */
+static const FieldSpec *geoDistanceField(const IndexSpec *spec, const char *key) {
+  size_t len = strlen(key), suffixLen = strlen(_DISTANCE_SUFFIX);
+  if (len <= suffixLen || strcmp(key + len - suffixLen, _DISTANCE_SUFFIX)) {
+    return NULL;
+  }
+  const FieldSpec *fs = IndexSpec_GetField(spec, key, len - suffixLen);
+  return fs && FIELD_IS(fs, INDEXFLD_T_GEO) ? fs : NULL;
+}
+
+/* Restrict the sorter to the results after the SEARCHAFTER document */
+static int setSearchAfter(AREQ *req, const PLN_ArrangeStep *astp, ResultProcessor *sorter,
+                          QueryError *status) {
+  size_t nkeys = astp->sortKeys ? array_len(astp->sortKeys) : 1;
+  if (array_len(astp->afterValues) != nkeys) {
+    QueryError_SetErrorFmt(status, QUERY_EPARSEARGS,
+                           "SEARCHAFTER requires a sort value for each sort key (%zu)", nkeys);
+    return REDISMODULE_ERR;
+  }
+  double score;
+  if (!astp->sortKeys && !RSValue_ToNumber(astp->afterValues[0], &score)) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, "SEARCHAFTER requires a numeric score");
+    return REDISMODULE_ERR;
+  }
+  t_docId docId =
+      DocTable_GetId(&req->sctx->spec->docs, astp->afterKey, strlen(astp->afterKey));
+  RPSorter_SetSearchAfter(sorter, astp->afterValues, docId);
+  return REDISMODULE_OK;
+}
+
+static int isNotBatchVectorNode(QueryNode *n, QueryNode *root, void *ctx) {
+  return n->type != QN_VECTOR || !n->vn.vf->batch || strcmp(n->vn.vf->property, ctx);
+}
+
+/* Whether the query has a batch of query vectors for the vector field `name` */
+static int hasBatchVectorQuery(const AREQ *req, const char *name) {
+  return req->ast.root && !QueryNode_ForEach(req->ast.root, isNotBatchVectorNode, (void *)name, 0);
+}
 
 static ResultProcessor *getArrangeRP(AREQ *req, AGGPlan *pln, const PLN_BaseStep *stp,
                                      QueryError *status, ResultProcessor *up) {
@@ -937,6 +1121,7 @@ static ResultProcessor *getArrangeRP(AREQ *req, AGGPlan *pln, const PLN_BaseStep
   PLN_ArrangeStep *astp = (PLN_ArrangeStep *)stp;
   IndexSpec *spec = req->sctx ? req->sctx->spec : NULL; // check for sctx?
   SortByType sortbyType = SORTBY_FIELD;
+  const FieldSpec *distanceField = NULL;
 
   if (!astp) {
     astp = &astp_s;
@@ -948,18 +1133,17 @@ static ResultProcessor *getArrangeRP(AREQ *req, AGGPlan *pln, const PLN_BaseStep
     return up;
   }
 
-  size_t limit = astp->offset + astp->limit;
-  if (!limit) {
-    limit = DEFAULT_LIMIT;
-  }
+  size_t limit = arrangeLimit(astp);
 
   if (astp->sortKeys) {
     size_t nkeys = array_len(astp->sortKeys);
-    astp->sortkeysLK = rm_malloc(sizeof(*astp->sortKeys) * nkeys);
+    // a batch vector query may add a key for the position of the query vector
+    astp->sortkeysLK = rm_malloc(sizeof(*astp->sortKeys) * (nkeys + 1));
 
     const RLookupKey **sortkeys = astp->sortkeysLK;
 
     RLookup *lk = AGPLN_GetLookup(pln, stp, AGPLN_GETLOOKUP_PREV);
+    uint64_t ascMap = astp->sortAscMap;
 
     for (size_t ii = 0; ii < nkeys; ++ii) {
       const char *keystr = astp->sortKeys[ii];
@@ -975,14 +1159,33 @@ static ResultProcessor *getArrangeRP(AREQ *req, AGGPlan *pln, const PLN_BaseStep
             buf[keystrlen] = '\0';
             const FieldSpec *vecField = IndexSpec_GetField(spec, buf, strlen(buf));
             if (vecField && vecField->types == INDEXFLD_T_VECTOR) {
-              strcpy(buf + keystrlen, "_score");
-              buf[keystrlen + _SCORE_LEN] = '\0';
-              sortkeys[ii] = RLookup_GetKey(lk, keystr, RLOOKUP_F_OCREAT);
               sortbyType = SORTBY_DISTANCE;
+              distanceField = vecField;
               // astp->sortAscMap = 0; // forcing ascending sort on vector distance
+              if (hasBatchVectorQuery(req, buf)) {
+                // group the results by query vector first, in the order of the batch
+                if (astp->afterValues) {
+                  QueryError_SetError(status, QUERY_EPARSEARGS,
+                                      "SEARCHAFTER is not supported by batch vector queries");
+                  return NULL;
+                }
+                strcpy(buf + keystrlen, "_query");
+                sortkeys[0] = RLookup_GetKey(lk, buf, RLOOKUP_F_OCREAT | RLOOKUP_F_NAMEALLOC);
+                sortkeys[1] = RLookup_GetKey(lk, keystr, RLOOKUP_F_OCREAT);
+                ascMap = (ascMap << 1) | 1;
+                nkeys = 2;
+                break;
+              } else {
+                sortkeys[ii] = RLookup_GetKey(lk, keystr, RLOOKUP_F_OCREAT);
+              }
             }
           }
         }
+        if (!sortkeys[ii] && nkeys == 1 && spec &&
+            (distanceField = geoDistanceField(spec, keystr))) {
+          sortbyType = SORTBY_DISTANCE;
+          sortkeys[ii] = RLookup_GetKey(lk, keystr, RLOOKUP_F_OCREAT);
+        }
         if (!sortkeys[ii]) {
           QueryError_SetErrorFmt(status, QUERY_ENOPROPKEY, "Property `%s` not loaded nor in schema",
                                  keystr);
@@ -991,7 +1194,10 @@ static ResultProcessor *getArrangeRP(AREQ *req, AGGPlan *pln, const PLN_BaseStep
       }
     }
 
-    rp = RPSorter_NewByFields(limit, sortkeys, nkeys, astp->sortAscMap, sortbyType);
+    rp = RPSorter_NewByFields(limit, sortkeys, nkeys, ascMap, sortbyType);
+    if (distanceField) {
+      RPSorter_SetDistanceField(rp, distanceField->index);
+    }
     up = pushRP(req, rp, up);
   }
 
@@ -1001,6 +1207,10 @@ static ResultProcessor *getArrangeRP(AREQ *req, AGGPlan *pln, const PLN_BaseStep
     up = pushRP(req, rp, up);
   }
 
+  if (rp && astp->afterValues && setSearchAfter(req, astp, rp, status) != REDISMODULE_OK) {
+    return NULL;
+  }
+
   if (astp->offset || (astp->limit && !rp)) {
     rp = RPPager_New(astp->offset, astp->limit);
     up = pushRP(req, rp, up);
@@ -1065,6 +1275,10 @@ static void buildImplicitPipeline(AREQ *req, QueryError *Status) {
   ResultProcessor *rp = RPIndexIterator_New(req->rootiter, req->timeoutTime);
   ResultProcessor *rpUpstream = NULL;
   req->qiter.rootProc = req->qiter.endProc = rp;
+  if (IsSearch(req) && IsCount(req) && !IsProfile(req)) {
+    // Only the total is returned, the matches are counted without building results
+    RPIndexIterator_SetCountOnly(rp);
+  }
   PUSH_RP();
 
   /** Create a scorer if:
@@ -1,4 +1,5 @@
 #include "expression.h"
+#include "exprvm.h"
 #include "result_processor.h"
 #include "rlookup.h"
 #include "profile.h"
@@ -399,6 +400,8 @@ typedef struct RPEvaluator RPEvaluator;
 struct RPEvaluator {
   ResultProcessor base;
   ExprEval eval;
+  // compiled form of eval.root, if it is in the subset the VM supports
+  ExprProgram *prog;
   RSValue *val;
   const RLookupKey *outkey;
   int isFilter;
@@ -423,6 +426,12 @@ static int rpevalCommon(RPEvaluator *pc, SearchResult *r) {
     pc->val = RS_NewValue(RSValue_Undef);
   }
 
+  double d;
+  if (pc->prog && ExprProgram_Run(pc->prog, &r->rowdata, &d)) {
+    RSValue_SetNumber(pc->val, d);
+    return RS_RESULT_OK;
+  }
+
   rc = ExprEval_Eval(&pc->eval, pc->val);
   if (rc != EXPR_EVAL_OK) {
     return RS_RESULT_ERROR;
@@ -465,6 +474,9 @@ static void rpevalFree(ResultProcessor *rp) {
   if (ee->val) {
     RSValue_Decref(ee->val);
   }
+  if (ee->prog) {
+    ExprProgram_Free(ee->prog);
+  }
   BlkAlloc_FreeAll(&ee->eval.stralloc, NULL, NULL, 0);
   rm_free(ee);
 }
@@ -476,6 +488,7 @@ static ResultProcessor *RPEvaluator_NewCommon(const RSExpr *ast, const RLookup *
   rp->base.type = isFilter ? RP_FILTER : RP_PROJECTOR;
   rp->eval.lookup = lookup;
   rp->eval.root = ast;
+  rp->prog = ExprProgram_Compile(ast);
   rp->outkey = dstkey;
   BlkAlloc_Init(&rp->eval.stralloc);
   return &rp->base;
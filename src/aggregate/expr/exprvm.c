@@ -0,0 +1,203 @@
+#include "exprvm.h"
+#include "rlookup.h"
+#include "util/arr.h"
+#include "rmalloc.h"
+#include <math.h>
+#include <sys/param.h>
+
+typedef enum {
+  // push a numeric literal
+  EXPRVM_PUSH,
+  // push a property which must hold a number
+  EXPRVM_LOAD_NUMBER,
+  // push a property converted to a number, as arithmetic operators do
+  EXPRVM_LOAD_TONUMBER,
+  // pop two operands, push the arithmetic result
+  EXPRVM_ARITH,
+  // pop two operands, push the result of a comparison or a logical operator
+  EXPRVM_PRED,
+  // pop an operand, push its logical negation
+  EXPRVM_NOT,
+} ExprVMOpcode;
+
+typedef struct {
+  ExprVMOpcode code;
+  union {
+    double num;
+    const RLookupKey *key;
+    unsigned char op;
+    RSCondition cond;
+  };
+} ExprVMInstr;
+
+struct ExprProgram {
+  ExprVMInstr *code;
+  double *stack;
+  size_t maxDepth;
+};
+
+/* Append the code of `e` to the program. `numeric` is set when the value is consumed by an
+ * arithmetic operator, which converts strings to numbers. Returns the stack depth needed to
+ * evaluate `e`, or 0 if it cannot be compiled */
+static size_t compileExpr(ExprProgram *prog, const RSExpr *e, int numeric) {
+  ExprVMInstr in = {0};
+  size_t l, r;
+  switch (e->t) {
+    case RSExpr_Literal:
+      if (e->literal.t != RSValue_Number) {
+        return 0;
+      }
+      in.code = EXPRVM_PUSH;
+      in.num = e->literal.numval;
+      prog->code = array_append(prog->code, in);
+      return 1;
+
+    case RSExpr_Property:
+      if (!e->property.lookupObj) {
+        return 0;
+      }
+      in.code = numeric ? EXPRVM_LOAD_TONUMBER : EXPRVM_LOAD_NUMBER;
+      in.key = e->property.lookupObj;
+      prog->code = array_append(prog->code, in);
+      return 1;
+
+    case RSExpr_Op:
+      if (!(l = compileExpr(prog, e->op.left, 1)) || !(r = compileExpr(prog, e->op.right, 1))) {
+        return 0;
+      }
+      in.code = EXPRVM_ARITH;
+      in.op = e->op.op;
+      prog->code = array_append(prog->code, in);
+      return MAX(l, r + 1);
+
+    case RSExpr_Predicate:
+      if (!(l = compileExpr(prog, e->pred.left, 0)) ||
+          !(r = compileExpr(prog, e->pred.right, 0))) {
+        return 0;
+      }
+      in.code = EXPRVM_PRED;
+      in.cond = e->pred.cond;
+      prog->code = array_append(prog->code, in);
+      return MAX(l, r + 1);
+
+    case RSExpr_Inverted:
+      if (!(l = compileExpr(prog, e->inverted.child, 0))) {
+        return 0;
+      }
+      in.code = EXPRVM_NOT;
+      prog->code = array_append(prog->code, in);
+      return l;
+
+    default:
+      return 0;
+  }
+}
+
+ExprProgram *ExprProgram_Compile(const RSExpr *root) {
+  // A bare literal or property evaluates to a reference, there is nothing to gain
+  if (root->t != RSExpr_Op && root->t != RSExpr_Predicate && root->t != RSExpr_Inverted) {
+    return NULL;
+  }
+  ExprProgram *prog = rm_calloc(1, sizeof(*prog));
+  prog->code = array_new(ExprVMInstr, 8);
+  prog->maxDepth = compileExpr(prog, root, 0);
+  if (!prog->maxDepth) {
+    ExprProgram_Free(prog);
+    return NULL;
+  }
+  prog->stack = rm_malloc(prog->maxDepth * sizeof(*prog->stack));
+  return prog;
+}
+
+void ExprProgram_Free(ExprProgram *prog) {
+  array_free(prog->code);
+  rm_free(prog->stack);
+  rm_free(prog);
+}
+
+/* Same semantics as the interpreter's evalOp() */
+static inline double runArith(unsigned char op, double n1, double n2) {
+  switch (op) {
+    case '+':
+      return n1 + n2;
+    case '/':
+      return n1 / n2;
+    case '-':
+      return n1 - n2;
+    case '*':
+      return n1 * n2;
+    case '%':
+      return (long long)n1 % (long long)n2;
+    case '^':
+      return pow(n1, n2);
+    default:
+      return NAN;
+  }
+}
+
+/* Same semantics as getPredicateBoolean() on two numbers */
+static inline double runPred(RSCondition cond, double n1, double n2) {
+  int cmp = n1 > n2 ? 1 : (n1 < n2 ? -1 : 0);
+  switch (cond) {
+    case RSCondition_Eq:
+      return cmp == 0;
+    case RSCondition_Lt:
+      return cmp < 0;
+    case RSCondition_Le:
+      return cmp <= 0;
+    case RSCondition_Gt:
+      return cmp > 0;
+    case RSCondition_Ge:
+      return cmp >= 0;
+    case RSCondition_Ne:
+      return cmp != 0;
+    case RSCondition_And:
+      return n1 != 0 && n2 != 0;
+    case RSCondition_Or:
+      return n1 != 0 || n2 != 0;
+    default:
+      return 0;
+  }
+}
+
+int ExprProgram_Run(ExprProgram *prog, const RLookupRow *row, double *result) {
+  double *sp = prog->stack;
+  const ExprVMInstr *code = prog->code;
+  for (uint32_t ii = 0; ii < array_len(prog->code); ++ii) {
+    const ExprVMInstr *in = code + ii;
+    switch (in->code) {
+      case EXPRVM_PUSH:
+        *sp++ = in->num;
+        break;
+      case EXPRVM_LOAD_NUMBER: {
+        RSValue *v = RLookup_GetItem(in->key, row);
+        if (!v || (v = RSValue_Dereference(v))->t != RSValue_Number) {
+          return 0;
+        }
+        *sp++ = v->numval;
+        break;
+      }
+      case EXPRVM_LOAD_TONUMBER: {
+        RSValue *v = RLookup_GetItem(in->key, row);
+        if (!v || !RSValue_ToNumber(v, sp)) {
+          return 0;
+        }
+        sp++;
+        break;
+      }
+      case EXPRVM_ARITH:
+        --sp;
+        sp[-1] = runArith(in->op, sp[-1], sp[0]);
+        break;
+      case EXPRVM_PRED:
+        --sp;
+        sp[-1] = runPred(in->cond, sp[-1], sp[0]);
+        break;
+      case EXPRVM_NOT:
+        sp[-1] = sp[-1] == 0;
+        break;
+    }
+  }
+  *result = prog->stack[0];
+  return 1;
+}
@@ -0,0 +1,40 @@
+#ifndef RS_AGG_EXPRVM_H_
+#define RS_AGG_EXPRVM_H_
+
+#include "expression.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A compiled form of the numeric subset of the expression language: arithmetic, comparisons,
+ * logical operators and negation over numeric literals and properties. The expression is flattened
+ * into a postfix program which runs over a stack of plain doubles, so evaluating a row does not
+ * create or refcount any RSValue.
+ *
+ * Expressions using strings, NULL or functions are not compiled and keep using ExprEval_Eval().
+ * A compiled program may still meet a row it cannot handle (a missing property, or a non numeric
+ * value used in a comparison); it then reports it and the caller falls back to the interpreter for
+ * that row, so results and errors are always the interpreter's.
+ */
+typedef struct ExprProgram ExprProgram;
+
+/**
+ * Compile an expression whose lookup keys were already bound with ExprAST_GetLookupKeys().
+ * Returns NULL if the expression is outside of the supported subset.
+ */
+ExprProgram *ExprProgram_Compile(const RSExpr *root);
+
+/**
+ * Run the program on a row. Returns 1 and sets `result` on success, or 0 if the row must be
+ * evaluated by the interpreter.
+ */
+int ExprProgram_Run(ExprProgram *prog, const RLookupRow *row, double *result);
+
+void ExprProgram_Free(ExprProgram *prog);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
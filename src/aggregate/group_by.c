@@ -1,8 +1,11 @@
 #include <redisearch.h>
 #include <result_processor.h>
 #include <util/block_alloc.h>
-#include <util/khash.h>
+#include <pthread.h>
 #include "reducer.h"
+#include "config.h"
+#include "thpool/thpool.h"
+#include "util/minmax_heap.h"
 
 /**
  * A group represents the allocated context of all reducers in a group, and the
@@ -15,39 +18,112 @@ typedef struct {
   /** Contains the selected 'out' values used by the reducers output functions */
   RLookupRow rowdata;
 
+  /**
+   * Set on groups created by a worker thread during a parallel batch, until the
+   * main thread writes the key values into `rowdata`. See grouperRunBatch()
+   */
+  const RSValue **pendingKey;
+
   /**
    * Contains the actual per-reducer data for the group, in an accumulating
    * fashion (e.g. how many records seen, and so on). This is created by
-   * Reducer::NewInstance()
+   * Reducer::NewInstance(), or points into the inline state which follows the
+   * array for reducers implementing Reducer::InitInstance()
    */
   void *accumdata[0];
 } Group;
 
-#define kh_set(kname, hash, key, val)   \
-  ({                                    \
-    int ret;                            \
-    k = kh_put(kname, hash, key, &ret); \
-    kh_value(hash, k) = val;            \
-    ret;                                \
-  })
+/**
+ * A slot of the groups table. The hash is kept next to the pointer so that
+ * probing only touches the groups whose hash matches.
+ */
+typedef struct {
+  uint64_t hash;
+  Group *group;
+} GroupSlot;
+
+/**
+ * A group key found in a row of a parallel batch. The key values are stored in
+ * the batch's `keys` array, starting at keyOffset.
+ */
+typedef struct {
+  uint64_t hval;
+  size_t keyOffset;
+  RLookupRow *row;
+} GroupEntry;
+
+/**
+ * Open addressing (linear probing) table of group key hash => `Group`. The
+ * capacity is a power of 2, and it is kept at most 3/4 full.
+ *
+ * When aggregating in parallel, every worker thread owns a table holding the
+ * groups whose hash falls in its partition.
+ */
+typedef struct {
+  GroupSlot *slots;
+  size_t cap;
+  size_t numGroups;
+
+  // Backing store for the groups themselves
+  BlkAlloc groupsAlloc;
 
-static const int khid = 33;
-KHASH_MAP_INIT_INT64(khid, Group *);
+  // The entries of the current batch in this partition, and the groups they created
+  GroupEntry *entries;
+  Group **pending;
+} GroupsTable;
 
 #define GROUPER_NREDUCERS(g) (array_len((g)->reducers))
-#define GROUP_BYTESIZE(parent) (sizeof(Group) + (sizeof(void *) * GROUPER_NREDUCERS(parent)))
+#define GROUP_INLINE_ALIGN(sz) (((sz) + 7) & ~(size_t)7)
+#define GROUP_BYTESIZE(parent) \
+  (sizeof(Group) + (sizeof(void *) * GROUPER_NREDUCERS(parent)) + (parent)->inlineSize)
 #define GROUPS_PER_BLOCK 1024
+#define GROUPS_INITIAL_CAP 64
 #define GROUPER_NSRCKEYS(g) ((g)->nkeys)
+// Number of upstream rows accumulated before they are handed to the worker threads
+#define GROUPER_BATCH_SIZE 1024
+
+/**
+ * A group selected by a top-k GROUPBY, with its value of the sort key. The
+ * entry owns a reference to the value until the group is yielded.
+ */
+typedef struct {
+  Group *group;
+  RSValue *sortval;
+} GroupTopEntry;
+
+typedef struct Grouper Grouper;
+
+typedef struct {
+  Grouper *parent;
+  GroupsTable *table;
+} GroupWorker;
+
+/**
+ * Rows pulled from upstream and waiting to be aggregated by the worker threads.
+ * The rows are kept alive until the batch is done, since the entries point
+ * into them.
+ */
+typedef struct {
+  SearchResult *rows;
+  size_t nrows;
+  const RSValue **keys;
+
+  GroupWorker *workers;
+  size_t remaining;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+} GroupBatch;
 
-typedef struct Grouper {
+struct Grouper {
   // Result processor base, for use in row processing
   ResultProcessor base;
 
-  // Map of group_name => `Group` structure
-  khash_t(khid) * groups;
+  // The groups, partitioned by hash. Created when the first row arrives
+  GroupsTable *tables;
+  size_t ntables;
 
-  // Backing store for the groups themselves
-  BlkAlloc groupsAlloc;
+  // Only used when aggregating in parallel, i.e. ntables > 1
+  GroupBatch batch;
 
   /**
    * Keys to group by. Both srckeys and dstkeys are used because different lookups
@@ -62,34 +138,72 @@ typedef struct Grouper {
   // array of reducers
   Reducer **reducers;
 
+  // Total size of the reducer states stored inline in each group
+  size_t inlineSize;
+
+  /**
+   * When the GROUPBY is followed by a bounded SORTBY on one of its outputs, only
+   * the first `topk` groups by that output are yielded. See Grouper_SetTopK()
+   */
+  struct {
+    size_t k;
+    // Index of the sorting reducer, or -1 when sorting by a group key
+    int reducer;
+    const RLookupKey *key;
+    int ascending;
+    // The selected groups, set once accumulation is done
+    GroupTopEntry *entries;
+    size_t n;
+  } topk;
+
   // Used for maintaining state when yielding groups
-  khiter_t iter;
-} Grouper;
+  size_t iterTable;
+  size_t iter;
+};
+
+// Shared by all the parallel GROUPBY steps, created on first use
+static threadpool groupbyPool_g = NULL;
+
+static void writeGroupKey(Grouper *g, Group *group, const RSValue **groupvals, size_t ngrpvals) {
+  for (size_t ii = 0; ii < ngrpvals; ++ii) {
+    const RLookupKey *dstkey = g->dstkeys[ii];
+    RLookup_WriteKey(dstkey, &group->rowdata, (RSValue *)groupvals[ii]);
+  }
+}
 
 /**
  * Create a new group. groupvals is the key of the group. This will be the
  * number of field arguments passed to GROUPBY, e.g.
  * GROUPBY 2 @foo @bar will have a `groupvals` of `{"foo", "bar"}`.
  *
- * These will be placed in the output row.
+ * These will be placed in the output row. If `deferKey` is set, as it is on
+ * worker threads, the values are only referenced until the end of the batch.
  */
-static Group *createGroup(Grouper *g, const RSValue **groupvals, size_t ngrpvals) {
+static Group *createGroup(Grouper *g, GroupsTable *t, const RSValue **groupvals,
+                          size_t ngrpvals, int deferKey) {
   size_t numReducers = array_len(g->reducers);
   size_t elemSize = GROUP_BYTESIZE(g);
-  Group *group = BlkAlloc_Alloc(&g->groupsAlloc, elemSize, GROUPS_PER_BLOCK * elemSize);
+  Group *group = BlkAlloc_Alloc(&t->groupsAlloc, elemSize, GROUPS_PER_BLOCK * elemSize);
   memset(group, 0, elemSize);
 
+  char *inlineState = (char *)(group->accumdata + numReducers);
   for (size_t ii = 0; ii < numReducers; ++ii) {
-    group->accumdata[ii] = g->reducers[ii]->NewInstance(g->reducers[ii]);
+    Reducer *rd = g->reducers[ii];
+    if (rd->InitInstance) {
+      rd->InitInstance(rd, inlineState);
+      group->accumdata[ii] = inlineState;
+      inlineState += GROUP_INLINE_ALIGN(rd->instanceSize);
+    } else {
+      group->accumdata[ii] = rd->NewInstance(rd);
+    }
   }
 
   /** Initialize the row data! */
-  for (size_t ii = 0; ii < ngrpvals; ++ii) {
-    const RLookupKey *dstkey = g->dstkeys[ii];
-    RLookup_WriteKey(dstkey, &group->rowdata, (RSValue *)groupvals[ii]);
-    // printf("Write: %s => ", dstkey->name);
-    // RSValue_Print(groupvals[ii]);
-    // printf("\n");
+  if (deferKey) {
+    group->pendingKey = groupvals;
+    t->pending = array_append(t->pending, group);
+  } else {
+    writeGroupKey(g, group, groupvals, ngrpvals);
   }
   return group;
 }
@@ -104,41 +218,179 @@ static void writeGroupValues(const Grouper *g, const Group *gr, SearchResult *r)
   }
 }
 
-static int Grouper_rpYield(ResultProcessor *base, SearchResult *r) {
-  Grouper *g = (Grouper *)base;
+/* Whether the group's key is the same as the values in xarr */
+static int groupKeyEquals(const Grouper *g, const Group *gr, const RSValue **xarr, size_t xlen) {
+  for (size_t ii = 0; ii < xlen; ++ii) {
+    const RSValue *v =
+        gr->pendingKey ? gr->pendingKey[ii] : RLookup_GetItem(g->dstkeys[ii], &gr->rowdata);
+    if (!v || !RSValue_Equal(RSValue_Dereference(xarr[ii]), RSValue_Dereference(v), NULL)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void growGroupsTable(GroupsTable *t) {
+  size_t oldcap = t->cap;
+  GroupSlot *oldslots = t->slots;
+  t->cap = oldcap ? oldcap * 2 : GROUPS_INITIAL_CAP;
+  t->slots = rm_calloc(t->cap, sizeof(*t->slots));
 
-  while (g->iter != kh_end(g->groups)) {
-    if (!kh_exist(g->groups, g->iter)) {
-      g->iter++;
+  size_t mask = t->cap - 1;
+  for (size_t ii = 0; ii < oldcap; ++ii) {
+    if (!oldslots[ii].group) {
       continue;
     }
+    size_t pos = oldslots[ii].hash & mask;
+    while (t->slots[pos].group) {
+      pos = (pos + 1) & mask;
+    }
+    t->slots[pos] = oldslots[ii];
+  }
+  rm_free(oldslots);
+}
+
+/* Get the group whose key is xarr, creating it if needed */
+static Group *getGroup(Grouper *g, GroupsTable *t, const RSValue **xarr, size_t xlen,
+                       uint64_t hval, int deferKey) {
+  if ((t->numGroups + 1) * 4 > t->cap * 3) {
+    growGroupsTable(t);
+  }
+  size_t mask = t->cap - 1;
+  for (size_t pos = hval & mask;; pos = (pos + 1) & mask) {
+    GroupSlot *slot = t->slots + pos;
+    if (!slot->group) {
+      slot->hash = hval;
+      slot->group = createGroup(g, t, xarr, xlen, deferKey);
+      t->numGroups++;
+      return slot->group;
+    }
+    // different keys may share a hash, these are different groups
+    if (slot->hash == hval && groupKeyEquals(g, slot->group, xarr, xlen)) {
+      return slot->group;
+    }
+  }
+}
 
-    Group *gr = kh_value(g->groups, g->iter);
-    // no reducers; just a terminal GROUPBY...
+/* Write the group's output row. `sortval` is the group's already finalized
+ * value of the top-k sorting reducer, if any */
+static void yieldGroup(Grouper *g, Group *gr, SearchResult *r, RSValue *sortval) {
+  // no reducers; just a terminal GROUPBY...
 
-    if (!GROUPER_NREDUCERS(g)) {
+  if (!GROUPER_NREDUCERS(g)) {
+    writeGroupValues(g, gr, r);
+  }
+  // else...
+  for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+    Reducer *rd = g->reducers[ii];
+    RSValue *v = sortval && (int)ii == g->topk.reducer ? sortval
+                                                        : rd->Finalize(rd, gr->accumdata[ii]);
+    if (v) {
+      RLookup_WriteOwnKey(rd->dstkey, &r->rowdata, v);
       writeGroupValues(g, gr, r);
+    } else {
+      // FIXME!
+      // Error! Couldn't get value? Handle me here!
+      // printf("Finalize() returned bad value!\n");
     }
-    // else...
-    for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
-      Reducer *rd = g->reducers[ii];
-      RSValue *v = rd->Finalize(rd, gr->accumdata[ii]);
-      if (v) {
-        RLookup_WriteOwnKey(rd->dstkey, &r->rowdata, v);
-        writeGroupValues(g, gr, r);
-      } else {
-        // FIXME!
-        // Error! Couldn't get value? Handle me here!
-        // printf("Finalize() returned bad value!\n");
+  }
+}
+
+static int Grouper_rpYield(ResultProcessor *base, SearchResult *r) {
+  Grouper *g = (Grouper *)base;
+
+  for (; g->iterTable < g->ntables; g->iterTable++, g->iter = 0) {
+    GroupsTable *t = g->tables + g->iterTable;
+    while (g->iter < t->cap) {
+      Group *gr = t->slots[g->iter].group;
+      ++g->iter;
+      if (gr) {
+        yieldGroup(g, gr, r, NULL);
+        return RS_RESULT_OK;
       }
     }
-    ++g->iter;
-    return RS_RESULT_OK;
   }
 
   return RS_RESULT_EOF;
 }
 
+static int Grouper_rpYieldTopK(ResultProcessor *base, SearchResult *r) {
+  Grouper *g = (Grouper *)base;
+  if (g->iter == g->topk.n) {
+    return RS_RESULT_EOF;
+  }
+
+  GroupTopEntry *e = g->topk.entries + g->iter++;
+  RSValue *sortval = e->sortval;
+  e->sortval = NULL;
+  if (g->topk.reducer < 0) {
+    // the value is already in the group's row
+    RSValue_Decref(sortval);
+    sortval = NULL;
+  }
+  yieldGroup(g, e->group, r, sortval);
+  return RS_RESULT_OK;
+}
+
+/* Same order as the sorter's, see cmpByFields() */
+static int cmpTopEntries(const void *e1, const void *e2, const void *udata) {
+  const Grouper *g = udata;
+  const RSValue *v1 = ((const GroupTopEntry *)e1)->sortval;
+  const RSValue *v2 = ((const GroupTopEntry *)e2)->sortval;
+  int rc;
+  if (!v1 || !v2) {
+    rc = v1 ? 1 : (v2 ? -1 : 0);
+  } else {
+    rc = RSValue_Cmp(v1, v2, NULL);
+  }
+  return g->topk.ascending ? -rc : rc;
+}
+
+/**
+ * Select the top-k groups by the sort key with a bounded heap, so that only the
+ * sort key is computed for the groups which are not yielded
+ */
+static void selectTopGroups(Grouper *g) {
+  size_t k = g->topk.k;
+  g->topk.entries = rm_calloc(k, sizeof(*g->topk.entries));
+  heap_t *pq = mmh_init_with_size(k + 1, cmpTopEntries, g, NULL);
+  GroupTopEntry cur;
+
+  for (size_t ii = 0; ii < g->ntables; ++ii) {
+    GroupsTable *t = g->tables + ii;
+    for (size_t jj = 0; jj < t->cap; ++jj) {
+      if (!(cur.group = t->slots[jj].group)) {
+        continue;
+      }
+      if (g->topk.reducer >= 0) {
+        Reducer *rd = g->reducers[g->topk.reducer];
+        cur.sortval = rd->Finalize(rd, cur.group->accumdata[g->topk.reducer]);
+      } else {
+        cur.sortval = RLookup_GetItem(g->topk.key, &cur.group->rowdata);
+        if (cur.sortval) {
+          RSValue_IncrRef(cur.sortval);
+        }
+      }
+
+      if (g->topk.n < k) {
+        GroupTopEntry *e = g->topk.entries + g->topk.n++;
+        *e = cur;
+        mmh_insert(pq, e);
+      } else if (cmpTopEntries(&cur, mmh_peek_min(pq), g) > 0) {
+        GroupTopEntry *e = mmh_pop_min(pq);
+        if (e->sortval) {
+          RSValue_Decref(e->sortval);
+        }
+        *e = cur;
+        mmh_insert(pq, e);
+      } else if (cur.sortval) {
+        RSValue_Decref(cur.sortval);
+      }
+    }
+  }
+  mmh_free(pq);
+}
+
 static void invokeReducers(Grouper *g, Group *gr, RLookupRow *srcrow) {
   size_t nreducers = GROUPER_NREDUCERS(g);
   for (size_t ii = 0; ii < nreducers; ii++) {
@@ -146,6 +398,18 @@ static void invokeReducers(Grouper *g, Group *gr, RLookupRow *srcrow) {
   }
 }
 
+/* In parallel mode, queue the group key for the worker owning its partition */
+static void addBatchEntry(Grouper *g, const RSValue **xarr, size_t xlen, uint64_t hval,
+                          RLookupRow *res) {
+  GroupBatch *b = &g->batch;
+  GroupEntry e = {.hval = hval, .keyOffset = array_len(b->keys), .row = res};
+  for (size_t ii = 0; ii < xlen; ++ii) {
+    b->keys = array_append(b->keys, xarr[ii]);
+  }
+  GroupsTable *t = g->tables + (hval >> 32) % g->ntables;
+  t->entries = array_append(t->entries, e);
+}
+
 /**
  * This function recursively descends into each value within a group and invokes
  * Add() for each cartesian product of the current row.
@@ -166,16 +430,13 @@ static void extractGroups(Grouper *g, const RSValue **xarr, size_t xpos, size_t
                           uint64_t hval, RLookupRow *res) {
   // end of the line - create/add to group
   if (xpos == xlen) {
-    Group *group = NULL;
+    if (g->ntables > 1) {
+      addBatchEntry(g, xarr, xlen, hval, res);
+      return;
+    }
 
     // Get or create the group
-    khiter_t k = kh_get(khid, g->groups, hval);  // first have to get ieter
-    if (k == kh_end(g->groups)) {                // k will be equal to kh_end if key not present
-      group = createGroup(g, xarr, xlen);
-      kh_set(khid, g->groups, hval, group);
-    } else {
-      group = kh_value(g->groups, k);
-    }
+    Group *group = getGroup(g, g->tables, xarr, xlen, hval, 0);
 
     // send the result to the group and its reducers
     invokeReducers(g, group, res);
@@ -231,20 +492,147 @@ static void invokeGroupReducers(Grouper *g, RLookupRow *srcrow) {
   extractGroups(g, groupvals, 0, nkeys, 0, 0, srcrow);
 }
 
+/**
+ * Worker thread job: aggregate the batch entries of one partition. Workers only
+ * read the rows; anything touching value refcounts is left to the main thread
+ */
+static void grouperWorker(void *p) {
+  GroupWorker *w = p;
+  Grouper *g = w->parent;
+  GroupsTable *t = w->table;
+  for (uint32_t ii = 0; ii < array_len(t->entries); ++ii) {
+    GroupEntry *e = t->entries + ii;
+    Group *group = getGroup(g, t, g->batch.keys + e->keyOffset, g->nkeys, e->hval, 1);
+    invokeReducers(g, group, e->row);
+  }
+
+  pthread_mutex_lock(&g->batch.lock);
+  if (--g->batch.remaining == 0) {
+    pthread_cond_signal(&g->batch.cond);
+  }
+  pthread_mutex_unlock(&g->batch.lock);
+}
+
+/* Aggregate the rows of the current batch on the worker threads, and release them */
+static void grouperRunBatch(Grouper *g) {
+  GroupBatch *b = &g->batch;
+  if (!b->nrows) {
+    return;
+  }
+
+  pthread_mutex_lock(&b->lock);
+  for (size_t ii = 0; ii < g->ntables; ++ii) {
+    if (array_len(g->tables[ii].entries)) {
+      b->remaining++;
+      thpool_add_work(groupbyPool_g, grouperWorker, b->workers + ii);
+    }
+  }
+  while (b->remaining) {
+    pthread_cond_wait(&b->cond, &b->lock);
+  }
+  pthread_mutex_unlock(&b->lock);
+
+  // Now that the workers are done, write the keys of the new groups while their values are alive
+  for (size_t ii = 0; ii < g->ntables; ++ii) {
+    GroupsTable *t = g->tables + ii;
+    for (uint32_t jj = 0; jj < array_len(t->pending); ++jj) {
+      Group *group = t->pending[jj];
+      writeGroupKey(g, group, group->pendingKey, g->nkeys);
+      group->pendingKey = NULL;
+    }
+    array_clear(t->pending);
+    array_clear(t->entries);
+  }
+  array_clear(b->keys);
+  for (size_t ii = 0; ii < b->nrows; ++ii) {
+    SearchResult_Clear(b->rows + ii);
+  }
+  b->nrows = 0;
+}
+
+/**
+ * Decide how to aggregate. Groups are partitioned across worker threads only if
+ * every reducer keeps an inline state, as those only read the rows they are
+ * given, which makes them safe to run concurrently
+ */
+static void grouperInitTables(Grouper *g) {
+  int parallel = RSGlobalConfig.groupbyThreads > 1;
+  for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+    if (!g->reducers[ii]->InitInstance) {
+      parallel = 0;
+    }
+  }
+
+  g->ntables = parallel ? RSGlobalConfig.groupbyThreads : 1;
+  g->tables = rm_calloc(g->ntables, sizeof(*g->tables));
+  for (size_t ii = 0; ii < g->ntables; ++ii) {
+    BlkAlloc_Init(&g->tables[ii].groupsAlloc);
+  }
+  if (!parallel) {
+    return;
+  }
+
+  if (!groupbyPool_g) {
+    groupbyPool_g = thpool_init(RSGlobalConfig.groupbyThreads);
+  }
+  GroupBatch *b = &g->batch;
+  b->rows = rm_calloc(GROUPER_BATCH_SIZE, sizeof(*b->rows));
+  b->keys = array_new(const RSValue *, GROUPER_BATCH_SIZE * g->nkeys);
+  b->workers = rm_calloc(g->ntables, sizeof(*b->workers));
+  for (size_t ii = 0; ii < g->ntables; ++ii) {
+    b->workers[ii].parent = g;
+    b->workers[ii].table = g->tables + ii;
+    g->tables[ii].entries = array_new(GroupEntry, GROUPER_BATCH_SIZE / g->ntables + 1);
+    g->tables[ii].pending = array_new(Group *, 16);
+  }
+  pthread_mutex_init(&b->lock, NULL);
+  pthread_cond_init(&b->cond, NULL);
+}
+
+static int grouperAccumParallel(Grouper *g) {
+  ResultProcessor *upstream = g->base.upstream;
+  GroupBatch *b = &g->batch;
+  int rc = RS_RESULT_OK;
+  while (rc == RS_RESULT_OK) {
+    while (b->nrows < GROUPER_BATCH_SIZE &&
+           (rc = upstream->Next(upstream, b->rows + b->nrows)) == RS_RESULT_OK) {
+      invokeGroupReducers(g, &b->rows[b->nrows++].rowdata);
+    }
+    grouperRunBatch(g);
+  }
+  return rc;
+}
+
 static int Grouper_rpAccum(ResultProcessor *base, SearchResult *res) {
   Grouper *g = (Grouper *)base;
 
   int rc;
 
-  while ((rc = base->upstream->Next(base->upstream, res)) == RS_RESULT_OK) {
-    invokeGroupReducers(g, &res->rowdata);
-    SearchResult_Clear(res);
+  if (!g->tables) {
+    grouperInitTables(g);
+  }
+  if (g->ntables > 1) {
+    rc = grouperAccumParallel(g);
+  } else {
+    while ((rc = base->upstream->Next(base->upstream, res)) == RS_RESULT_OK) {
+      invokeGroupReducers(g, &res->rowdata);
+      SearchResult_Clear(res);
+    }
   }
   if (rc == RS_RESULT_EOF) {
-    base->Next = Grouper_rpYield;
-    base->parent->totalResults = kh_size(g->groups);
-    g->iter = kh_begin(khid);
-    return Grouper_rpYield(base, res);
+    base->parent->totalResults = 0;
+    for (size_t ii = 0; ii < g->ntables; ++ii) {
+      base->parent->totalResults += g->tables[ii].numGroups;
+    }
+    g->iterTable = 0;
+    g->iter = 0;
+    if (g->topk.k) {
+      selectTopGroups(g);
+      base->Next = Grouper_rpYieldTopK;
+    } else {
+      base->Next = Grouper_rpYield;
+    }
+    return base->Next(base, res);
   } else {
     return rc;
   }
@@ -264,15 +652,42 @@ static void cleanCallback(void *ptr, void *arg) {
 
 static void Grouper_rpFree(ResultProcessor *grrp) {
   Grouper *g = (Grouper *)grrp;
-  for (khiter_t it = kh_begin(g->groups); it != kh_end(g->groups); ++it) {
-    if (!kh_exist(g->groups, it)) {
-      continue;
+  for (size_t ii = 0; ii < g->topk.n; ++ii) {
+    if (g->topk.entries[ii].sortval) {
+      RSValue_Decref(g->topk.entries[ii].sortval);
+    }
+  }
+  rm_free(g->topk.entries);
+
+  for (size_t ii = 0; ii < g->ntables; ++ii) {
+    GroupsTable *t = g->tables + ii;
+    for (size_t jj = 0; jj < t->cap; ++jj) {
+      if (t->slots[jj].group) {
+        RLookupRow_Cleanup(&t->slots[jj].group->rowdata);
+      }
+    }
+    rm_free(t->slots);
+    BlkAlloc_FreeAll(&t->groupsAlloc, cleanCallback, g, GROUP_BYTESIZE(g));
+    if (t->entries) {
+      array_free(t->entries);
+    }
+    if (t->pending) {
+      array_free(t->pending);
+    }
+  }
+  rm_free(g->tables);
+
+  GroupBatch *b = &g->batch;
+  if (b->rows) {
+    for (size_t ii = 0; ii < GROUPER_BATCH_SIZE; ++ii) {
+      SearchResult_Destroy(b->rows + ii);
     }
-    Group *gr = kh_value(g->groups, it);
-    RLookupRow_Cleanup(&gr->rowdata);
+    rm_free(b->rows);
+    array_free(b->keys);
+    rm_free(b->workers);
+    pthread_mutex_destroy(&b->lock);
+    pthread_cond_destroy(&b->cond);
   }
-  kh_destroy(khid, g->groups);
-  BlkAlloc_FreeAll(&g->groupsAlloc, cleanCallback, g, GROUP_BYTESIZE(g));
 
   for (size_t i = 0; i < GROUPER_NREDUCERS(g); i++) {
     g->reducers[i]->Free(g->reducers[i]);
@@ -291,8 +706,6 @@ void Grouper_Free(Grouper *g) {
 
 Grouper *Grouper_New(const RLookupKey **srckeys, const RLookupKey **dstkeys, size_t nkeys) {
   Grouper *g = rm_calloc(1, sizeof(*g));
-  BlkAlloc_Init(&g->groupsAlloc);
-  g->groups = kh_init(khid);
 
   g->srckeys = rm_calloc(nkeys, sizeof(*g->srckeys));
   g->dstkeys = rm_calloc(nkeys, sizeof(*g->dstkeys));
@@ -312,6 +725,32 @@ void Grouper_AddReducer(Grouper *g, Reducer *r, RLookupKey *dstkey) {
   Reducer **rpp = array_ensure_tail(&g->reducers, Reducer *);
   *rpp = r;
   r->dstkey = dstkey;
+  if (r->InitInstance) {
+    g->inlineSize += GROUP_INLINE_ALIGN(r->instanceSize);
+  }
+}
+
+int Grouper_SetTopK(Grouper *g, const RLookupKey *sortkey, int ascending, size_t k) {
+  int reducer = -1;
+  for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+    if (g->reducers[ii]->dstkey == sortkey) {
+      reducer = ii;
+    }
+  }
+  if (reducer < 0) {
+    size_t ii = 0;
+    while (ii < g->nkeys && g->dstkeys[ii] != sortkey) {
+      ++ii;
+    }
+    if (ii == g->nkeys) {
+      return 0;
+    }
+  }
+  g->topk.k = k;
+  g->topk.reducer = reducer;
+  g->topk.key = sortkey;
+  g->topk.ascending = ascending;
+  return 1;
 }
 
 ResultProcessor *Grouper_GetRP(Grouper *g) {
@@ -43,7 +43,9 @@ ReducerFactory RDCR_GetFactory(const char *name) {
   X(RDCRFirstValue_New, "FIRST_VALUE")             \
   X(RDCRRandomSample_New, "RANDOM_SAMPLE")         \
   X(RDCRHLL_New, "HLL")                            \
-  X(RDCRHLLSum_New, "HLL_SUM")
+  X(RDCRHLLSum_New, "HLL_SUM")                     \
+  X(RDCRTDigest_New, "TDIGEST")                    \
+  X(RDCRTDigestQuantile_New, "TDIGEST_QUANTILE")
 
 void RDCR_RegisterBuiltins(void) {
 #define X(fn, n) RDCR_RegisterFactory(n, fn);
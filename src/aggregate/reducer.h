@@ -57,6 +57,18 @@ typedef struct Reducer {
    */
   void *(*NewInstance)(struct Reducer *r);
 
+  /**
+   * Optional, for reducers whose per-group state has a fixed size and does not
+   * need to be freed. The grouper then reserves `instanceSize` bytes inside each
+   * group and initializes them with InitInstance() rather than calling
+   * NewInstance(), saving an allocation and a pointer chase per group.
+   *
+   * Such reducers may also be run on the GROUPBY worker threads (see
+   * GROUPBY_THREADS), so their Add() must only read the row it is given.
+   */
+  size_t instanceSize;
+  void (*InitInstance)(struct Reducer *r, void *instance);
+
   /**
    * Passes a result through the reducer. The reducer can then store the
    * results internally until it can be outputted in `dstrow`.
@@ -154,6 +166,8 @@ Reducer *RDCRFirstValue_New(const ReducerOptions *);
 Reducer *RDCRRandomSample_New(const ReducerOptions *);
 Reducer *RDCRHLL_New(const ReducerOptions *);
 Reducer *RDCRHLLSum_New(const ReducerOptions *);
+Reducer *RDCRTDigest_New(const ReducerOptions *);
+Reducer *RDCRTDigestQuantile_New(const ReducerOptions *);
 
 typedef Reducer *(*ReducerFactory)(const ReducerOptions *);
 ReducerFactory RDCR_GetFactory(const char *name);
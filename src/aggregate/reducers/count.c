@@ -7,9 +7,13 @@ typedef struct {
 
 #define COUNTER_BLOCK_SIZE 32 * sizeof(counterData)
 
+static void counterInitInstance(Reducer *r, void *instance) {
+  ((counterData *)instance)->count = 0;
+}
+
 static void *counterNewInstance(Reducer *r) {
   counterData *dd = BlkAlloc_Alloc(&r->alloc, sizeof(counterData), COUNTER_BLOCK_SIZE);
-  dd->count = 0;
+  counterInitInstance(r, dd);
   return dd;
 }
 
@@ -33,5 +37,7 @@ Reducer *RDCRCount_New(const ReducerOptions *options) {
   r->Finalize = counterFinalize;
   r->Free = Reducer_GenericFree;
   r->NewInstance = counterNewInstance;
+  r->InitInstance = counterInitInstance;
+  r->instanceSize = sizeof(counterData);
   return r;
 }
@@ -6,15 +6,25 @@
 #include "rmutil/sds.h"
 
 #define HLL_PRECISION_BITS 8
+// Precision of the HLL used by COUNT_DISTINCT once it exceeds its exact limit, ~0.8% error
+#define DISTINCT_APPROX_BITS 14
 #define INSTANCE_BLOCK_NUM 1024
 
 static const int khid = 35;
 KHASH_SET_INIT_INT64(khid);
 
+typedef struct {
+  Reducer base;
+  // Count exactly up to this many distinct values, then estimate. 0 is always exact
+  size_t maxExact;
+} distinctReducer;
+
 typedef struct {
   size_t count;
   const RLookupKey *srckey;
   khash_t(khid) * dedup;
+  // Set once the exact limit was exceeded, and then replaces dedup
+  struct HLL *hll;
 } distinctCounter;
 
 static void *distinctNewInstance(Reducer *r) {
@@ -24,9 +34,27 @@ static void *distinctNewInstance(Reducer *r) {
   ctr->count = 0;
   ctr->dedup = kh_init(khid);
   ctr->srckey = r->srckey;
+  ctr->hll = NULL;
   return ctr;
 }
 
+static inline void distinctAddHash(struct HLL *hll, uint64_t hval) {
+  hll_add_hash(hll, (uint32_t)hval ^ (uint32_t)(hval >> 32));
+}
+
+/* Move the hashes seen so far into an HLL, and estimate from now on */
+static void distinctToApprox(distinctCounter *ctr) {
+  ctr->hll = rm_malloc(sizeof(*ctr->hll));
+  hll_init(ctr->hll, DISTINCT_APPROX_BITS);
+  for (khiter_t it = kh_begin(ctr->dedup); it != kh_end(ctr->dedup); ++it) {
+    if (kh_exist(ctr->dedup, it)) {
+      distinctAddHash(ctr->hll, kh_key(ctr->dedup, it));
+    }
+  }
+  kh_destroy(khid, ctr->dedup);
+  ctr->dedup = NULL;
+}
+
 static int distinctAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   distinctCounter *ctr = ctx;
   const RSValue *val = RLookup_GetItem(ctr->srckey, srcrow);
@@ -35,18 +63,27 @@ static int distinctAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   }
 
   uint64_t hval = RSValue_Hash(val, 0);
+  if (ctr->hll) {
+    distinctAddHash(ctr->hll, hval);
+    return 1;
+  }
 
-  khiter_t k = kh_get(khid, ctr->dedup, hval);  // first have to get ieter
-  if (k == kh_end(ctr->dedup)) {
-    ctr->count++;
-    int ret;
-    kh_put(khid, ctr->dedup, hval, &ret);
+  int ret;
+  kh_put(khid, ctr->dedup, hval, &ret);
+  if (ret) {
+    size_t maxExact = ((distinctReducer *)r)->maxExact;
+    if (++ctr->count > maxExact && maxExact) {
+      distinctToApprox(ctr);
+    }
   }
   return 1;
 }
 
 static RSValue *distinctFinalize(Reducer *parent, void *ctx) {
   distinctCounter *ctr = ctx;
+  if (ctr->hll) {
+    return RS_NumVal((uint64_t)hll_count(ctr->hll));
+  }
   return RS_NumVal(ctr->count);
 }
 
@@ -54,15 +91,33 @@ static void distinctFreeInstance(Reducer *r, void *p) {
   distinctCounter *ctr = p;
   // we only destroy the hash table. The object itself is allocated from a block and needs no
   // freeing
-  kh_destroy(khid, ctr->dedup);
+  if (ctr->hll) {
+    hll_destroy(ctr->hll);
+    rm_free(ctr->hll);
+  } else {
+    kh_destroy(khid, ctr->dedup);
+  }
 }
 
 Reducer *RDCRCountDistinct_New(const ReducerOptions *options) {
-  Reducer *r = rm_calloc(1, sizeof(*r));
+  distinctReducer *dr = rm_calloc(1, sizeof(*dr));
+  Reducer *r = &dr->base;
   if (!ReducerOpts_GetKey(options, &r->srckey)) {
     rm_free(r);
     return NULL;
   }
+  if (!AC_IsAtEnd(options->args)) {
+    int rv;
+    if ((rv = AC_GetSize(options->args, &dr->maxExact, AC_F_GE1)) != AC_OK) {
+      QERR_MKBADARGS_AC(options->status, "<max_exact>", rv);
+      rm_free(r);
+      return NULL;
+    }
+  }
+  if (!ReducerOpts_EnsureArgsConsumed(options)) {
+    rm_free(r);
+    return NULL;
+  }
   r->Add = distinctAdd;
   r->Finalize = distinctFinalize;
   r->Free = Reducer_GenericFree;
@@ -118,6 +173,8 @@ typedef struct __attribute__((packed)) {
 
 static RSValue *hllFinalize(Reducer *parent, void *ctx) {
   distinctishCounter *ctr = ctx;
+  // The serialized format is always the dense registers
+  hll_densify(&ctr->hll);
 
   // Serialize field map.
   HLLSerializedHeader hdr = {.flags = 0, .bits = ctr->hll.bits};
@@ -208,8 +265,9 @@ static int hllsumAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
     }
   } else {
     // Not yet initialized - make this our first register and continue.
-    hll_init(&ctr->hll, hdr->bits);
-    memcpy(ctr->hll.registers, registers, regsz);
+    if (hll_load(&ctr->hll, registers, regsz) != 0) {
+      return 0;
+    }
   }
   return 1;
 }
@@ -221,8 +279,7 @@ static RSValue *hllsumFinalize(Reducer *parent, void *ctx) {
 
 static void *hllsumNewInstance(Reducer *r) {
   hllSumCtx *ctr = BlkAlloc_Alloc(&r->alloc, sizeof(*ctr), 1024 * sizeof(*ctr));
-  ctr->hll.bits = 0;
-  ctr->hll.registers = NULL;
+  memset(&ctr->hll, 0, sizeof(ctr->hll));
   ctr->srckey = r->srckey;
   return ctr;
 }
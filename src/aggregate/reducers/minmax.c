@@ -15,9 +15,9 @@ typedef struct {
   MinmaxMode mode;
 } MinmaxReducer;
 
-static void *minmaxNewInstance(Reducer *rbase) {
+static void minmaxInitInstance(Reducer *rbase, void *instance) {
   MinmaxReducer *r = (MinmaxReducer *)rbase;
-  minmaxCtx *m = BlkAlloc_Alloc(&rbase->alloc, sizeof(*m), 1024);
+  minmaxCtx *m = instance;
   m->mode = r->mode;
   m->srckey = r->base.srckey;
   m->numMatches = 0;
@@ -28,6 +28,11 @@ static void *minmaxNewInstance(Reducer *rbase) {
   } else {
     m->val = 0;
   }
+}
+
+static void *minmaxNewInstance(Reducer *rbase) {
+  minmaxCtx *m = BlkAlloc_Alloc(&rbase->alloc, sizeof(*m), 1024);
+  minmaxInitInstance(rbase, m);
   return m;
 }
 
@@ -61,6 +66,8 @@ static Reducer *newMinMax(const ReducerOptions *options, MinmaxMode mode) {
     return NULL;
   }
   r->base.NewInstance = minmaxNewInstance;
+  r->base.InitInstance = minmaxInitInstance;
+  r->base.instanceSize = sizeof(minmaxCtx);
   r->base.Add = minmaxAdd;
   r->base.Finalize = minmaxFinalize;
   r->base.Free = Reducer_GenericFree;
@@ -1,5 +1,5 @@
 #include <aggregate/reducer.h>
-#include "util/quantile.h"
+#include "util/tdigest.h"
 
 typedef struct {
   Reducer base;
@@ -9,13 +9,13 @@ typedef struct {
 
 static void *quantileNewInstance(Reducer *parent) {
   QTLReducer *qt = (QTLReducer *)parent;
-  return NewQuantileStream(&qt->pct, 0, qt->resolution);
+  return NewTDigest(qt->resolution);
 }
 
 static int quantileAdd(Reducer *rbase, void *ctx, const RLookupRow *row) {
   double d;
   QTLReducer *qt = (QTLReducer *)rbase;
-  QuantStream *qs = ctx;
+  TDigest *td = ctx;
   RSValue *v = RLookup_GetItem(rbase->srckey, row);
   if (!v) {
     return 1;
@@ -23,13 +23,13 @@ static int quantileAdd(Reducer *rbase, void *ctx, const RLookupRow *row) {
 
   if (v->t != RSValue_Array) {
     if (RSValue_ToNumber(v, &d)) {
-      QS_Insert(qs, d);
+      TD_Insert(td, d);
     }
   } else {
     uint32_t sz = RSValue_ArrayLen(v);
     for (uint32_t i = 0; i < sz; i++) {
       if (RSValue_ToNumber(RSValue_ArrayItem(v, i), &d)) {
-        QS_Insert(qs, d);
+        TD_Insert(td, d);
       }
     }
   }
@@ -37,31 +37,57 @@ static int quantileAdd(Reducer *rbase, void *ctx, const RLookupRow *row) {
 }
 
 static RSValue *quantileFinalize(Reducer *r, void *ctx) {
-  QuantStream *qs = ctx;
+  TDigest *td = ctx;
   QTLReducer *qt = (QTLReducer *)r;
-  double value = QS_Query(qs, qt->pct);
+  double value = TD_Quantile(td, qt->pct);
   return RS_NumVal(value);
 }
 
 static void quantileFreeInstance(Reducer *unused, void *p) {
-  QS_Free(p);
+  TD_Free(p);
 }
 
-Reducer *RDCRQuantile_New(const ReducerOptions *options) {
+static RSValue *tdigestFinalize(Reducer *r, void *ctx) {
+  size_t len;
+  char *buf = TD_Serialize(ctx, &len);
+  return RS_StringVal(buf, len);
+}
+
+/* Merge a digest serialized by the TDIGEST reducer */
+static int tdigestMergeAdd(Reducer *rbase, void *ctx, const RLookupRow *row) {
+  const RSValue *v = RLookup_GetItem(rbase->srckey, row);
+  if (v == NULL || !RSValue_IsString(v)) {
+    return 0;
+  }
+  size_t len;
+  const char *buf = RSValue_StringPtrLen(v, &len);
+  TDigest *src = TD_Deserialize(buf, len);
+  if (!src) {
+    return 0;
+  }
+  TD_Merge(ctx, src);
+  TD_Free(src);
+  return 1;
+}
+
+static Reducer *newQuantileCommon(const ReducerOptions *options, int isRaw) {
   QTLReducer *r = rm_calloc(1, sizeof(*r));
-  r->resolution = 500;  // Fixed, i guess?
+  // The t-digest compression
+  r->resolution = 500;
 
   if (!ReducerOptions_GetKey(options, &r->base.srckey)) {
     goto error;
   }
   int rv;
-  if ((rv = AC_GetDouble(options->args, &r->pct, 0)) != AC_OK) {
-    QERR_MKBADARGS_AC(options->status, options->name, rv);
-    goto error;
-  }
-  if (!(r->pct >= 0 && r->pct <= 1.0)) {
-    QERR_MKBADARGS_FMT(options->status, "Percentage must be between 0.0 and 1.0");
-    goto error;
+  if (!isRaw) {
+    if ((rv = AC_GetDouble(options->args, &r->pct, 0)) != AC_OK) {
+      QERR_MKBADARGS_AC(options->status, options->name, rv);
+      goto error;
+    }
+    if (!(r->pct >= 0 && r->pct <= 1.0)) {
+      QERR_MKBADARGS_FMT(options->status, "Percentage must be between 0.0 and 1.0");
+      goto error;
+    }
   }
 
   if (!AC_IsAtEnd(options->args)) {
@@ -83,10 +109,28 @@ Reducer *RDCRQuantile_New(const ReducerOptions *options) {
   r->base.Add = quantileAdd;
   r->base.Free = Reducer_GenericFree;
   r->base.FreeInstance = quantileFreeInstance;
-  r->base.Finalize = quantileFinalize;
+  r->base.Finalize = isRaw ? tdigestFinalize : quantileFinalize;
   return &r->base;
 
 error:
   rm_free(r);
   return NULL;
 }
+
+Reducer *RDCRQuantile_New(const ReducerOptions *options) {
+  return newQuantileCommon(options, 0);
+}
+
+/* TDIGEST {property} [resolution]: the serialized t-digest of the values */
+Reducer *RDCRTDigest_New(const ReducerOptions *options) {
+  return newQuantileCommon(options, 1);
+}
+
+/* TDIGEST_QUANTILE {digest property} {pct} [resolution]: the quantile of the merged digests */
+Reducer *RDCRTDigestQuantile_New(const ReducerOptions *options) {
+  Reducer *r = newQuantileCommon(options, 0);
+  if (r) {
+    r->Add = tdigestMergeAdd;
+  }
+  return r;
+}
@@ -13,10 +13,15 @@ typedef struct {
 
 #define BLOCK_SIZE 32 * sizeof(sumCtx)
 
-static void *sumNewInstance(Reducer *r) {
-  sumCtx *ctx = BlkAlloc_Alloc(&r->alloc, sizeof(*ctx), BLOCK_SIZE);
+static void sumInitInstance(Reducer *r, void *instance) {
+  sumCtx *ctx = instance;
   ctx->count = 0;
   ctx->total = 0;
+}
+
+static void *sumNewInstance(Reducer *r) {
+  sumCtx *ctx = BlkAlloc_Alloc(&r->alloc, sizeof(*ctx), BLOCK_SIZE);
+  sumInitInstance(r, ctx);
   return ctx;
 }
 
@@ -57,6 +62,8 @@ static Reducer *newReducerCommon(const ReducerOptions *options, int isAvg) {
     return NULL;
   }
   r->base.NewInstance = sumNewInstance;
+  r->base.InitInstance = sumInitInstance;
+  r->base.instanceSize = sizeof(sumCtx);
   r->base.Add = sumAdd;
   r->base.Finalize = sumFinalize;
   r->base.Free = Reducer_GenericFree;
@@ -227,6 +227,28 @@ CONFIG_GETTER(getSearchThreads) {
   return sdscatprintf(ss, "%lu", config->searchPoolSize);
 }
 
+// GROUPBY_THREADS
+CONFIG_SETTER(setGroupbyThreads) {
+  int acrc = AC_GetSize(ac, &config->groupbyThreads, 0);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(getGroupbyThreads) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->groupbyThreads);
+}
+
+// VECSIM_THREADS
+CONFIG_SETTER(setVecsimThreads) {
+  int acrc = AC_GetSize(ac, &config->vecsimThreads, 0);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(getVecsimThreads) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->vecsimThreads);
+}
+
 // FRISOINI
 CONFIG_SETTER(setFrisoINI) {
   int acrc = AC_GetString(ac, &config->frisoIni, NULL, 0);
@@ -594,6 +616,18 @@ RSConfigOptions RSGlobalConfigOptions = {
             .getValue = getSearchThreads,
             .flags = RSCONFIGVAR_F_IMMUTABLE,
         },
+        {.name = "GROUPBY_THREADS",
+         .helpText = "Aggregate GROUPBY steps on this number of threads, partitioning the groups "
+                     "between them (0 or 1 aggregates on the query thread)",
+         .setValue = setGroupbyThreads,
+         .getValue = getGroupbyThreads,
+         .flags = RSCONFIGVAR_F_IMMUTABLE},
+        {.name = "VECSIM_THREADS",
+         .helpText = "Insert vectors into HNSW indexes on this number of threads, outside of the "
+                     "indexing write phase (0 inserts them while indexing)",
+         .setValue = setVecsimThreads,
+         .getValue = getVecsimThreads,
+         .flags = RSCONFIGVAR_F_IMMUTABLE},
         {.name = "FRISOINI",
          .helpText = "Path to Chinese dictionary configuration file (for Chinese tokenization)",
          .setValue = setFrisoINI,
@@ -712,6 +746,8 @@ sds RSConfig_GetInfoString(const RSConfig *config) {
            : sdscatprintf(ss, " %lu, ", config->maxSearchResults);
   ss = sdscatprintf(ss, "search pool size: %lu, ", config->searchPoolSize);
   ss = sdscatprintf(ss, "index pool size: %lu, ", config->indexPoolSize);
+  ss = sdscatprintf(ss, "groupby threads: %lu, ", config->groupbyThreads);
+  ss = sdscatprintf(ss, "vecsim threads: %lu, ", config->vecsimThreads);
 
   if (config->extLoad) {
     ss = sdscatprintf(ss, "ext load: %s, ", config->extLoad);
@@ -70,6 +70,10 @@ typedef struct {
   size_t searchPoolSize;
   size_t indexPoolSize;
   int poolSizeNoAuto;  // Don't auto-detect pool size
+  // Number of threads aggregating a GROUPBY step, 0 or 1 to aggregate on the query thread
+  size_t groupbyThreads;
+  // Number of threads inserting vectors into HNSW indexes, 0 to insert them while indexing
+  size_t vecsimThreads;
 
   size_t gcScanSize;
 
@@ -177,6 +181,7 @@ sds RSConfig_GetInfoString(const RSConfig *config);
     .cursorReadSize = 1000, .cursorMaxIdle = 300000, .maxDocTableSize = DEFAULT_DOC_TABLE_SIZE,   \
     .searchPoolSize = CONCURRENT_SEARCH_POOL_DEFAULT_SIZE,                                        \
     .indexPoolSize = CONCURRENT_INDEX_POOL_DEFAULT_SIZE, .poolSizeNoAuto = 0,                     \
+    .groupbyThreads = 0, .vecsimThreads = 0,                                                      \
     .gcScanSize = GC_SCANSIZE, .minPhoneticTermLen = DEFAULT_MIN_PHONETIC_TERM_LEN,               \
     .gcPolicy = GCPolicy_Fork, .forkGcRunIntervalSec = DEFAULT_FORK_GC_RUN_INTERVAL,              \
     .forkGcSleepBeforeExit = 0, .maxResultsToUnsortedMode = DEFAULT_MAX_RESULTS_TO_UNSORTED_MODE, \
@@ -22,6 +22,7 @@ DocTable NewDocTable(size_t cap, size_t max_size) {
       .dim = NewDocIdMap(),
   };
   ret.buckets = rm_calloc(cap, sizeof(*ret.buckets));
+  Bitset_Init(&ret.liveDocs);
   return ret;
 }
 
@@ -224,6 +225,7 @@ RSDocumentMetadata *DocTable_Put(DocTable *t, const char *s, size_t n, double sc
   }
 
   DocTable_Set(t, docId, dmd);
+  Bitset_Set(&t->liveDocs, docId);
   ++t->size;
   t->memsize += sdsAllocSize(keyPtr);
   DocIdMap_Put(&t->dim, s, n, docId);
@@ -294,6 +296,7 @@ void DocTable_Free(DocTable *t) {
   }
   rm_free(t->buckets);
   DocIdMap_Free(&t->dim);
+  Bitset_Free(&t->liveDocs);
 }
 
 static void DocTable_DmdUnchain(DocTable *t, RSDocumentMetadata *md) {
@@ -336,6 +339,7 @@ RSDocumentMetadata *DocTable_Pop(DocTable *t, const char *s, size_t n) {
 
     DocTable_DmdUnchain(t, md);
     DocIdMap_Delete(&t->dim, s, n);
+    Bitset_Clear(&t->liveDocs, docId);
     --t->size;
 
     return md;
@@ -487,6 +491,7 @@ void DocTable_LegacyRdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
     } else {
       DocIdMap_Put(&t->dim, dmd->keyPtr, sdslen(dmd->keyPtr), dmd->id);
       DocTable_Set(t, dmd->id, dmd);
+      Bitset_Set(&t->liveDocs, dmd->id);
       t->memsize += sizeof(RSDocumentMetadata) + len;
     }
   }
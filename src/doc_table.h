@@ -9,6 +9,7 @@
 #include "byte_offsets.h"
 #include "rmutil/sds.h"
 #include "util/dict.h"
+#include "util/bitset.h"
 #include "rmutil/rm_assert.h"
 
 #ifdef __cplusplus
@@ -68,6 +69,9 @@ typedef struct {
 
   DMDChain *buckets;
   DocIdMap dim;
+  // ids of the documents currently in the table. Used by iterators that enumerate all documents
+  // (wildcard, NOT, OPTIONAL) to skip deleted ids without looking up their metadata
+  Bitset liveDocs;
 } DocTable;
 
 /* increasing the ref count of the given dmd */
@@ -123,6 +127,12 @@ int DocTable_SetPayload(DocTable *t, RSDocumentMetadata *dmd, const char *data,
 
 int DocTable_Exists(const DocTable *t, t_docId docId);
 
+/* Return 1 if the document id is in the table and was not deleted. Unlike DocTable_Exists, this
+ * does not touch the document metadata */
+static inline int DocTable_IsLive(const DocTable *t, t_docId docId) {
+  return Bitset_Test(&t->liveDocs, docId);
+}
+
 /* Set the sorting vector for a document. If the vector is NULL we mark the doc as not having a
  * vector. Returns 1 on success, 0 if the document does not exist. No further validation is done */
 int DocTable_SetSortingVector(DocTable *t, RSDocumentMetadata *dmd, RSSortingVector *v);
@@ -503,8 +503,25 @@ FIELD_PREPROCESSOR(vectorPreprocessor) {
   return 0;
 }
 
-FIELD_BULK_INDEXER(vectorIndexer) {
-  VecSimIndex *rt = bulk->indexDatas[IXFLDPOS_VECTOR];
+static int vectorIndexAdd(IndexBulkData *bulk, RSAddDocumentCtx *aCtx, RedisSearchCtx *ctx,
+                          const FieldSpec *fs, const void *vector, size_t vecLen,
+                          QueryError *status) {
+  if (fs->vecQuant != VectorQuant_None) {
+    // not cached in the bulk, which holds the vector index of other fields
+    RedisModuleString *keyName = IndexSpec_GetFormattedKey(ctx->spec, fs, INDEXFLD_T_VECTOR);
+    QuantizedVectors *qv = OpenQuantizedVectors(ctx, keyName);
+    if (!qv) {
+      QueryError_SetError(status, QUERY_EGENERIC, "Could not open vector for indexing");
+      return -1;
+    }
+    if (QuantizedVectors_Add(qv, vector, vecLen, aCtx->doc->docId) != 0) {
+      QueryError_SetError(status, QUERY_EGENERIC, "Invalid vector length for quantized field");
+      return -1;
+    }
+    ctx->spec->stats.numRecords++;
+    return 0;
+  }
+  VectorIndex *rt = bulk->indexDatas[IXFLDPOS_VECTOR];
   if (!rt) {
     RedisModuleString *keyName = IndexSpec_GetFormattedKey(ctx->spec, fs, INDEXFLD_T_VECTOR);
     rt = bulk->indexDatas[IXFLDPOS_VECTOR] =
@@ -515,13 +532,28 @@ FIELD_BULK_INDEXER(vectorIndexer) {
     }
   }
   // TODO: change return value to NRN_AddRv
-  int rv = VecSimIndex_AddVector(rt, fdata->vector, aCtx->doc->docId);
+  VectorIndex_AddVector(rt, vector, vecLen, aCtx->doc->docId);
   // TODO: update size statistics but put in a separate field to distinguise from inverted indexes
   // ctx->spec->stats.invertedSize += rt->size * sizeof(double) * 2;
   ctx->spec->stats.numRecords++;
   return 0;
 }
 
+FIELD_BULK_INDEXER(vectorIndexer) {
+  // the vector index holds FLOAT32 vectors of half precision fields
+  size_t vecLen = fdata->vecLen;
+  const void *vector = VectorField_IndexedVectors(fs, fdata->vector, &vecLen);
+  if (!vector) {
+    QueryError_SetError(status, QUERY_EGENERIC, "Invalid vector length for half precision field");
+    return -1;
+  }
+  int rc = vectorIndexAdd(bulk, aCtx, ctx, fs, vector, vecLen, status);
+  if (vector != fdata->vector) {
+    rm_free((void *)vector);
+  }
+  return rc;
+}
+
 FIELD_PREPROCESSOR(geoPreprocessor) {
   size_t len;
   const char *str = NULL;
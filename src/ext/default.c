@@ -204,6 +204,49 @@ static double BM25Scorer(const ScoringFunctionArgs *ctx, const RSIndexResult *r,
   return score;
 }
 
+/******************************************************************************************
+ *
+ * Hybrid text and vector scorer
+ *
+ ******************************************************************************************/
+
+/* The BM25 score of the text clauses of a result. The similarity of its closest vector clause,
+ * 1 / (1 + distance) times the clause weight, is set in `similarity` */
+static double hybridRecursive(const ScoringFunctionArgs *ctx, const RSIndexResult *r,
+                              const RSDocumentMetadata *dmd, double *similarity) {
+  if (r->type == RSResultType_Distance) {
+    // IP distances may be negative. NEAREST geo distances are not similarities
+    if (!r->dist.isGeo) {
+      *similarity = MAX(*similarity, r->weight / (1 + MAX(r->dist.value, 0)));
+    }
+    return 0;
+  } else if (r->type & (RSResultType_Intersection | RSResultType_Union)) {
+    double ret = 0;
+    for (int i = 0; i < r->agg.numChildren; i++) {
+      ret += hybridRecursive(ctx, r->agg.children[i], dmd, similarity);
+    }
+    return r->weight * ret;
+  }
+  return bm25Recursive(ctx, r, dmd, NULL);
+}
+
+/* HYBRID scoring function - the BM25 score of the text clauses, plus the weighted similarity of
+ * the vector clause. Documents which only match one of them are scored by it alone */
+static double HybridScorer(const ScoringFunctionArgs *ctx, const RSIndexResult *r,
+                           const RSDocumentMetadata *dmd, double minScore) {
+  RSScoreExplain *scrExp = (RSScoreExplain *)ctx->scrExp;
+  double similarity = 0;
+  double bm25res = hybridRecursive(ctx, r, dmd, &similarity);
+  int slop = ctx->GetSlop(r);
+  double score = dmd->score * bm25res / slop + similarity;
+
+  EXPLAIN(scrExp,
+          "Final HYBRID : words BM25 %.2f * document score %.2f / slop %d + vector similarity "
+          "%.2f",
+          bm25res, dmd->score, slop, similarity);
+  return score;
+}
+
 /******************************************************************************************
  *
  * Raw document-score scorer. Just returns the document score
@@ -533,6 +576,12 @@ int DefaultExtensionInit(RSExtensionCtx *ctx) {
     return REDISEARCH_ERR;
   }
 
+  /* Register HYBRID scorer */
+  if (ctx->RegisterScoringFunction(HYBRID_SCORER_NAME, HybridScorer, NULL, NULL) ==
+      REDISEARCH_ERR) {
+    return REDISEARCH_ERR;
+  }
+
   /* Register HAMMING scorer */
   if (ctx->RegisterScoringFunction(HAMMINGDISTANCE_SCORER, HammingDistanceScorer, NULL, NULL) ==
       REDISEARCH_ERR) {
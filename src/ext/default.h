@@ -10,6 +10,7 @@
 #define TFIDF_DOCNORM_SCORER_NAME "TFIDF.DOCNORM"
 #define DISMAX_SCORER_NAME "DISMAX"
 #define BM25_SCORER_NAME "BM25"
+#define HYBRID_SCORER_NAME "HYBRID"
 #define DOCSCORE_SCORER "DOCSCORE"
 #define HAMMINGDISTANCE_SCORER "HAMMING"
 
@@ -65,6 +65,19 @@ typedef enum {
 
 RS_ENUM_BITWISE_HELPER(TagFieldFlags)
 
+/* How the vectors of a vector field are stored */
+typedef enum {
+  VectorQuant_None = 0,
+  VectorQuant_Int8 = 1,
+} VectorQuantization;
+
+/* Half precision element types of vector fields, which the vector index holds as FLOAT32 */
+typedef enum {
+  VectorHalf_None = 0,
+  VectorHalf_Float16 = 1,
+  VectorHalf_BFloat16 = 2,
+} VectorHalfType;
+
 /* The fieldSpec represents a single field in the document's field spec.
 Each field has a unique id that's a power of two, so we can filter fields
 by a bit mask.
@@ -92,6 +105,10 @@ typedef struct FieldSpec {
 
   // Vector similarity index parameters.
   VecSimParams vecSimParams;
+  // Vectors quantized with QUANTIZE are stored by RediSearch instead of the vector index
+  VectorQuantization vecQuant;
+  // Vectors of half precision elements are given to the vector index as FLOAT32
+  VectorHalfType vecHalf;
 
   // TODO: More options here..
 } FieldSpec;
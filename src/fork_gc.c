@@ -17,6 +17,7 @@
 #include <float.h>
 #include "module.h"
 #include "rmutil/rm_assert.h"
+#include "util/prefix_cache.h"
 
 #ifdef __linux__
 #include <sys/prctl.h>
@@ -181,9 +182,10 @@ typedef struct {
 } MSG_RepairedBlock;
 
 typedef struct {
-  void *ptr;       // Address of the buffer to free
-  uint32_t oldix;  // Old index of deleted block
-  uint32_t _pad;   // Uninitialized reads, otherwise
+  void *ptr;         // Address of the buffer to free
+  void *offsetsPtr;  // Address of the offsets buffer to free, if any
+  uint32_t oldix;    // Old index of deleted block
+  uint32_t _pad;     // Uninitialized reads, otherwise
 } MSG_DeletedBlock;
 
 /**
@@ -221,6 +223,7 @@ static bool FGC_childRepairInvidx(ForkGC *gc, RedisSearchCtx *sctx, InvertedInde
     // Capture the pointer address before the block is cleared; otherwise
     // the pointer might be freed!
     void *bufptr = blk->buf.data;
+    void *offsetsptr = blk->offsetsBuf.data;
     int nrepaired = IndexBlock_Repair(blk, &sctx->spec->docs, idx->flags, params);
     // We couldn't repair the block - return 0
     if (nrepaired == -1) {
@@ -234,7 +237,7 @@ static bool FGC_childRepairInvidx(ForkGC *gc, RedisSearchCtx *sctx, InvertedInde
     if (blk->numDocs == 0) {
       // this block should be removed
       MSG_DeletedBlock *delmsg = array_ensure_tail(&deleted, MSG_DeletedBlock);
-      *delmsg = (MSG_DeletedBlock){.ptr = bufptr, .oldix = i};
+      *delmsg = (MSG_DeletedBlock){.ptr = bufptr, .offsetsPtr = offsetsptr, .oldix = i};
     } else {
       blocklist = array_append(blocklist, *blk);
       MSG_RepairedBlock *fixmsg = array_ensure_tail(&fixed, MSG_RepairedBlock);
@@ -275,6 +278,7 @@ static bool FGC_childRepairInvidx(ForkGC *gc, RedisSearchCtx *sctx, InvertedInde
     const IndexBlock *blk = blocklist + msg->newix;
     FGC_sendFixed(gc, msg, sizeof(*msg));
     FGC_sendBuffer(gc, IndexBlock_DataBuf(blk), IndexBlock_DataLen(blk));
+    FGC_sendBuffer(gc, IndexBlock_OffsetsBuf(blk), IndexBlock_OffsetsLen(blk));
   }
   rv = true;
 
@@ -554,6 +558,12 @@ FGC_recvRepairedBlock(ForkGC *gc, MSG_RepairedBlock *binfo) {
     return REDISMODULE_ERR;
   }
   b->cap = b->offset;
+  Buffer *ob = &binfo->blk.offsetsBuf;
+  if (FGC_recvBuffer(gc, (void **)&ob->data, &ob->offset) != REDISMODULE_OK) {
+    rm_free(b->data);
+    return REDISMODULE_ERR;
+  }
+  ob->cap = ob->offset;
   return REDISMODULE_OK;
 }
 
@@ -586,7 +596,7 @@ FGC_recvInvIdx(ForkGC *gc, InvIdxBuffers *bufs, MSG_IndexInfo *info) {
 error:
   rm_free(bufs->newBlocklist);
   for (size_t ii = 0; ii < nblocksRecvd; ++ii) {
-    rm_free(bufs->changedBlocks[ii].blk.buf.data);
+    indexBlock_Free(&bufs->changedBlocks[ii].blk);
   }
   rm_free(bufs->changedBlocks);
   memset(bufs, 0, sizeof(*bufs));
@@ -600,7 +610,7 @@ static void freeInvIdx(InvIdxBuffers *bufs, MSG_IndexInfo *info) {
   if (bufs->changedBlocks) {
     // could be null because of pipe error
     for (size_t ii = 0; ii < info->nblocksRepaired; ++ii) {
-      rm_free(bufs->changedBlocks[ii].blk.buf.data);
+      indexBlock_Free(&bufs->changedBlocks[ii].blk);
     }
   }
   rm_free(bufs->changedBlocks);
@@ -664,6 +674,7 @@ static void FGC_applyInvertedIndex(ForkGC *gc, InvIdxBuffers *idxData, MSG_Index
     // Blocks that were deleted entirely:
     MSG_DeletedBlock *delinfo = idxData->delBlocks + i;
     rm_free(delinfo->ptr);
+    rm_free(delinfo->offsetsPtr);
   }
   rm_free(idxData->delBlocks);
 
@@ -777,6 +788,8 @@ static FGCError FGC_parentHandleTerms(ForkGC *gc, RedisModuleCtx *rctx) {
       dictDelete(sctx->spec->keysDict, termKey);
     }
     Trie_Delete(sctx->spec->terms, term, len);
+    IndexSpec_InvalidatePrefixCache(sctx->spec, term, len);
+    IndexSpec_DeleteFuzzyTerm(sctx->spec, term, len);
     RedisModule_FreeString(sctx->redisCtx, termKey);
   }
 
@@ -1100,6 +1113,7 @@ static FGCError FGC_parentHandleTags(ForkGC *gc, RedisModuleCtx *rctx) {
     if (idx->numDocs == 0) {
       // printf("Delete GC %s %p\n", tagVal, TrieMap_Find(tagIdx->values, tagVal, tagValLen));
       TrieMap_Delete(tagIdx->values, tagVal, tagValLen, InvertedIndex_Free);
+      PrefixCache_InvalidatePrefixesOf(tagIdx->prefixCache, tagVal, tagValLen, 1);
     }
 
   loop_cleanup:
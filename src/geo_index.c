@@ -5,14 +5,89 @@
 #include "rmutil/rm_assert.h"
 #include "query_node.h"
 #include "query_param.h"
+#include "util/minmax.h"
+#include "list_reader.h"
+
+#include <math.h>
 
 static double extractUnitFactor(GeoDistance unit);
 
+/* Parse the corners of a BOX filter: <min lon> <min lat> <max lon> <max lat> */
+static int parseBox(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
+  static const char *names[] = {"<min lon>", "<min lat>", "<max lon>", "<max lat>"};
+  double *coords[] = {&gf->minLon, &gf->minLat, &gf->maxLon, &gf->maxLat};
+  gf->shape = GEO_SHAPE_BOX;
+  for (size_t i = 0; i < 4; i++) {
+    int rv;
+    if ((rv = AC_GetDouble(ac, coords[i], 0)) != AC_OK) {
+      QERR_MKBADARGS_AC(status, names[i], rv);
+      return REDISMODULE_ERR;
+    }
+  }
+  return GeoFilter_Validate(gf, status) ? REDISMODULE_OK : REDISMODULE_ERR;
+}
+
+/* Parse the vertices of a POLYGON filter: <num points> <lon> <lat> ... */
+static int parsePolygon(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
+  gf->shape = GEO_SHAPE_POLYGON;
+  size_t num;
+  int rv;
+  if ((rv = AC_GetSize(ac, &num, 0)) != AC_OK) {
+    QERR_MKBADARGS_AC(status, "<num points>", rv);
+    return REDISMODULE_ERR;
+  } else if (num < 3 || num > AC_NumRemaining(ac) / 2) {
+    QERR_MKBADARGS_FMT(status, "POLYGON requires at least 3 points, as longitude and latitude pairs");
+    return REDISMODULE_ERR;
+  }
+
+  gf->points = rm_malloc(2 * num * sizeof(*gf->points));
+  gf->numPoints = num;
+  for (size_t i = 0; i < 2 * num; i++) {
+    if ((rv = AC_GetDouble(ac, &gf->points[i], 0)) != AC_OK) {
+      QERR_MKBADARGS_AC(status, i % 2 ? "<lat>" : "<lon>", rv);
+      return REDISMODULE_ERR;
+    }
+  }
+  gf->minLon = gf->maxLon = gf->points[0];
+  gf->minLat = gf->maxLat = gf->points[1];
+  for (size_t i = 1; i < num; i++) {
+    gf->minLon = MIN(gf->minLon, gf->points[2 * i]);
+    gf->maxLon = MAX(gf->maxLon, gf->points[2 * i]);
+    gf->minLat = MIN(gf->minLat, gf->points[2 * i + 1]);
+    gf->maxLat = MAX(gf->maxLat, gf->points[2 * i + 1]);
+  }
+  return GeoFilter_Validate(gf, status) ? REDISMODULE_OK : REDISMODULE_ERR;
+}
+
+/* Parse a NEAREST filter: <lon> <lat> <k> <unit>, where the unit is that of the distances */
+static int parseNearest(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
+  gf->shape = GEO_SHAPE_NEAREST;
+  int rv;
+  if ((rv = AC_GetDouble(ac, &gf->lon, 0)) != AC_OK) {
+    QERR_MKBADARGS_AC(status, "<lon>", rv);
+    return REDISMODULE_ERR;
+  } else if ((rv = AC_GetDouble(ac, &gf->lat, 0)) != AC_OK) {
+    QERR_MKBADARGS_AC(status, "<lat>", rv);
+    return REDISMODULE_ERR;
+  } else if ((rv = AC_GetSize(ac, &gf->k, AC_F_GE1)) != AC_OK) {
+    QERR_MKBADARGS_AC(status, "<k>", rv);
+    return REDISMODULE_ERR;
+  }
+  const char *unitstr = AC_GetStringNC(ac, NULL);
+  if (!unitstr || (gf->unitType = GeoDistance_Parse(unitstr)) == GEO_DISTANCE_INVALID) {
+    QERR_MKBADARGS_FMT(status, "Unknown distance unit %s", unitstr ? unitstr : "");
+    return REDISMODULE_ERR;
+  }
+  return GeoFilter_Validate(gf, status) ? REDISMODULE_OK : REDISMODULE_ERR;
+}
+
 /* Parse a geo filter from redis arguments. We assume the filter args start at argv[0], and FILTER
  * is not passed to us.
- * The GEO filter syntax is (FILTER) <property> LONG LAT DIST m|km|ft|mi
+ * The GEO filter syntax is (FILTER) <property> LONG LAT DIST m|km|ft|mi, or a BOX, POLYGON or
+ * NEAREST
  * Returns REDISMODUEL_OK or ERR  */
 int GeoFilter_Parse(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
+  gf->shape = GEO_SHAPE_RADIUS;
   gf->lat = 0;
   gf->lon = 0;
   gf->radius = 0;
@@ -30,6 +105,13 @@ int GeoFilter_Parse(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
   } else {
     gf->property = rm_strdup(gf->property);
   }
+  if (AC_AdvanceIfMatch(ac, "BOX")) {
+    return parseBox(gf, ac, status);
+  } else if (AC_AdvanceIfMatch(ac, "POLYGON")) {
+    return parsePolygon(gf, ac, status);
+  } else if (AC_AdvanceIfMatch(ac, "NEAREST")) {
+    return parseNearest(gf, ac, status);
+  }
   if ((rv = AC_GetDouble(ac, &gf->lon, 0) != AC_OK)) {
     QERR_MKBADARGS_AC(status, "<lon>", rv);
     return REDISMODULE_ERR;
@@ -56,8 +138,9 @@ int GeoFilter_Parse(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
 
 void GeoFilter_Free(GeoFilter *gf) {
   if (gf->property) rm_free((char *)gf->property);
+  rm_free(gf->points);
   if (gf->numericFilters) {
-    for (int i = 0; i < GEO_RANGE_COUNT; ++i) {
+    for (int i = 0; i < GEO_COVER_MAX_CELLS; ++i) {
       if (gf->numericFilters[i])
         NumericFilter_Free(gf->numericFilters[i]);
     }
@@ -105,24 +188,190 @@ done:
   return docIds;
 }
 
+// The earth radius of geohashGetDistance
+#define GEO_EARTH_RADIUS_METERS 6372797.560856
+
+typedef struct {
+  const GeoFilter *gf;
+  // the radius in meters, and its bounding box
+  double radius;
+  double minLon;
+  double minLat;
+  double maxLon;
+  double maxLat;
+  // the bounding box of a radius reaching a pole has all the longitudes
+  bool allLon;
+} GeoCoverCtx;
+
+static inline double degToRad(double deg) {
+  return deg * M_PI / 180;
+}
+
+static inline double radToDeg(double rad) {
+  return rad * 180 / M_PI;
+}
+
+/* The bounding box of the spherical cap within the radius of the filter's point */
+static void radiusBoundingBox(const GeoFilter *gf, GeoCoverCtx *cover) {
+  cover->radius = gf->radius * extractUnitFactor(gf->unitType);
+  // widened a bit, so rounding errors don't leave out points on the boundary
+  double angle = cover->radius / GEO_EARTH_RADIUS_METERS * (1 + 1e-9) + 1e-12;
+  cover->minLat = gf->lat - radToDeg(angle);
+  cover->maxLat = gf->lat + radToDeg(angle);
+  if (cover->minLat <= -90 || cover->maxLat >= 90 || sin(angle) >= cos(degToRad(gf->lat))) {
+    cover->allLon = true;
+    return;
+  }
+  // the widest longitudes of the cap are north of its center in the northern hemisphere
+  double dLon = radToDeg(asin(sin(angle) / cos(degToRad(gf->lat))));
+  cover->minLon = gf->lon - dLon;
+  cover->maxLon = gf->lon + dLon;
+  if (cover->minLon < GEO_LONG_MIN) {
+    cover->minLon += 360;
+  }
+  if (cover->maxLon > GEO_LONG_MAX) {
+    cover->maxLon -= 360;
+  }
+}
+
+/* Whether a longitude is in the longitudes of a box, which cross the antimeridian when min is above
+ * max */
+static inline bool lonWithin(double lon, double min, double max) {
+  return min <= max ? lon >= min && lon <= max : lon >= min || lon <= max;
+}
+
+static inline bool lonOverlaps(const GeoHashArea *cell, double min, double max) {
+  return min <= max ? cell->longitude.max >= min && cell->longitude.min <= max
+                    : cell->longitude.max >= min || cell->longitude.min <= max;
+}
+
+/* Cells never cross the antimeridian */
+static inline bool lonContains(const GeoHashArea *cell, double min, double max) {
+  return min <= max ? cell->longitude.min >= min && cell->longitude.max <= max
+                    : cell->longitude.min >= min || cell->longitude.max <= max;
+}
+
+static inline bool latOverlaps(const GeoHashArea *cell, double min, double max) {
+  return cell->latitude.max >= min && cell->latitude.min <= max;
+}
+
+/* Whether the segment between two points crosses or is in the cell (Liang-Barsky clipping) */
+static bool segmentIntersects(const GeoHashArea *cell, const double *p0, const double *p1) {
+  double t0 = 0, t1 = 1;
+  double dx = p1[0] - p0[0], dy = p1[1] - p0[1];
+  double p[] = {-dx, dx, -dy, dy};
+  double q[] = {p0[0] - cell->longitude.min, cell->longitude.max - p0[0],
+                p0[1] - cell->latitude.min, cell->latitude.max - p0[1]};
+  for (int i = 0; i < 4; i++) {
+    if (p[i] == 0) {
+      if (q[i] < 0) {
+        return false;
+      }
+      continue;
+    }
+    double t = q[i] / p[i];
+    if (p[i] < 0) {
+      if (t > t1) return false;
+      t0 = MAX(t0, t);
+    } else {
+      if (t < t0) return false;
+      t1 = MIN(t1, t);
+    }
+  }
+  return true;
+}
+
+/* Whether a point is in a polygon, whose edges are straight in longitude and latitude */
+static bool polygonContains(const GeoFilter *gf, double lon, double lat) {
+  bool in = false;
+  const double *pts = gf->points;
+  for (size_t i = 0, j = gf->numPoints - 1; i < gf->numPoints; j = i++) {
+    double xi = pts[2 * i], yi = pts[2 * i + 1], xj = pts[2 * j], yj = pts[2 * j + 1];
+    if ((yi > lat) != (yj > lat) && lon < (xj - xi) * (lat - yi) / (yj - yi) + xi) {
+      in = !in;
+    }
+  }
+  return in;
+}
+
+static GeoCellRelation radiusRelation(const GeoHashArea *cell, const GeoCoverCtx *cover) {
+  const GeoFilter *gf = cover->gf;
+  if (!latOverlaps(cell, cover->minLat, cover->maxLat) ||
+      (!cover->allLon && !lonOverlaps(cell, cover->minLon, cover->maxLon))) {
+    return GEO_CELL_DISJOINT;
+  }
+  // Within the longitudes of the bounding box, the farthest point of a cell is a corner
+  if (cover->allLon || !lonContains(cell, cover->minLon, cover->maxLon)) {
+    return GEO_CELL_INTERSECTS;
+  }
+  double lons[] = {cell->longitude.min, cell->longitude.max};
+  double lats[] = {cell->latitude.min, cell->latitude.max};
+  for (int i = 0; i < 4; i++) {
+    if (!isWithinRadiusLonLat(gf->lon, gf->lat, lons[i / 2], lats[i % 2], cover->radius, NULL)) {
+      return GEO_CELL_INTERSECTS;
+    }
+  }
+  return GEO_CELL_CONTAINED;
+}
+
+static GeoCellRelation polygonRelation(const GeoHashArea *cell, const GeoFilter *gf) {
+  if (!latOverlaps(cell, gf->minLat, gf->maxLat) || !lonOverlaps(cell, gf->minLon, gf->maxLon)) {
+    return GEO_CELL_DISJOINT;
+  }
+  for (size_t i = 0, j = gf->numPoints - 1; i < gf->numPoints; j = i++) {
+    if (segmentIntersects(cell, gf->points + 2 * j, gf->points + 2 * i)) {
+      return GEO_CELL_INTERSECTS;
+    }
+  }
+  // no edge is in the cell, so it is either all in the polygon or all out of it
+  double lon = (cell->longitude.min + cell->longitude.max) / 2;
+  double lat = (cell->latitude.min + cell->latitude.max) / 2;
+  return polygonContains(gf, lon, lat) ? GEO_CELL_CONTAINED : GEO_CELL_DISJOINT;
+}
+
+static GeoCellRelation geoCellRelation(const GeoHashArea *cell, const void *ctx) {
+  const GeoCoverCtx *cover = ctx;
+  const GeoFilter *gf = cover->gf;
+  switch (gf->shape) {
+    case GEO_SHAPE_RADIUS:
+      return radiusRelation(cell, cover);
+    case GEO_SHAPE_BOX:
+      if (!latOverlaps(cell, gf->minLat, gf->maxLat) ||
+          !lonOverlaps(cell, gf->minLon, gf->maxLon)) {
+        return GEO_CELL_DISJOINT;
+      } else if (cell->latitude.min >= gf->minLat && cell->latitude.max <= gf->maxLat &&
+                 lonContains(cell, gf->minLon, gf->maxLon)) {
+        return GEO_CELL_CONTAINED;
+      }
+      return GEO_CELL_INTERSECTS;
+    case GEO_SHAPE_POLYGON:
+      return polygonRelation(cell, gf);
+    case GEO_SHAPE_NEAREST:
+      // not covered by cells, see NewGeoNearestIterator
+      break;
+  }
+  return GEO_CELL_INTERSECTS;
+}
+
 IndexIterator *NewGeoRangeIterator(RedisSearchCtx *ctx, const GeoFilter *gf) {
-  GeoHashRange ranges[GEO_RANGE_COUNT] = {{0}};
-  double radius_meter = gf->radius * extractUnitFactor(gf->unitType);
-  calcRanges(gf->lon, gf->lat, radius_meter, ranges);
+  GeoHashRange ranges[GEO_COVER_MAX_CELLS];
+  GeoCoverCtx cover = {.gf = gf};
+  if (gf->shape == GEO_SHAPE_RADIUS) {
+    radiusBoundingBox(gf, &cover);
+  }
+  size_t numRanges = calcCoverRanges(geoCellRelation, &cover, ranges, GEO_COVER_MAX_CELLS);
 
-  IndexIterator **iters = rm_calloc(GEO_RANGE_COUNT, sizeof(*iters));
-  ((GeoFilter *)gf)->numericFilters = rm_calloc(GEO_RANGE_COUNT, sizeof(*gf->numericFilters));
+  IndexIterator **iters = rm_calloc(MAX(numRanges, 1), sizeof(*iters));
+  ((GeoFilter *)gf)->numericFilters = rm_calloc(GEO_COVER_MAX_CELLS, sizeof(*gf->numericFilters));
   size_t itersCount = 0;
-  for (size_t ii = 0; ii < GEO_RANGE_COUNT; ++ii) {
-    if (ranges[ii].min != ranges[ii].max) {
-      NumericFilter *filt = gf->numericFilters[ii] =
-              NewNumericFilter(ranges[ii].min, ranges[ii].max, 1, 1);
-      filt->fieldName = rm_strdup(gf->property);
-      filt->geoFilter = gf;
-      struct indexIterator *numIter = NewNumericFilterIterator(ctx, filt, NULL, INDEXFLD_T_GEO);
-      if (numIter != NULL) {
-        iters[itersCount++] = numIter;
-      }
+  for (size_t ii = 0; ii < numRanges; ++ii) {
+    NumericFilter *filt = gf->numericFilters[ii] =
+            NewNumericFilter(ranges[ii].min, ranges[ii].max, 1, 0);
+    filt->fieldName = rm_strdup(gf->property);
+    filt->geoFilter = gf;
+    struct indexIterator *numIter = NewNumericFilterIterator(ctx, filt, NULL, INDEXFLD_T_GEO);
+    if (numIter != NULL) {
+      iters[itersCount++] = numIter;
     }
   }
 
@@ -141,6 +390,225 @@ IndexIterator *NewGeoRangeIterator(RedisSearchCtx *ctx, const GeoFilter *gf) {
   return it;
 }
 
+// The cells of a range of geohashes are split this many levels below their common prefix, to
+// bound the distance of the range
+#define GEO_NEAREST_RANGE_SPLITS 4
+
+/* The distance in meters from the filter's point to the nearest point of a cell. It is either on
+ * the meridian of the point, or on a meridian edge of the cell */
+static double cellDistance(const GeoFilter *gf, const GeoHashArea *cell) {
+  if (lonWithin(gf->lon, cell->longitude.min, cell->longitude.max)) {
+    double lat = MIN(MAX(gf->lat, cell->latitude.min), cell->latitude.max);
+    return geohashGetDistance(gf->lon, gf->lat, gf->lon, lat);
+  }
+  double dist = INFINITY;
+  double edges[] = {cell->longitude.min, cell->longitude.max};
+  for (int i = 0; i < 2; i++) {
+    // along a meridian, the distance is the least at this latitude, or at the nearest end
+    double dLon = degToRad(edges[i] - gf->lon);
+    double peak =
+        radToDeg(atan2(sin(degToRad(gf->lat)), cos(degToRad(gf->lat)) * cos(dLon)));
+    double lats[] = {cell->latitude.min, cell->latitude.max,
+                     MIN(MAX(peak, cell->latitude.min), cell->latitude.max)};
+    for (int j = 0; j < 3; j++) {
+      double d = geohashGetDistance(gf->lon, gf->lat, edges[i], lats[j]);
+      dist = MIN(dist, d);
+    }
+  }
+  return dist;
+}
+
+/* A lower bound of the distance in meters from the filter's point to the geohashes in
+ * [min, max], within `cell`. The cells which the range only partly covers are split, at most
+ * `splits` times once the range is in more than one of their children */
+static double rangeDistance(const GeoFilter *gf, uint64_t min, uint64_t max, GeoHashBits cell,
+                            int splits) {
+  int shift = 2 * (GEO_STEP_MAX - cell.step);
+  uint64_t cellMin = cell.bits << shift, cellMax = ((cell.bits + 1) << shift) - 1;
+  if (max < cellMin || min > cellMax) {
+    return INFINITY;
+  }
+  // whether the range is in more than one child of the cell
+  uint64_t first = MAX(min, cellMin), last = MIN(max, cellMax);
+  bool spread = cell.step < GEO_STEP_MAX && (first >> (shift - 2)) != (last >> (shift - 2));
+  if ((min <= cellMin && max >= cellMax) || cell.step == GEO_STEP_MAX || (spread && !splits)) {
+    // the whole world doesn't decode
+    GeoHashArea area = {.longitude = {GEO_LONG_MIN, GEO_LONG_MAX},
+                        .latitude = {GEO_LAT_MIN, GEO_LAT_MAX}};
+    if (cell.step) {
+      geohashDecodeWGS84(cell, &area);
+    }
+    // rounding must not place a point nearer than its cell
+    return cellDistance(gf, &area) * (1 - 1e-9);
+  }
+  if (spread) {
+    splits--;
+  }
+  double dist = INFINITY;
+  for (uint64_t i = 0; i < 4; i++) {
+    GeoHashBits child = {.bits = (cell.bits << 2) | i, .step = cell.step + 1};
+    double d = rangeDistance(gf, min, max, child, splits);
+    dist = MIN(dist, d);
+  }
+  return dist;
+}
+
+/* A node of the geo index to visit, or a document, by its distance from the point */
+typedef struct {
+  double dist;
+  NumericRangeNode *node;  // NULL for a document
+  double min;              // the values of the node are in [min, max]
+  double max;
+  t_docId docId;
+} GeoNearestEntry;
+
+typedef struct {
+  GeoNearestEntry *entries;
+  size_t len;
+  size_t cap;
+} GeoNearestHeap;
+
+static void nearestHeapPush(GeoNearestHeap *h, GeoNearestEntry e) {
+  if (h->len == h->cap) {
+    h->cap = h->cap ? h->cap * 2 : 16;
+    h->entries = rm_realloc(h->entries, h->cap * sizeof(*h->entries));
+  }
+  size_t i = h->len++;
+  while (i > 0 && h->entries[(i - 1) / 2].dist > e.dist) {
+    h->entries[i] = h->entries[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  h->entries[i] = e;
+}
+
+static GeoNearestEntry nearestHeapPop(GeoNearestHeap *h) {
+  GeoNearestEntry top = h->entries[0], last = h->entries[--h->len];
+  size_t i = 0;
+  while (1) {
+    size_t child = 2 * i + 1;
+    if (child >= h->len) {
+      break;
+    }
+    if (child + 1 < h->len && h->entries[child + 1].dist < h->entries[child].dist) {
+      child++;
+    }
+    if (h->entries[child].dist >= last.dist) {
+      break;
+    }
+    h->entries[i] = h->entries[child];
+    i = child;
+  }
+  h->entries[i] = last;
+  return top;
+}
+
+/* Push a node of the tree with the values in [min, max] */
+static void nearestPushNode(GeoNearestHeap *h, const GeoFilter *gf, NumericRangeNode *node,
+                            double min, double max) {
+  if (!node) {
+    return;
+  }
+  if (node->range) {
+    min = MAX(min, node->range->minVal);
+    max = MIN(max, node->range->maxVal);
+  }
+  // geohashes are whole numbers of 52 bits
+  double lo = MAX(ceil(min), 0), hi = MIN(floor(max), (double)((1ULL << 52) - 1));
+  if (lo > hi) {
+    return;
+  }
+  GeoHashBits world = {.bits = 0, .step = 0};
+  double dist = rangeDistance(gf, (uint64_t)lo, (uint64_t)hi, world, GEO_NEAREST_RANGE_SPLITS);
+  if (dist != INFINITY) {
+    nearestHeapPush(h, (GeoNearestEntry){.dist = dist, .node = node, .min = min, .max = max});
+  }
+}
+
+/* Push the live documents of a leaf which the filter has */
+static void nearestPushLeaf(GeoNearestHeap *h, RedisSearchCtx *ctx, const GeoFilter *gf,
+                            NumericRange *rng, IndexIterator *filter) {
+  IndexReader *ir = NewNumericReader(ctx->spec, rng->entries, NULL, rng->minVal, rng->maxVal);
+  RSIndexResult *hit;
+  t_docId filterNext = 0;
+  if (filter) {
+    filter->Rewind(filter->ctx);
+  }
+  int rc = IR_Read(ir, &hit);
+  while (rc != INDEXREAD_EOF) {
+    if (filter) {
+      // leapfrog between the leaf and the filter, both sorted by id
+      int frc = IndexIterator_HasDocId(filter, hit->docId, &filterNext);
+      if (frc == INDEXREAD_EOF) {
+        break;
+      } else if (frc != INDEXREAD_OK) {
+        rc = filterNext > hit->docId ? IR_SkipTo(ir, filterNext, &hit) : IR_Read(ir, &hit);
+        continue;
+      }
+    }
+    const RSDocumentMetadata *dmd = DocTable_Get(&ctx->spec->docs, hit->docId);
+    if (dmd && !(dmd->flags & Document_Deleted)) {
+      double xy[2];
+      decodeGeo(hit->num.value, xy);
+      double dist = geohashGetDistance(gf->lon, gf->lat, xy[0], xy[1]);
+      nearestHeapPush(h, (GeoNearestEntry){.dist = dist, .docId = hit->docId});
+    }
+    rc = IR_Read(ir, &hit);
+  }
+  IR_Free(ir);
+}
+
+static int cmpScoredDocId(const void *p1, const void *p2) {
+  const ScoredDocId *a = p1, *b = p2;
+  return a->docId < b->docId ? -1 : a->docId > b->docId;
+}
+
+IndexIterator *NewGeoNearestIterator(RedisSearchCtx *ctx, const GeoFilter *gf,
+                                     IndexIterator *filter) {
+  NumericRangeTree *t = OpenNumericIndexRead(ctx, gf->property, INDEXFLD_T_GEO);
+  if (!t) {
+    if (filter) filter->Free(filter);
+    return NULL;
+  }
+
+  // A document is only popped once it is nearer than all the nodes left, whose distances are
+  // lower bounds of the distances of their documents, so documents are popped by distance
+  GeoNearestHeap heap = {0};
+  size_t n = 0, cap = MIN(gf->k, 16);
+  ScoredDocId *results = rm_malloc(cap * sizeof(*results));
+  double unitFactor = extractUnitFactor(gf->unitType);
+  nearestPushNode(&heap, gf, t->root, NF_NEGATIVE_INFINITY, NF_INFINITY);
+  while (heap.len && n < gf->k) {
+    GeoNearestEntry e = nearestHeapPop(&heap);
+    if (!e.node) {
+      if (n == cap) {
+        cap = MIN(cap * 2, gf->k);
+        results = rm_realloc(results, cap * sizeof(*results));
+      }
+      results[n++] = (ScoredDocId){.docId = e.docId, .score = e.dist / unitFactor};
+    } else if (NumericRangeNode_IsLeaf(e.node)) {
+      if (e.node->range) {
+        nearestPushLeaf(&heap, ctx, gf, e.node->range, filter);
+      }
+    } else {
+      // values below the split are on the left
+      nearestPushNode(&heap, gf, e.node->left, e.min, MIN(e.max, e.node->value));
+      nearestPushNode(&heap, gf, e.node->right, MAX(e.min, e.node->value), e.max);
+    }
+  }
+  rm_free(heap.entries);
+  if (filter) {
+    filter->Free(filter);
+  }
+
+  qsort(results, n, sizeof(*results), cmpScoredDocId);
+  IndexIterator *it = NewScoredListIterator(results, n);
+  const FieldSpec *fs = IndexSpec_GetField(ctx->spec, gf->property, strlen(gf->property));
+  if (fs) {
+    ListIterator_SetDistanceField(it, fs);
+  }
+  return it;
+}
+
 GeoDistance GeoDistance_Parse(const char *s) {
 #define X(c, val)            \
   if (!strcasecmp(val, s)) { \
@@ -212,12 +680,30 @@ int GeoFilter_Validate(const GeoFilter *gf, QueryError *status) {
     return 0;
   }
 
+  if (gf->shape == GEO_SHAPE_BOX || gf->shape == GEO_SHAPE_POLYGON) {
+    // the bounding box of a polygon is that of its vertices
+    if (gf->minLat > gf->maxLat || gf->minLat < -90 || gf->maxLat > 90 || gf->minLon < -180 ||
+        gf->minLon > 180 || gf->maxLon < -180 || gf->maxLon > 180) {
+      QERR_MKSYNTAXERR(status, "Invalid GeoFilter lat/lon");
+      return 0;
+    }
+    return 1;
+  }
+
   // validate lat/lon
   if (gf->lat > 90 || gf->lat < -90 || gf->lon > 180 || gf->lon < -180) {
     QERR_MKSYNTAXERR(status, "Invalid GeoFilter lat/lon");
     return 0;
   }
 
+  if (gf->shape == GEO_SHAPE_NEAREST) {
+    if (gf->k == 0) {
+      QERR_MKSYNTAXERR(status, "Invalid GeoFilter number of nearest documents");
+      return 0;
+    }
+    return 1;
+  }
+
   // validate radius
   if (gf->radius <= 0) {
     QERR_MKSYNTAXERR(status, "Invalid GeoFilter radius");
@@ -291,6 +777,24 @@ int isWithinRadius(const GeoFilter *gf, double d, double *distance) {
   return rv;
 }
 
+int GeoFilter_Contains(const GeoFilter *gf, double d) {
+  double xy[2];
+  switch (gf->shape) {
+    case GEO_SHAPE_RADIUS:
+      return isWithinRadius(gf, d, NULL);
+    case GEO_SHAPE_BOX:
+      decodeGeo(d, xy);
+      return xy[1] >= gf->minLat && xy[1] <= gf->maxLat && lonWithin(xy[0], gf->minLon, gf->maxLon);
+    case GEO_SHAPE_POLYGON:
+      decodeGeo(d, xy);
+      return polygonContains(gf, xy[0], xy[1]);
+    case GEO_SHAPE_NEAREST:
+      // any point may be among the nearest
+      return 1;
+  }
+  return 0;
+}
+
 static int checkResult(const GeoFilter *gf, const RSIndexResult *cur) {
   double distance;
   if (cur->type == RSResultType_Numeric) {
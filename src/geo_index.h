@@ -31,12 +31,31 @@ typedef enum {  // Placeholder for bad/invalid unit
 #undef X
 } GeoDistance;
 
+typedef enum {
+  GEO_SHAPE_RADIUS,
+  GEO_SHAPE_BOX,
+  GEO_SHAPE_POLYGON,
+  GEO_SHAPE_NEAREST,
+} GeoShape;
+
 typedef struct GeoFilter {
   const char *property;
+  GeoShape shape;
   double lat;
   double lon;
   double radius;
   GeoDistance unitType;
+  // The bounding box of BOX and POLYGON filters. A box crosses the antimeridian when its minLon is
+  // above its maxLon
+  double minLon;
+  double minLat;
+  double maxLon;
+  double maxLat;
+  // The vertices of a POLYGON filter, as longitude and latitude pairs
+  double *points;
+  size_t numPoints;
+  // The number of documents of a NEAREST filter, the nearest to its point
+  size_t k;
   NumericFilter **numericFilters;
 } GeoFilter;
 
@@ -62,13 +81,26 @@ GeoDistance GeoDistance_Parse_Buffer(const char *s, size_t len);
  * sane, unit is valid. Return 1 if valid, 0 if not, and set the error string into err */
 int GeoFilter_Validate(const GeoFilter *gf, QueryError *status);
 
-/* Parse a geo filter from redis arguments. We assume the filter args start at argv[0] */
+/* Parse a geo filter from redis arguments. We assume the filter args start at argv[0]. The
+ * filter is either a radius, `<property> <lon> <lat> <radius> <unit>`, a bounding box,
+ * `<property> BOX <min lon> <min lat> <max lon> <max lat>`, a polygon,
+ * `<property> POLYGON <num points> <lon> <lat> ...`, or the nearest documents to a point,
+ * `<property> NEAREST <lon> <lat> <k> <unit>` */
 int GeoFilter_Parse(GeoFilter *gf, ArgsCursor *ac, QueryError *status);
 void GeoFilter_Free(GeoFilter *gf);
 IndexIterator *NewGeoRangeIterator(RedisSearchCtx *ctx, const GeoFilter *gf);
 
+/* Iterate the `k` documents of a NEAREST filter which are the nearest to its point, among the
+ * documents of `filter` if it is not NULL. The leaves of the geo index are visited best first,
+ * by their distance from the point, until no other leaf can be nearer than the k-th document.
+ * The results are distances in the unit of the filter. The filter is owned by the iterator */
+IndexIterator *NewGeoNearestIterator(RedisSearchCtx *ctx, const GeoFilter *gf,
+                                     IndexIterator *filter);
+
 /*****************************************************************************/
 
 #define INVALID_GEOHASH -1.0
 double calcGeoHash(double lon, double lat);
 int isWithinRadius(const GeoFilter *gf, double d, double *distance);
+/* Checks if the point of geohash d is in the shape of the filter */
+int GeoFilter_Contains(const GeoFilter *gf, double d);
@@ -10,6 +10,14 @@
 
 #include "rmalloc.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define SPARSE_INDEX(e) ((e) >> 8)
+#define SPARSE_RANK(e) ((uint8_t)((e)&0xff))
+#define SPARSE_ENTRY(index, rank) (((uint32_t)(index) << 8) | (rank))
+
 static __inline uint8_t _hll_rank(uint32_t hash, uint8_t bits) {
   uint8_t i;
 
@@ -30,22 +38,75 @@ int hll_init(struct HLL *hll, uint8_t bits) {
 
   hll->bits = bits;
   hll->size = (size_t)1 << bits;
-  hll->registers = rm_calloc(hll->size, 1);
+  hll->registers = NULL;
+  hll->sparse = NULL;
+  hll->sparse_len = hll->sparse_cap = 0;
 
   return 0;
 }
 
 void hll_destroy(struct HLL *hll) {
   rm_free(hll->registers);
+  rm_free(hll->sparse);
 
   hll->registers = NULL;
+  hll->sparse = NULL;
+  hll->sparse_len = hll->sparse_cap = 0;
+}
+
+void hll_densify(struct HLL *hll) {
+  uint32_t i;
+
+  if (hll->registers) return;
+
+  hll->registers = rm_calloc(hll->size, 1);
+  for (i = 0; i < hll->sparse_len; i++) {
+    hll->registers[SPARSE_INDEX(hll->sparse[i])] = SPARSE_RANK(hll->sparse[i]);
+  }
+  rm_free(hll->sparse);
+  hll->sparse = NULL;
+  hll->sparse_len = hll->sparse_cap = 0;
+}
+
+static void _hll_sparse_set(struct HLL *hll, uint32_t index, uint8_t rank) {
+  uint32_t lo = 0, hi = hll->sparse_len;
+
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (SPARSE_INDEX(hll->sparse[mid]) < index)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo < hll->sparse_len && SPARSE_INDEX(hll->sparse[lo]) == index) {
+    if (rank > SPARSE_RANK(hll->sparse[lo])) hll->sparse[lo] = SPARSE_ENTRY(index, rank);
+    return;
+  }
+
+  // Switch to dense registers once they take less memory than the sparse entries
+  if ((hll->sparse_len + 1) * sizeof(*hll->sparse) >= hll->size) {
+    hll_densify(hll);
+    hll->registers[index] = rank;
+    return;
+  }
+
+  if (hll->sparse_len == hll->sparse_cap) {
+    hll->sparse_cap = hll->sparse_cap ? hll->sparse_cap * 2 : 4;
+    hll->sparse = rm_realloc(hll->sparse, hll->sparse_cap * sizeof(*hll->sparse));
+  }
+  memmove(hll->sparse + lo + 1, hll->sparse + lo, (hll->sparse_len - lo) * sizeof(*hll->sparse));
+  hll->sparse[lo] = SPARSE_ENTRY(index, rank);
+  hll->sparse_len++;
 }
 
 static __inline void _hll_add_hash(struct HLL *hll, uint32_t hash) {
   uint32_t index = hash >> (32 - hll->bits);
   uint8_t rank = _hll_rank(hash, hll->bits);
 
-  if (rank > hll->registers[index]) {
+  if (!hll->registers) {
+    _hll_sparse_set(hll, index, rank);
+  } else if (rank > hll->registers[index]) {
     hll->registers[index] = rank;
   }
 }
@@ -81,17 +142,24 @@ double hll_count(const struct HLL *hll) {
 
   alpha_mm *= ((double)hll->size * (double)hll->size);
 
+  // Histogram of the register values, so that the sum only has a term per rank
+  uint32_t hist[64] = {0};
+  if (hll->registers) {
+    for (i = 0; i < hll->size; i++) hist[hll->registers[i] & 63]++;
+  } else {
+    hist[0] = hll->size - hll->sparse_len;
+    for (i = 0; i < hll->sparse_len; i++) hist[SPARSE_RANK(hll->sparse[i]) & 63]++;
+  }
+
   double sum = 0;
-  for (i = 0; i < hll->size; i++) {
-    sum += 1.0 / (1 << hll->registers[i]);
+  for (i = 0; i < 64; i++) {
+    if (hist[i]) sum += ldexp((double)hist[i], -(int)i);
   }
 
   double estimate = alpha_mm / sum;
 
   if (estimate <= 5.0 / 2.0 * (double)hll->size) {
-    int zeros = 0;
-
-    for (i = 0; i < hll->size; i++) zeros += (hll->registers[i] == 0);
+    uint32_t zeros = hist[0];
 
     if (zeros) estimate = (double)hll->size * log((double)hll->size / zeros);
 
@@ -110,7 +178,28 @@ int hll_merge(struct HLL *dst, const struct HLL *src) {
     return -1;
   }
 
-  for (i = 0; i < dst->size; i++) {
+  if (!src->registers) {
+    for (i = 0; i < src->sparse_len; i++) {
+      uint32_t e = src->sparse[i];
+      if (!dst->registers) {
+        _hll_sparse_set(dst, SPARSE_INDEX(e), SPARSE_RANK(e));
+      } else if (SPARSE_RANK(e) > dst->registers[SPARSE_INDEX(e)]) {
+        dst->registers[SPARSE_INDEX(e)] = SPARSE_RANK(e);
+      }
+    }
+    return 0;
+  }
+
+  hll_densify(dst);
+  i = 0;
+#if defined(__SSE2__)
+  for (; i + 16 <= dst->size; i += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i *)(dst->registers + i));
+    __m128i b = _mm_loadu_si128((const __m128i *)(src->registers + i));
+    _mm_storeu_si128((__m128i *)(dst->registers + i), _mm_max_epu8(a, b));
+  }
+#endif
+  for (; i < dst->size; i++) {
     if (src->registers[i] > dst->registers[i]) dst->registers[i] = src->registers[i];
   }
 
@@ -136,11 +225,15 @@ int hll_load(struct HLL *hll, const void *registers, size_t size) {
 
   if (hll_init(hll, bits) == -1) return -1;
 
+  hll->registers = rm_malloc(size);
   memcpy(hll->registers, registers, size);
 
   return 0;
 }
 
 extern uint32_t _hll_hash(const struct HLL *hll) {
+  if (!hll->registers) {
+    return rs_fnv_32a_buf(hll->sparse, hll->sparse_len * sizeof(*hll->sparse), 0);
+  }
   return rs_fnv_32a_buf(hll->registers, (uint32_t)hll->size, 0);
 }
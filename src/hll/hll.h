@@ -4,11 +4,21 @@
 #include <sys/types.h>
 #include <stdint.h>
 
+/*
+ * An HLL starts in a sparse representation: a sorted array of the non-zero
+ * registers, encoded as (index << 8 | rank). It is converted to the dense
+ * array of `size` registers once that would be smaller, so an HLL which only
+ * saw a few values stays small. `registers` is NULL while the HLL is sparse.
+ */
 struct HLL {
   uint8_t bits;
 
   size_t size;
   uint8_t *registers;
+
+  uint32_t *sparse;
+  uint32_t sparse_len;
+  uint32_t sparse_cap;
 };
 
 extern int hll_init(struct HLL *hll, uint8_t bits);
@@ -18,6 +28,8 @@ extern int hll_merge(struct HLL *dst, const struct HLL *src);
 extern void hll_add(struct HLL *hll, const void *buf, size_t size);
 void hll_add_hash(struct HLL *hll, uint32_t h);
 extern double hll_count(const struct HLL *hll);
+/* Convert to the dense representation, e.g. before reading `registers` */
+extern void hll_densify(struct HLL *hll);
 
 extern uint32_t _hll_hash(const struct HLL *hll);
 
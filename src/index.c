@@ -1056,10 +1056,21 @@ typedef struct {
   IndexCriteriaTester *childCT;
   t_docId lastDocId;
   t_docId maxDocId;
+  const Bitset *liveDocs;
   size_t len;
   double weight;
 } NotIterator, NotContext;
 
+/* Return the first id >= docId which belongs to a live document, or maxDocId + 1 if there is none.
+ * Without a live documents set every id is considered live */
+static inline t_docId nextLiveDocId(const Bitset *liveDocs, t_docId docId, t_docId maxDocId) {
+  if (!liveDocs || docId > maxDocId) {
+    return docId;
+  }
+  uint64_t id = Bitset_NextSet(liveDocs, docId);
+  return id > maxDocId ? maxDocId + 1 : id;
+}
+
 static void NI_Abort(void *ctx) {
   NotContext *nc = ctx;
   nc->child->Abort(nc->child->ctx);
@@ -1094,6 +1105,14 @@ static int NI_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
     return INDEXREAD_EOF;
   }
 
+  // A deleted document can never be a match
+  if (nc->liveDocs && !Bitset_Test(nc->liveDocs, docId)) {
+    nc->base.current->docId = docId;
+    nc->lastDocId = docId;
+    *hit = nc->base.current;
+    return INDEXREAD_NOTFOUND;
+  }
+
   // Get the child's last read docId
   // if lastDocId is 0, Read & Skipto weren't called yet and child lastId
   // might not be be updated (ex. NUMERIC filter) (PR-2440)
@@ -1167,34 +1186,44 @@ static size_t NI_NumEstimated(void *ctx) {
 
 static int NI_ReadUnsorted(void *ctx, RSIndexResult **hit) {
   NotContext *nc = ctx;
-  while (nc->lastDocId > nc->maxDocId) {
-    if (!nc->childCT->Test(nc->childCT, nc->lastDocId)) {
-      nc->base.current->docId = nc->lastDocId;
+  t_docId id = nc->lastDocId;
+  while ((id = nextLiveDocId(nc->liveDocs, id + 1, nc->maxDocId)) <= nc->maxDocId) {
+    nc->lastDocId = id;
+    if (!nc->childCT->Test(nc->childCT, id)) {
+      nc->base.current->docId = id;
       *hit = nc->base.current;
-      ++nc->lastDocId;
       return INDEXREAD_OK;
     }
-    ++nc->lastDocId;
   }
   return INDEXREAD_EOF;
 }
 
 /* Read from a NOT iterator. This is applicable only if the only or leftmost node of a query is a
- * NOT node. We simply read until max docId, skipping docIds that exist in the child*/
+ * NOT node. We simply read until max docId, skipping docIds that exist in the child, and ids of
+ * deleted documents if we have the live documents set */
 static int NI_ReadSorted(void *ctx, RSIndexResult **hit) {
   NotContext *nc = ctx;
   if (nc->lastDocId > nc->maxDocId) return INDEXREAD_EOF;
 
   RSIndexResult *cr = NULL;
-  // if we have a child, get the latest result from the child
+  // if we have a child, get the latest result from the child. After a rewind, the child's
+  // current record is stale
   cr = IITER_CURRENT_RECORD(nc->child);
 
-  if (cr == NULL || cr->docId == 0) {
+  if (cr == NULL || cr->docId == 0 || nc->lastDocId == 0) {
     nc->child->Read(nc->child->ctx, &cr);
   }
 
-  // advance our reader by one, and let's test if it's a valid value or not
-  nc->base.current->docId++;
+  // advance our reader to the next live id, and let's test if it's a valid value or not
+  nc->base.current->docId =
+      nextLiveDocId(nc->liveDocs, nc->base.current->docId + 1, nc->maxDocId);
+
+  // If we jumped over deleted ids, the child might be behind us. Bring it up to our id
+  if (cr && cr->docId < nc->base.current->docId && IITER_HAS_NEXT(nc->child)) {
+    if (nc->child->SkipTo(nc->child->ctx, nc->base.current->docId, &cr) == INDEXREAD_EOF) {
+      goto ok;
+    }
+  }
 
   // If we don't have a child result, or the child result is ahead of the current counter,
   // we just increment our virtual result's id until we hit the child result's
@@ -1205,10 +1234,14 @@ static int NI_ReadSorted(void *ctx, RSIndexResult **hit) {
 
   while (cr->docId == nc->base.current->docId) {
     // advance our docId to the next possible id
-    nc->base.current->docId++;
+    nc->base.current->docId =
+        nextLiveDocId(nc->liveDocs, nc->base.current->docId + 1, nc->maxDocId);
 
     // read the next entry from the child
-    if (nc->child->Read(nc->child->ctx, &cr) == INDEXREAD_EOF) {
+    int rc = cr->docId < nc->base.current->docId - 1
+                 ? nc->child->SkipTo(nc->child->ctx, nc->base.current->docId, &cr)
+                 : nc->child->Read(nc->child->ctx, &cr);
+    if (rc == INDEXREAD_EOF) {
       break;
     }
   }
@@ -1247,7 +1280,8 @@ static t_docId NI_LastDocId(void *ctx) {
   return nc->lastDocId;
 }
 
-IndexIterator *NewNotIterator(IndexIterator *it, t_docId maxDocId, double weight) {
+IndexIterator *NewNotIterator(IndexIterator *it, t_docId maxDocId, DocTable *dt,
+                              double weight) {
   NotContext *nc = rm_malloc(sizeof(*nc));
   nc->base.current = NewVirtualResult(weight);
   nc->base.current->fieldMask = RS_FIELDMASK_ALL;
@@ -1256,6 +1290,7 @@ IndexIterator *NewNotIterator(IndexIterator *it, t_docId maxDocId, double weight
   nc->childCT = NULL;
   nc->lastDocId = 0;
   nc->maxDocId = maxDocId;
+  nc->liveDocs = dt ? &dt->liveDocs : NULL;
   nc->len = 0;
   nc->weight = weight;
 
@@ -1296,6 +1331,7 @@ typedef struct {
   t_docId lastDocId;
   t_docId maxDocId;
   t_docId nextRealId;
+  const Bitset *liveDocs;
   double weight;
 } OptionalMatchContext, OptionalIterator;
 
@@ -1387,7 +1423,8 @@ static size_t OI_NumEstimated(void *ctx) {
 static int OI_ReadUnsorted(void *ctx, RSIndexResult **hit) {
   OptionalMatchContext *nc = ctx;
   if (nc->lastDocId >= nc->maxDocId) return INDEXREAD_EOF;
-  nc->lastDocId++;
+  nc->lastDocId = nextLiveDocId(nc->liveDocs, nc->lastDocId + 1, nc->maxDocId);
+  if (nc->lastDocId > nc->maxDocId) return INDEXREAD_EOF;
   nc->base.current = nc->virt;
   nc->base.current->docId = nc->lastDocId;
   *hit = nc->base.current;
@@ -1407,11 +1444,18 @@ static int OI_ReadSorted(void *ctx, RSIndexResult **hit) {
     return INDEXREAD_EOF;
   }
 
-  // Increase the size by one
-  nc->lastDocId++;
+  // Advance to the next live document
+  nc->lastDocId = nextLiveDocId(nc->liveDocs, nc->lastDocId + 1, nc->maxDocId);
+  if (nc->lastDocId > nc->maxDocId) {
+    return INDEXREAD_EOF;
+  }
 
   if (nc->lastDocId > nc->nextRealId) {
     int rc = nc->child->Read(nc->child->ctx, &nc->base.current);
+    if (rc != INDEXREAD_EOF && nc->base.current->docId < nc->lastDocId) {
+      // we jumped over deleted ids, so the child is still behind us
+      rc = nc->child->SkipTo(nc->child->ctx, nc->lastDocId, &nc->base.current);
+    }
     if (rc == INDEXREAD_EOF) {
       nc->nextRealId = nc->maxDocId + 1;
     } else {
@@ -1467,7 +1511,8 @@ static void OI_Rewind(void *ctx) {
   }
 }
 
-IndexIterator *NewOptionalIterator(IndexIterator *it, t_docId maxDocId, double weight) {
+IndexIterator *NewOptionalIterator(IndexIterator *it, t_docId maxDocId, DocTable *dt,
+                                   double weight) {
   OptionalMatchContext *nc = rm_calloc(1, sizeof(*nc));
   nc->virt = NewVirtualResult(weight);
   nc->virt->fieldMask = RS_FIELDMASK_ALL;
@@ -1477,6 +1522,7 @@ IndexIterator *NewOptionalIterator(IndexIterator *it, t_docId maxDocId, double w
   nc->childCT = NULL;
   nc->lastDocId = 0;
   nc->maxDocId = maxDocId;
+  nc->liveDocs = dt ? &dt->liveDocs : NULL;
   nc->weight = weight;
   nc->nextRealId = 0;
 
@@ -1509,11 +1555,14 @@ IndexIterator *NewOptionalIterator(IndexIterator *it, t_docId maxDocId, double w
  * it
  * without a positive expression. So we create a wildcard iterator that basically just iterates
  * all
- * the incremental document ids, and matches every skip within its range. */
+ * the incremental document ids, and matches every skip within its range. If we have the live
+ * documents set, ids of deleted documents are skipped a word at a time. */
 typedef struct {
   IndexIterator base;
+  const Bitset *liveDocs;
   t_docId topId;
   t_docId current;
+  size_t numDocs;
 } WildcardIterator, WildcardIteratorCtx;
 
 /* Free a wildcard iterator */
@@ -1527,6 +1576,7 @@ static void WI_Free(IndexIterator *it) {
 /* Read reads the next consecutive id, unless we're at the end */
 static int WI_Read(void *ctx, RSIndexResult **hit) {
   WildcardIteratorCtx *nc = ctx;
+  nc->current = nextLiveDocId(nc->liveDocs, nc->current, nc->topId);
   if (nc->current > nc->topId) {
     return INDEXREAD_EOF;
   }
@@ -1548,12 +1598,14 @@ static int WI_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
 
   if (docId == 0) return WI_Read(ctx, hit);
 
-  nc->current = docId;
-  CURRENT_RECORD(nc)->docId = docId;
+  nc->current = nextLiveDocId(nc->liveDocs, docId, nc->topId);
+  if (nc->current > nc->topId) return INDEXREAD_EOF;
+
+  CURRENT_RECORD(nc)->docId = nc->current;
   if (hit) {
     *hit = CURRENT_RECORD(nc);
   }
-  return INDEXREAD_OK;
+  return nc->current == docId ? INDEXREAD_OK : INDEXREAD_NOTFOUND;
 }
 
 static void WI_Abort(void *ctx) {
@@ -1571,7 +1623,7 @@ static int WI_HasNext(void *ctx) {
 /* Our len is the len of the index... */
 static size_t WI_Len(void *ctx) {
   WildcardIteratorCtx *nc = ctx;
-  return nc->topId;
+  return nc->numDocs;
 }
 
 /* Last docId */
@@ -1591,10 +1643,12 @@ static size_t WI_NumEstimated(void *p) {
 }
 
 /* Create a new wildcard iterator */
-IndexIterator *NewWildcardIterator(t_docId maxId) {
+IndexIterator *NewWildcardIterator(t_docId maxId, DocTable *dt) {
   WildcardIteratorCtx *c = rm_calloc(1, sizeof(*c));
   c->current = 1;
   c->topId = maxId;
+  c->liveDocs = dt ? &dt->liveDocs : NULL;
+  c->numDocs = dt ? Bitset_CountUpTo(c->liveDocs, maxId) : maxId;
 
   CURRENT_RECORD(c) = NewVirtualResult(1);
   CURRENT_RECORD(c)->freq = 1;
@@ -1654,6 +1708,29 @@ IndexIterator *NewEmptyIterator(void) {
   return &eofIterator;
 }
 
+int IndexIterator_HasDocId(IndexIterator *it, t_docId docId, t_docId *nextId) {
+  if (*nextId == UINT64_MAX) {
+    return INDEXREAD_EOF;
+  } else if (*nextId > docId) {
+    return INDEXREAD_NOTFOUND;
+  } else if (*nextId == docId) {
+    return INDEXREAD_OK;
+  }
+  // The id of a NOTFOUND skip is not a match, whatever LastDocId() says: a NOT iterator stays on
+  // the ids it rejects. Other iterators move to their next document, which is a match
+  RSIndexResult *hit;
+  int rc = it->SkipTo(it->ctx, docId, &hit);
+  if (rc == INDEXREAD_EOF) {
+    *nextId = UINT64_MAX;
+  } else if (rc == INDEXREAD_NOTFOUND) {
+    t_docId lastId = it->LastDocId(it->ctx);
+    if (lastId > docId) {
+      *nextId = lastId;
+    }
+  }
+  return rc;
+}
+
 // LCOV_EXCL_START unused
 const char *IndexIterator_GetTypeString(const IndexIterator *it) {
   if (it->Free == UnionIterator_Free) {
@@ -47,18 +47,22 @@ IndexIterator *NewUnionIterator(IndexIterator **its, int num, DocTable *t, int q
 IndexIterator *NewIntersecIterator(IndexIterator **its, size_t num, DocTable *t,
                                    t_fieldMask fieldMask, int maxSlop, int inOrder, double weight);
 
-/* Create a NOT iterator by wrapping another index iterator */
-IndexIterator *NewNotIterator(IndexIterator *it, t_docId maxDocId, double weight);
+/* Create a NOT iterator by wrapping another index iterator. If a DocTable is given, only ids of
+ * live documents are returned */
+IndexIterator *NewNotIterator(IndexIterator *it, t_docId maxDocId, DocTable *dt, double weight);
 
 /* Create an Optional clause iterator by wrapping another index iterator. An optional iterator
- * always returns OK on skips, but a virtual hit with frequency of 0 if there is no hit */
-IndexIterator *NewOptionalIterator(IndexIterator *it, t_docId maxDocId, double weight);
+ * always returns OK on skips, but a virtual hit with frequency of 0 if there is no hit. If a
+ * DocTable is given, reads only return ids of live documents */
+IndexIterator *NewOptionalIterator(IndexIterator *it, t_docId maxDocId, DocTable *dt,
+                                   double weight);
 
 /* Create a wildcard iterator, matching ALL documents in the index. This is used for one thing only
  * - purely negative queries. If the root of the query is a negative expression, we cannot process
  * it without a positive expression. So we create a wildcard iterator that basically just iterates
- * all the incremental document ids, and matches every skip within its range. */
-IndexIterator *NewWildcardIterator(t_docId maxId);
+ * all the incremental document ids, and matches every skip within its range. If a DocTable is
+ * given, ids of deleted documents are skipped using its live documents set. */
+IndexIterator *NewWildcardIterator(t_docId maxId, DocTable *dt);
 
 /* Create a new IdListIterator from a pre populated list of document ids of size num. The doc ids
  * are sorted in this function, so there is no need to sort them. They are automatically freed in
@@ -68,6 +72,14 @@ IndexIterator *NewIdListIterator(t_docId *ids, t_offset num, double weight);
 /** Create a new iterator which returns no results */
 IndexIterator *NewEmptyIterator(void);
 
+/**
+ * Whether the iterator has a document, for documents tested in increasing id order after a
+ * Rewind, by skipping the iterator to them. `nextId` keeps, between calls, the document a skip
+ * which didn't find its id left the iterator on, and starts at 0. Returns INDEXREAD_OK,
+ * INDEXREAD_NOTFOUND, or INDEXREAD_EOF once the iterator has no more documents.
+ */
+int IndexIterator_HasDocId(IndexIterator *it, t_docId docId, t_docId *nextId);
+
 /** Return a string containing the type of the iterator */
 const char *IndexIterator_GetTypeString(const IndexIterator *it);
 
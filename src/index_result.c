@@ -3,6 +3,7 @@
 #include "rmalloc.h"
 #include <math.h>
 #include <sys/param.h>
+#include <string.h>
 
 /* Allocate a new aggregate result of a given type with a given capacity*/
 RSIndexResult *__newAggregateResult(size_t cap, RSResultType t, double weight) {
@@ -88,7 +89,7 @@ RSIndexResult *NewDistanceResult() {
                          .freq = 1,
                          .weight = 1,
 
-                         .num = (RSNumericRecord){.value = 0}};
+                         .dist = (RSDistanceRecord){.value = 0}};
   return res;
 }
 
@@ -330,117 +331,168 @@ size_t IndexResult_GetMatchedTerms(RSIndexResult *r, RSQueryTerm **arr, size_t c
   return arrlen;
 }
 
-int __indexResult_withinRangeInOrder(RSOffsetIterator *iters, uint32_t *positions, int num,
-                                     int maxSlop) {
-  while (1) {
-
-    // we start from the beginning, and a span of 0
-    int span = 0;
-    for (int i = 0; i < num; i++) {
-      // take the current position and the position of the previous iterator.
-      // For the first iterator we always advance once
-      uint32_t pos = i ? positions[i] : iters[i].Next(iters[i].ctx, NULL);
-      uint32_t lastPos = i ? positions[i - 1] : 0;
-      // printf("Before: i=%d, pos=%d, lastPos %d\n", i, pos, lastPos);
-
-      // read while we are not in order
-      while (pos != RS_OFFSETVECTOR_EOF && pos < lastPos) {
-        pos = iters[i].Next(iters[i].ctx, NULL);
-        // printf("Reading: i=%d, pos=%d, lastPos %d\n", i, pos, lastPos);
-      }
-      // printf("i=%d, pos=%d, lastPos %d\n", i, pos, lastPos);
-
-      // we've read through the entire list and it's not in order relative to the last pos
-      if (pos == RS_OFFSETVECTOR_EOF) {
-        return 0;
-      }
-      positions[i] = pos;
-
-      // add the diff from the last pos to the total span
-      if (i > 0) {
-        span += ((int)pos - (int)lastPos - 1);
-        // if we are already out of slop - just quit
-        if (span > maxSlop) {
-          break;
-        }
+/* Upper bound on the number of offsets a result can yield. Every encoded offset takes at least one
+ * byte, so the encoded length of the term offset vectors is enough */
+static size_t indexResult_maxOffsets(const RSIndexResult *r) {
+  switch (r->type) {
+    case RSResultType_Term:
+      return r->term.offsets.len;
+    case RSResultType_Intersection:
+    case RSResultType_Union: {
+      size_t n = 0;
+      for (int i = 0; i < r->agg.numChildren; i++) {
+        n += indexResult_maxOffsets(r->agg.children[i]);
       }
+      return n;
     }
+    case RSResultType_Virtual:
+    case RSResultType_Numeric:
+    default:
+      return 0;
+  }
+}
 
-    if (span <= maxSlop) {
-      return 1;
+/* Decode all the offsets of a result into a flat sorted array, returning the number of offsets.
+ * Term records are decoded directly from their varint buffer, without an offset iterator */
+static size_t indexResult_decodeOffsets(const RSIndexResult *r, uint32_t *out) {
+  size_t n = 0;
+  if (r->type == RSResultType_Term) {
+    Buffer b = {.data = r->term.offsets.data,
+                .offset = r->term.offsets.len,
+                .cap = r->term.offsets.len};
+    BufferReader br = NewBufferReader(&b);
+    uint32_t last = 0;
+    while (!BufferReader_AtEnd(&br)) {
+      last += ReadVarint(&br);
+      out[n++] = last;
     }
+    return n;
   }
 
-  return 0;
+  RSOffsetIterator it = RSIndexResult_IterateOffsets(r);
+  uint32_t pos;
+  while ((pos = it.Next(it.ctx, NULL)) != RS_OFFSETVECTOR_EOF) {
+    out[n++] = pos;
+  }
+  it.Free(it.ctx);
+  return n;
 }
 
-static inline uint32_t _arrayMin(uint32_t *arr, int len, uint32_t *pos) {
-  int m = arr[0];
-  *pos = 0;
-  for (int i = 1; i < len; i++) {
-    if (arr[i] < m) {
-      m = arr[i];
-      *pos = i;
+/* Return the index of the first position >= target in arr[from, len), or len if there is none.
+ * We gallop forward and then binary search, since consecutive lookups are usually close */
+static inline size_t positions_seek(const uint32_t *arr, size_t from, size_t len,
+                                    uint32_t target) {
+  if (from >= len || arr[from] >= target) {
+    return from;
+  }
+  // arr[lo] < target always holds
+  size_t lo = from, step = 1;
+  size_t hi = from + step;
+  while (hi < len && arr[hi] < target) {
+    lo = hi;
+    step <<= 1;
+    hi = lo + step;
+  }
+  if (hi > len) hi = len;
+  while (hi - lo > 1) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (arr[mid] < target) {
+      lo = mid;
+    } else {
+      hi = mid;
     }
   }
-  return m;
+  return hi;
 }
 
-static inline uint32_t _arrayMax(uint32_t *arr, int len, uint32_t *pos) {
-  int m = arr[0];
-  *pos = 0;
-  for (int i = 1; i < len; i++) {
-    if (arr[i] >= m) {
-      m = arr[i];
-      *pos = i;
+/* Check the decoded positions for maximal slop, in order. For every position of the first term we
+ * greedily pick the closest following position of every other term. Since both the start and the
+ * picked positions only move forward, each term's positions are scanned at most once */
+static int positions_withinRangeInOrder(uint32_t **positions, size_t *lens, int num,
+                                        int maxSlop) {
+  size_t cursors[num];
+  memset(cursors, 0, sizeof(cursors));
+
+  for (size_t start = 0; start < lens[0]; start++) {
+    uint32_t lastPos = positions[0][start];
+    // we start from the beginning, and a span of 0
+    int span = 0;
+    int i;
+    for (i = 1; i < num; i++) {
+      size_t c = cursors[i] = positions_seek(positions[i], cursors[i], lens[i], lastPos);
+      // we've read through the entire list and it's not in order relative to the last pos. A
+      // later start can only be worse, so there is no match
+      if (c == lens[i]) {
+        return 0;
+      }
+      uint32_t pos = positions[i][c];
+      // add the diff from the last pos to the total span
+      span += ((int)pos - (int)lastPos - 1);
+      // if we are already out of slop - try the next start
+      if (span > maxSlop) {
+        break;
+      }
+      lastPos = pos;
+    }
+
+    if (i == num) {
+      return 1;
     }
   }
-  return m;
+
+  return 0;
 }
 
-/* Check the index result for maximal slop, in an unordered fashion.
+/* Check the decoded positions for maximal slop, in an unordered fashion.
  * The algorithm is simple - we find the first offsets min and max such that max-min<=maxSlop */
-int __indexResult_withinRangeUnordered(RSOffsetIterator *iters, uint32_t *positions, int num,
-                                       int maxSlop) {
+static int positions_withinRangeUnordered(uint32_t **positions, size_t *lens, int num,
+                                          int maxSlop) {
+  size_t cursors[num];
+  uint32_t max = 0;
   for (int i = 0; i < num; i++) {
-    positions[i] = iters[i].Next(iters[i].ctx, NULL);
+    if (!lens[i]) {
+      return 0;
+    }
+    cursors[i] = 0;
+    max = MAX(max, positions[i][0]);
   }
-  uint32_t minPos, maxPos, min, max;
-  // find the max member
-  max = _arrayMax(positions, num, &maxPos);
 
   while (1) {
+    // find the min member
+    int minIdx = 0;
+    uint32_t min = positions[0][cursors[0]];
+    for (int i = 1; i < num; i++) {
+      uint32_t pos = positions[i][cursors[i]];
+      if (pos < min) {
+        min = pos;
+        minIdx = i;
+      }
+    }
 
-    // we start from the beginning, and a span of 0
-    min = _arrayMin(positions, num, &minPos);
     if (min != max) {
       // calculate max - min
       int span = (int)max - (int)min - (num - 1);
-      // printf("maxslop %d min %d, max %d, minPos %d, maxPos %d, span %d\n", maxSlop, min, max,
-      //        minPos, maxPos, span);
       // if it matches the condition - just return success
       if (span <= maxSlop) {
         return 1;
       }
     }
 
-    // if we are not meeting the conditions - advance the minimal iterator
-    positions[minPos] = iters[minPos].Next(iters[minPos].ctx, NULL);
-    // If the minimal iterator is larger than the max iterator, the minimal iterator is the new
-    // maximal iterator.
-    if (positions[minPos] != RS_OFFSETVECTOR_EOF && positions[minPos] > max) {
-      maxPos = minPos;
-      max = positions[maxPos];
-
-    } else if (positions[minPos] == RS_OFFSETVECTOR_EOF) {
-      // this means we've reached the end
-      break;
+    // if we are not meeting the conditions - advance the minimal term. If it has no more
+    // positions we've reached the end
+    if (++cursors[minIdx] == lens[minIdx]) {
+      return 0;
     }
+    // If the minimal term is larger than the max, it is the new max
+    max = MAX(max, positions[minIdx][cursors[minIdx]]);
   }
 
   return 0;
 }
 
+// Results with up to this many offsets in total are decoded on the stack
+#define POSITIONS_STACK_SIZE 256
+
 /** Test the result offset vectors to see if they fall within a max "slop" or distance between the
  * terms. That is the total number of non matched offsets between the terms is no bigger than
  * maxSlop.
@@ -456,16 +508,14 @@ int IndexResult_IsWithinRange(RSIndexResult *ir, int maxSlop, int inOrder) {
   RSAggregateResult *r = &ir->agg;
   int num = r->numChildren;
 
-  // Fill a list of iterators and the last read positions
-  RSOffsetIterator iters[num];
-  uint32_t positions[num];
+  // Collect only the children that can have offsets, and size a single buffer for all of them
+  const RSIndexResult *children[num];
+  size_t total = 0;
   int n = 0;
   for (int i = 0; i < num; i++) {
-    // collect only iterators for nodes that can have offsets
     if (RSIndexResult_HasOffsets(r->children[i])) {
-      iters[n] = RSIndexResult_IterateOffsets(r->children[i]);
-      positions[n] = 0;
-      n++;
+      children[n++] = r->children[i];
+      total += indexResult_maxOffsets(r->children[i]);
     }
   }
 
@@ -474,15 +524,28 @@ int IndexResult_IsWithinRange(RSIndexResult *ir, int maxSlop, int inOrder) {
     return 1;
   }
 
+  uint32_t stackBuf[POSITIONS_STACK_SIZE];
+  uint32_t *buf = total <= POSITIONS_STACK_SIZE ? stackBuf : rm_malloc(total * sizeof(*buf));
+
+  // Decode the offsets of every child into its own slice of the buffer
+  uint32_t *positions[n];
+  size_t lens[n];
+  uint32_t *cur = buf;
+  for (int i = 0; i < n; i++) {
+    positions[i] = cur;
+    lens[i] = indexResult_decodeOffsets(children[i], cur);
+    cur += lens[i];
+  }
+
   int rc;
   // cal the relevant algorithm based on ordered/unordered condition
   if (inOrder)
-    rc = __indexResult_withinRangeInOrder(iters, positions, n, maxSlop);
+    rc = positions_withinRangeInOrder(positions, lens, n, maxSlop);
   else
-    rc = __indexResult_withinRangeUnordered(iters, positions, n, maxSlop);
+    rc = positions_withinRangeUnordered(positions, lens, n, maxSlop);
   // printf("slop result for %d: %d\n", ir->docId, rc);
-  for (int i = 0; i < n; i++) {
-    iters[i].Free(iters[i].ctx);
+  if (buf != stackBuf) {
+    rm_free(buf);
   }
   return rc;
 }
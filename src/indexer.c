@@ -258,8 +258,11 @@ static RSDocumentMetadata *makeDocumentId(RSAddDocumentCtx *aCtx, RedisSearchCtx
         for (int i = 0; i < spec->numFields; ++i) {
           if (spec->fields[i].types == INDEXFLD_T_VECTOR) {
             RedisModuleString * rmstr = RedisModule_CreateString(RSDummyContext, spec->fields[i].name, strlen(spec->fields[i].name));
-            VecSimIndex *vecsim = OpenVectorIndex(sctx, rmstr);
-            VecSimIndex_DeleteVector(vecsim, dmd->id);
+            if (spec->fields[i].vecQuant != VectorQuant_None) {
+              QuantizedVectors_Delete(OpenQuantizedVectors(sctx, rmstr), dmd->id);
+            } else {
+              VectorIndex_DeleteVector(OpenVectorIndex(sctx, rmstr), dmd->id);
+            }
             RedisModule_FreeString(RSDummyContext, rmstr);
             // TODO: use VecSimReplace instead and if successful, do not insert and remove from doc
           }
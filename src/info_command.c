@@ -166,13 +166,16 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
       REPLY_KVSTR(nn, "ALGORITHM", VecSimAlgorithm_ToString(fs->vecSimParams.algo));
       switch (fs->vecSimParams.algo) {
         case VecSimAlgo_BF:
-          REPLY_KVSTR(nn, VECSIM_TYPE, VecSimType_ToString(fs->vecSimParams.bfParams.type));
+          REPLY_KVSTR(nn, VECSIM_TYPE, VectorField_TypeToString(fs));
           REPLY_KVNUM(nn, VECSIM_DIM, fs->vecSimParams.bfParams.dim);
           REPLY_KVSTR(nn, VECSIM_DISTANCE_METRIC, VecSimMetric_ToString(fs->vecSimParams.bfParams.metric));
           REPLY_KVNUM(nn, VECSIM_BLOCKSIZE, fs->vecSimParams.bfParams.blockSize);
+          if (fs->vecQuant == VectorQuant_Int8) {
+            REPLY_KVSTR(nn, VECSIM_QUANTIZE, VECSIM_QUANT_INT8);
+          }
           break;
         case VecSimAlgo_HNSWLIB: {
-          REPLY_KVSTR(nn, VECSIM_TYPE, VecSimType_ToString(fs->vecSimParams.hnswParams.type));
+          REPLY_KVSTR(nn, VECSIM_TYPE, VectorField_TypeToString(fs));
           REPLY_KVNUM(nn, VECSIM_DIM, fs->vecSimParams.hnswParams.dim);
           REPLY_KVSTR(nn, VECSIM_DISTANCE_METRIC, VecSimMetric_ToString(fs->vecSimParams.hnswParams.metric));
           REPLY_KVNUM(nn, VECSIM_M, fs->vecSimParams.hnswParams.M);
@@ -216,6 +219,8 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   REPLY_KVNUM(n, "sortable_values_size_mb", sp->docs.sortablesSize / (float)0x100000);
 
   REPLY_KVNUM(n, "key_table_size_mb", TrieMap_MemUsage(sp->docs.dim.tm) / (float)0x100000);
+  REPLY_KVNUM(n, "quantized_vectors_sz_mb",
+              IndexSpec_QuantizedVectorsMemUsage(sp) / (float)0x100000);
   REPLY_KVNUM(n, "records_per_doc_avg",
               (float)sp->stats.numRecords / (float)sp->stats.numDocuments);
   REPLY_KVNUM(n, "bytes_per_record_avg",
@@ -61,6 +61,7 @@ InvertedIndex *NewInvertedIndex(IndexFlags flags, int initBlock) {
 
 void indexBlock_Free(IndexBlock *blk) {
   Buffer_Free(&blk->buf);
+  Buffer_Free(&blk->offsetsBuf);
 }
 
 void InvertedIndex_Free(void *ctx) {
@@ -104,7 +105,7 @@ void IndexReader_OnReopen(void *privdata) {
 
   // the gc marker tells us if there is a chance the keys has undergone GC while we were asleep
   if (ir->gcMarker == ir->idx->gcMarker) {
-    // no GC - we just go to the same offset we were at
+    // no GC - we just go to the same offset we were at. The offsets stream position is kept as is
     size_t offset = ir->br.pos;
     ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
     ir->br.pos = offset;
@@ -117,6 +118,7 @@ void IndexReader_OnReopen(void *privdata) {
     ir->currentBlock = 0;
     ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
     ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
+    ir->offsetsPos = 0;
 
     // seek to the previous last id
     RSIndexResult *dummy = NULL;
@@ -148,6 +150,18 @@ ENCODER(encodeFullWide) {
   return sz;
 }
 
+// 1a. Same as the full encoding, but the offset vector itself goes to the block's offsets stream,
+// which is written by InvertedIndex_WriteEntryGeneric
+ENCODER(encodeFullSplit) {
+  return qint_encode4(bw, delta, res->freq, (uint32_t)res->fieldMask, res->offsetsSz);
+}
+
+ENCODER(encodeFullSplitWide) {
+  size_t sz = qint_encode3(bw, delta, res->freq, res->offsetsSz);
+  sz += WriteVarintFieldMask(res->fieldMask, bw);
+  return sz;
+}
+
 // 2. (Frequency, Field)
 ENCODER(encodeFreqsFields) {
   return qint_encode3(bw, (uint32_t)delta, (uint32_t)res->freq, (uint32_t)res->fieldMask);
@@ -365,10 +379,10 @@ IndexEncoder InvertedIndex_GetEncoder(IndexFlags flags) {
   switch (flags & INDEX_STORAGE_MASK) {
     // 1. Full encoding - docId, freq, flags, offset
     case Index_StoreFreqs | Index_StoreTermOffsets | Index_StoreFieldFlags:
-      return encodeFull;
+      return (flags & Index_SplitTermOffsets) ? encodeFullSplit : encodeFull;
 
     case Index_StoreFreqs | Index_StoreTermOffsets | Index_StoreFieldFlags | Index_WideSchema:
-      return encodeFullWide;
+      return (flags & Index_SplitTermOffsets) ? encodeFullSplitWide : encodeFullWide;
 
     // 2. (Frequency, Field)
     case Index_StoreFreqs | Index_StoreFieldFlags:
@@ -459,6 +473,10 @@ size_t InvertedIndex_WriteEntryGeneric(InvertedIndex *idx, IndexEncoder encoder,
 
   // printf("Writing docId %llu, delta %llu, flags %x\n", docId, delta, (int)idx->flags);
   size_t ret = encoder(&bw, delta, entry);
+  if (INDEX_SPLIT_OFFSETS(idx->flags)) {
+    BufferWriter obw = NewBufferWriter(&blk->offsetsBuf);
+    ret += Buffer_Write(&obw, entry->term.offsets.data, entry->term.offsets.len);
+  }
 
   idx->lastId = docId;
   blk->lastId = docId;
@@ -500,6 +518,7 @@ static void IndexReader_AdvanceBlock(IndexReader *ir) {
   ir->currentBlock++;
   ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
   ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
+  ir->offsetsPos = 0;
 }
 
 /******************************************************************************
@@ -607,6 +626,66 @@ done:
   return rc;
 }
 
+/**
+ * Split offsets: the record only holds the length of its offset vector. The reader points
+ * `term.offsets` into the block's offsets stream, so the offset bytes are never touched unless a
+ * consumer (phrase, slop, highlighting) actually iterates them.
+ */
+DECODER(readFreqOffsetsFlagsSplit) {
+  qint_decode4(br, (uint32_t *)&res->docId, &res->freq, (uint32_t *)&res->fieldMask,
+               &res->offsetsSz);
+  res->term.offsets.len = res->offsetsSz;
+  CHECK_FLAGS(ctx, res);
+}
+
+DECODER(readFreqOffsetsFlagsSplitWide) {
+  qint_decode3(br, (uint32_t *)&res->docId, &res->freq, &res->offsetsSz);
+  res->fieldMask = ReadVarintFieldMask(br);
+  res->term.offsets.len = res->offsetsSz;
+  CHECK_FLAGS(ctx, res);
+}
+
+SKIPPER(seekFreqOffsetsFlagsSplit) {
+  uint32_t did = 0, freq = 0, offsz = 0;
+  t_fieldMask fm = 0;
+  t_docId lastId = ir->lastId;
+  size_t offsetsPos = ir->offsetsPos;
+  int rc = 0;
+
+  t_fieldMask num = ctx->num;
+
+  while (!BufferReader_AtEnd(br)) {
+    size_t oldpos = br->pos;
+    qint_decode4(br, &did, &freq, (uint32_t *)&fm, &offsz);
+    offsetsPos += offsz;
+
+    if (oldpos == 0 && did != 0) {
+      // Old RDB: Delta is not 0, but the docid itself
+      lastId = did;
+    } else {
+      lastId = (did += lastId);
+    }
+
+    if ((num & fm) && did >= expid) {
+      // overshoot
+      rc = 1;
+      break;
+    }
+  }
+
+  res->docId = did;
+  res->freq = freq;
+  res->fieldMask = fm;
+  res->offsetsSz = offsz;
+  res->term.offsets.data = IR_CURRENT_BLOCK(ir).offsetsBuf.data + offsetsPos - offsz;
+  res->term.offsets.len = offsz;
+
+  // sync back!
+  ir->lastId = lastId;
+  ir->offsetsPos = offsetsPos;
+  return rc;
+}
+
 DECODER(readFreqOffsetsFlagsWide) {
   uint32_t maskSz;
 
@@ -661,7 +740,9 @@ DECODER(readNumeric) {
       // printf("Checking against filter: %d\n", rv);
       return rv;
     } else {
-      return isWithinRadius(f->geoFilter, res->num.value, NULL);
+      // points outside of the covering cell are cheaper to skip before decoding them
+      return NumericFilter_Match(f, res->num.value) &&
+             GeoFilter_Contains(f->geoFilter, res->num.value);
     }
   }
   // printf("Field matches.. hurray!\n");
@@ -781,9 +862,15 @@ IndexDecoderProcs InvertedIndex_GetDecoder(uint32_t flags) {
 
     // (freqs, fields, offset)
     case Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets:
+      if (flags & Index_SplitTermOffsets) {
+        RETURN_DECODERS(readFreqOffsetsFlagsSplit, seekFreqOffsetsFlagsSplit);
+      }
       RETURN_DECODERS(readFreqOffsetsFlags, seekFreqOffsetsFlags);
 
     case Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets | Index_WideSchema:
+      if (flags & Index_SplitTermOffsets) {
+        RETURN_DECODERS(readFreqOffsetsFlagsSplitWide, NULL);
+      }
       RETURN_DECODERS(readFreqOffsetsFlagsWide, NULL);
 
     // (freqs)
@@ -970,6 +1057,12 @@ int IR_Read(void *ctx, RSIndexResult **e) {
       ir->lastId = record->docId = IR_CURRENT_BLOCK(ir).firstId + delta;
     }
 
+    // Split offsets are not decoded here - we only point at them in the offsets stream
+    if (INDEX_SPLIT_OFFSETS(ir->idx->flags)) {
+      record->term.offsets.data = IR_CURRENT_BLOCK(ir).offsetsBuf.data + ir->offsetsPos;
+      ir->offsetsPos += record->offsetsSz;
+    }
+
     // The decoder also acts as a filter. A zero return value means that the
     // current record should not be processed.
     if (!rv) {
@@ -1021,6 +1114,7 @@ static int IndexReader_SkipToBlock(IndexReader *ir, t_docId docId) {
 new_block:
   ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
   ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
+  ir->offsetsPos = 0;
   return rc;
 }
 
@@ -1116,6 +1210,16 @@ size_t IR_NumDocs(void *ctx) {
   return ir->len;
 }
 
+int IR_NumDocsExact(const IndexReader *ir, size_t *n) {
+  // Numeric readers filter by range, and term readers may filter by field mask
+  if (ir->record->type != RSResultType_Term || ir->decoderCtx.num != RS_FIELDMASK_ALL ||
+      ir->len) {
+    return 0;
+  }
+  *n = ir->idx->numDocs;
+  return 1;
+}
+
 static void IndexReader_Init(const IndexSpec *sp, IndexReader *ret, InvertedIndex *idx,
                              IndexDecoderProcs decoder, IndexDecoderCtx decoderCtx,
                              RSIndexResult *record) {
@@ -1126,6 +1230,7 @@ static void IndexReader_Init(const IndexSpec *sp, IndexReader *ret, InvertedInde
   ret->len = 0;
   ret->lastId = IR_CURRENT_BLOCK(ret).firstId;
   ret->br = NewBufferReader(&IR_CURRENT_BLOCK(ret).buf);
+  ret->offsetsPos = 0;
   ret->decoders = decoder;
   ret->decoderCtx = decoderCtx;
   ret->isValidP = NULL;
@@ -1149,7 +1254,7 @@ IndexReader *NewTermIndexReader(InvertedIndex *idx, IndexSpec *sp, t_fieldMask f
   }
 
   // Get the decoder
-  IndexDecoderProcs decoder = InvertedIndex_GetDecoder((uint32_t)idx->flags & INDEX_STORAGE_MASK);
+  IndexDecoderProcs decoder = InvertedIndex_GetDecoder((uint32_t)idx->flags);
   if (!decoder.decoder) {
     return NULL;
   }
@@ -1195,6 +1300,7 @@ void IR_Rewind(void *ctx) {
   ir->gcMarker = ir->idx->gcMarker;
   ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
   ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
+  ir->offsetsPos = 0;
 }
 
 IndexIterator *NewReadIterator(IndexReader *ir) {
@@ -1234,26 +1340,37 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
   BufferReader br = NewBufferReader(&blk->buf);
   BufferWriter bw = NewBufferWriter(&repair);
 
+  // With split offsets, the offsets stream is compacted alongside the records
+  int splitOffsets = INDEX_SPLIT_OFFSETS(flags);
+  Buffer repairOffsets = {0};
+  BufferWriter obw = NewBufferWriter(&repairOffsets);
+  size_t offsetsPos = 0;
+
   RSIndexResult *res = flags == Index_StoreNumeric ? NewNumericResult() : NewTokenRecord(NULL, 1);
   size_t frags = 0;
   int isLastValid = 0;
 
-  uint32_t readFlags = flags & INDEX_STORAGE_MASK;
-  IndexDecoderProcs decoders = InvertedIndex_GetDecoder(readFlags);
-  IndexEncoder encoder = InvertedIndex_GetEncoder(readFlags);
+  IndexDecoderProcs decoders = InvertedIndex_GetDecoder(flags);
+  IndexEncoder encoder = InvertedIndex_GetEncoder(flags);
 
   if (!encoder || !decoders.decoder) {
     fprintf(stderr, "Could not get decoder/encoder for index\n");
     return -1;
   }
 
-  params->bytesBeforFix = blk->buf.offset;
+  params->bytesBeforFix = blk->buf.offset + blk->offsetsBuf.offset;
 
   while (!BufferReader_AtEnd(&br)) {
     static const IndexDecoderCtx empty = {0};
     const char *bufBegin = BufferReader_Current(&br);
     decoders.decoder(&br, &empty, res);
     size_t sz = BufferReader_Current(&br) - bufBegin;
+    size_t offsetsBegin = offsetsPos;
+    if (splitOffsets) {
+      res->term.offsets.data = blk->offsetsBuf.data + offsetsBegin;
+      offsetsPos += res->offsetsSz;
+      sz += res->offsetsSz;
+    }
     if (!(isFirstRes && res->docId != 0)) {
       // if we are entering this here
       // then its not the first entry or its
@@ -1281,6 +1398,9 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
         // First invalid doc; copy everything prior to this to the repair
         // buffer
         Buffer_Write(&bw, blk->buf.data, bufBegin - blk->buf.data);
+        if (splitOffsets) {
+          Buffer_Write(&obw, blk->offsetsBuf.data, offsetsBegin);
+        }
       }
       params->bytesCollected += sz;
       isLastValid = 0;
@@ -1295,10 +1415,13 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
         }
         if (encoder != encodeRawDocIdsOnly) {
           if (isLastValid) {
-            Buffer_Write(&bw, bufBegin, sz);
+            Buffer_Write(&bw, bufBegin, BufferReader_Current(&br) - bufBegin);
           } else {
             encoder(&bw, res->docId - blk->lastId, res);
           }
+          if (splitOffsets) {
+            Buffer_Write(&obw, res->term.offsets.data, res->offsetsSz);
+          }
         } else { // encoder == encodeRawDocIdsOnly
           if (!blk->firstId) {
             blk->firstId = res->docId;
@@ -1323,6 +1446,11 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
     Buffer_Free(&blk->buf);
     blk->buf = repair;
     Buffer_ShrinkToSize(&blk->buf);
+    if (splitOffsets) {
+      Buffer_Free(&blk->offsetsBuf);
+      blk->offsetsBuf = repairOffsets;
+      Buffer_ShrinkToSize(&blk->offsetsBuf);
+    }
   }
   if (blk->numDocs == 0) {
     // if we left with no elements we do need to keep the
@@ -1334,7 +1462,7 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
     blk->firstId = oldFirstBlock;
   }
 
-  params->bytesAfterFix = blk->buf.offset;
+  params->bytesAfterFix = blk->buf.offset + blk->offsetsBuf.offset;
 
   IndexResult_Free(res);
   return frags;
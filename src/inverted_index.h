@@ -23,6 +23,9 @@ typedef struct {
   t_docId firstId;
   t_docId lastId;
   Buffer buf;
+  // Term offsets of the block's records, when the index has split offsets (see
+  // Index_SplitTermOffsets). Records only carry the length of their offsets in `buf`
+  Buffer offsetsBuf;
   uint16_t numDocs;
 } IndexBlock;
 
@@ -78,6 +81,8 @@ void InvertedIndex_Free(void *idx);
 
 #define IndexBlock_DataBuf(b) (b)->buf.data
 #define IndexBlock_DataLen(b) (b)->buf.offset
+#define IndexBlock_OffsetsBuf(b) (b)->offsetsBuf.data
+#define IndexBlock_OffsetsLen(b) (b)->offsetsBuf.offset
 
 int InvertedIndex_Repair(InvertedIndex *idx, DocTable *dt, uint32_t startBlock,
                          IndexRepairParams *params);
@@ -126,6 +131,9 @@ typedef struct IndexReader {
   t_docId lastId;
   uint32_t currentBlock;
 
+  // Read position in the current block's offsets stream, for indexes with split offsets
+  size_t offsetsPos;
+
   /* The decoder's filtering context. It may be a number or a pointer. The number is used for
    * filtering field masks, the pointer for numeric filtering */
   IndexDecoderCtx decoderCtx;
@@ -218,6 +226,11 @@ RSIndexResult *IR_Current(void *ctx);
 /* The number of docs in an inverted index entry */
 size_t IR_NumDocs(void *ctx);
 
+/* If a reader that was not read yet returns every record of its index, set the number of
+ * records in `n` and return 1. Records of deleted documents which were not garbage collected
+ * yet are counted too */
+int IR_NumDocsExact(const IndexReader *ir, size_t *n);
+
 /* LastDocId of an inverted index stateful reader */
 t_docId IR_LastDocId(void *ctx);
 
@@ -28,7 +28,7 @@ static int LR_Read(void *ctx, RSIndexResult **hit) {
   VecSimQueryResult *res = VecSimQueryResult_IteratorNext(lr->iter);
   lr->base.current->docId = lr->lastDocId = VecSimQueryResult_GetId(res);
   // save distance on RSIndexResult
-  lr->base.current->num.value = VecSimQueryResult_GetScore(res);
+  lr->base.current->dist.value = VecSimQueryResult_GetScore(res);
   *hit = lr->base.current;
 
   return INDEXREAD_OK;
@@ -45,7 +45,7 @@ static int LR_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
     }
     lr->base.current->docId = id;
     lr->lastDocId = id;
-    lr->base.current->num.value = VecSimQueryResult_GetScore(res);
+    lr->base.current->dist.value = VecSimQueryResult_GetScore(res);
     *hit = lr->base.current;
 
     return INDEXREAD_OK;
@@ -130,3 +130,100 @@ IndexIterator *NewListIterator(void *list, size_t len) {
 
   return ri;
 }
+
+/* A list iterator over an array of scored documents, for results which were not produced by a
+ * single vector index query */
+typedef struct {
+  IndexIterator base;
+  ScoredDocId *results;
+  size_t len;
+  size_t offset;
+  t_docId lastDocId;
+} ScoredListIterator;
+
+static int SLR_Read(void *ctx, RSIndexResult **hit) {
+  ScoredListIterator *lr = ctx;
+  if (!lr->base.isValid || lr->offset >= lr->len) {
+    lr->base.isValid = 0;
+    return INDEXREAD_EOF;
+  }
+  const ScoredDocId *res = lr->results + lr->offset++;
+  lr->base.current->docId = lr->lastDocId = res->docId;
+  lr->base.current->dist.value = res->score;
+  lr->base.current->dist.query = res->query;
+  *hit = lr->base.current;
+  return INDEXREAD_OK;
+}
+
+static int SLR_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
+  ScoredListIterator *lr = ctx;
+  while (lr->offset < lr->len && lr->results[lr->offset].docId < docId) {
+    lr->offset++;
+  }
+  if (!lr->base.isValid || lr->offset >= lr->len) {
+    lr->base.isValid = 0;
+    return INDEXREAD_EOF;
+  }
+  SLR_Read(ctx, hit);
+  return lr->lastDocId == docId ? INDEXREAD_OK : INDEXREAD_NOTFOUND;
+}
+
+static void SLR_Free(struct indexIterator *self) {
+  ScoredListIterator *lr = self->ctx;
+  IndexResult_Free(lr->base.current);
+  rm_free(lr->results);
+  rm_free(lr);
+}
+
+static size_t SLR_Len(void *ctx) {
+  return ((ScoredListIterator *)ctx)->len;
+}
+
+static t_docId SLR_LastDocId(void *ctx) {
+  return ((ScoredListIterator *)ctx)->lastDocId;
+}
+
+static void SLR_Abort(void *ctx) {
+  ((ScoredListIterator *)ctx)->base.isValid = 0;
+}
+
+static void SLR_Rewind(void *ctx) {
+  ScoredListIterator *lr = ctx;
+  lr->offset = 0;
+  lr->lastDocId = 0;
+  lr->base.isValid = 1;
+}
+
+static int SLR_HasNext(void *ctx) {
+  ScoredListIterator *lr = ctx;
+  return lr->base.isValid && lr->offset < lr->len;
+}
+
+IndexIterator *NewScoredListIterator(ScoredDocId *results, size_t len) {
+  ScoredListIterator *lr = rm_calloc(1, sizeof(*lr));
+  lr->results = results;
+  lr->len = len;
+  lr->base.isValid = 1;
+
+  IndexIterator *ri = &lr->base;
+  ri->ctx = lr;
+  ri->mode = MODE_SORTED;
+  ri->type = LIST_ITERATOR;
+  ri->NumEstimated = SLR_Len;
+  ri->GetCriteriaTester = NULL;
+  ri->Read = SLR_Read;
+  ri->SkipTo = SLR_SkipTo;
+  ri->LastDocId = SLR_LastDocId;
+  ri->Free = SLR_Free;
+  ri->Len = SLR_Len;
+  ri->Abort = SLR_Abort;
+  ri->Rewind = SLR_Rewind;
+  ri->HasNext = SLR_HasNext;
+  ri->current = NewDistanceResult();
+  return ri;
+}
+
+void ListIterator_SetDistanceField(IndexIterator *it, const FieldSpec *fs) {
+  it->current->dist.field = fs->index;
+  it->current->dist.isGeo = FIELD_IS(fs, INDEXFLD_T_GEO);
+}
@@ -6,3 +6,17 @@
 #include "spec.h"
 
 IndexIterator *NewListIterator(void *list, size_t len);
+
+/* A document and its distance from the query vector, or from the closest of a batch of them */
+typedef struct {
+  t_docId docId;
+  double score;
+  uint32_t query;  // position of the closest query vector in the batch
+} ScoredDocId;
+
+/* Iterate scored documents sorted by id. The iterator takes ownership of the array */
+IndexIterator *NewScoredListIterator(ScoredDocId *results, size_t len);
+
+/* Record the field whose distances a list iterator returns, to tell them from the distances of
+ * other vector or geo clauses of the query */
+void ListIterator_SetDistanceField(IndexIterator *it, const FieldSpec *fs);
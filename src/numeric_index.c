@@ -8,6 +8,7 @@
 #include <math.h>
 #include "redismodule.h"
 #include "util/misc.h"
+#include "util/khash.h"
 //#include "tests/time_sample.h"
 #define NR_EXPONENT 4
 #define NR_MAXRANGE_CARD 2500
@@ -515,25 +516,25 @@ static NumericRangeTree *openNumericKeysDict(RedisSearchCtx *ctx, RedisModuleStr
   return kdv->p;
 }
 
-struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const NumericFilter *flt,
-                                               ConcurrentSearchCtx *csx, FieldType forType) {
-  RedisModuleString *s = IndexSpec_GetFormattedKeyByName(ctx->spec, flt->fieldName, forType);
+NumericRangeTree *OpenNumericIndexRead(RedisSearchCtx *ctx, const char *fieldName,
+                                       FieldType forType) {
+  RedisModuleString *s = IndexSpec_GetFormattedKeyByName(ctx->spec, fieldName, forType);
   if (!s) {
     return NULL;
   }
-  RedisModuleKey *key = NULL;
-  NumericRangeTree *t = NULL;
   if (!ctx->spec->keysDict) {
-    key = RedisModule_OpenKey(ctx->redisCtx, s, REDISMODULE_READ);
+    RedisModuleKey *key = RedisModule_OpenKey(ctx->redisCtx, s, REDISMODULE_READ);
     if (!key || RedisModule_ModuleTypeGetType(key) != NumericIndexType) {
       return NULL;
     }
-
-    t = RedisModule_ModuleTypeGetValue(key);
-  } else {
-    t = openNumericKeysDict(ctx, s, 0);
+    return RedisModule_ModuleTypeGetValue(key);
   }
+  return openNumericKeysDict(ctx, s, 0);
+}
 
+struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const NumericFilter *flt,
+                                               ConcurrentSearchCtx *csx, FieldType forType) {
+  NumericRangeTree *t = OpenNumericIndexRead(ctx, flt->fieldName, forType);
   if (!t) {
     return NULL;
   }
@@ -552,6 +553,250 @@ struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const Numeri
   return it;
 }
 
+/**
+ * Sorted iterator - yields the documents of a child iterator by the order of their value in a
+ * numeric field, one leaf range of the numeric tree at a time. Leaves hold disjoint value ranges,
+ * so once a whole leaf was yielded and `limit` documents were reached, any later document sorts
+ * after all the documents yielded so far and the iterator stops.
+ *
+ * The documents within a leaf are in docId order and not by value, the caller still sorts them.
+ * Documents of the child which have no value in the field are yielded after all the leaves, if
+ * the limit was not reached by then.
+ */
+KHASH_SET_INIT_INT64(numericSortedSeen)
+
+typedef struct {
+  IndexIterator base;
+  IndexIterator *child;
+  const IndexSpec *sp;
+
+  // The leaf ranges, by ascending value
+  NumericRange **leaves;
+  int ascending;
+  size_t nextLeaf;
+  IndexIterator *leafIt;
+
+  size_t limit;
+  size_t numYielded;
+  // The documents yielded, only kept while they may be needed by the missing values phase
+  khash_t(numericSortedSeen) * seen;
+  int missingPhase;
+  int atEOF;
+} NumericSortedIterator;
+
+static void collectLeaves(NumericRangeNode *n, NumericRange ***leaves) {
+  if (!n) return;
+  if (NumericRangeNode_IsLeaf(n)) {
+    if (n->range && n->range->entries->numDocs) {
+      *leaves = array_append(*leaves, n->range);
+    }
+    return;
+  }
+  collectLeaves(n->left, leaves);
+  collectLeaves(n->right, leaves);
+}
+
+/* Count a live document as yielded. Returns 0 for documents which must be skipped */
+static int NSI_Accept(NumericSortedIterator *it, t_docId docId) {
+  const RSDocumentMetadata *dmd = DocTable_Get(&it->sp->docs, docId);
+  if (!dmd || (dmd->flags & Document_Deleted)) {
+    return 0;
+  }
+  int rc;
+  if (it->missingPhase) {
+    return kh_get(numericSortedSeen, it->seen, docId) == kh_end(it->seen);
+  }
+  if (it->numYielded < it->limit) {
+    kh_put(numericSortedSeen, it->seen, docId, &rc);
+  }
+  it->numYielded++;
+  return 1;
+}
+
+/* Move to the next leaf. Returns 0 once there are no more leaves, or the limit was reached */
+static int NSI_NextLeaf(NumericSortedIterator *it) {
+  if (it->leafIt) {
+    it->leafIt->Free(it->leafIt);
+    it->leafIt = NULL;
+  }
+  if (it->numYielded >= it->limit || it->nextLeaf == array_len(it->leaves)) {
+    return 0;
+  }
+  size_t ix = it->nextLeaf++;
+  NumericRange *rng = it->leaves[it->ascending ? ix : array_len(it->leaves) - 1 - ix];
+  it->leafIt = NewReadIterator(NewNumericReader(it->sp, rng->entries, NULL, rng->minVal,
+                                                rng->maxVal));
+  it->child->Rewind(it->child->ctx);
+  return 1;
+}
+
+/* Intersect the current leaf with the child, leapfrogging between them */
+static int NSI_ReadLeaf(NumericSortedIterator *it, RSIndexResult **hit) {
+  IndexIterator *leaf = it->leafIt, *child = it->child;
+  RSIndexResult *lh, *ch;
+  if (leaf->Read(leaf->ctx, &lh) == INDEXREAD_EOF) {
+    return INDEXREAD_EOF;
+  }
+  int rc = child->SkipTo(child->ctx, lh->docId, &ch);
+  while (1) {
+    if (rc == INDEXREAD_EOF) {
+      return INDEXREAD_EOF;
+    } else if (rc == INDEXREAD_OK) {
+      // the leaf and the child are on the same document
+      if (NSI_Accept(it, ch->docId)) {
+        *hit = ch;
+        return INDEXREAD_OK;
+      }
+      if (leaf->Read(leaf->ctx, &lh) == INDEXREAD_EOF) {
+        return INDEXREAD_EOF;
+      }
+      rc = child->SkipTo(child->ctx, lh->docId, &ch);
+      continue;
+    }
+    // the child does not have the leaf's document, catch up with the child
+    t_docId childId = child->LastDocId(child->ctx);
+    if (childId <= lh->docId) {
+      // the child did not move past the document, as a NOT iterator does
+      rc = leaf->Read(leaf->ctx, &lh) == INDEXREAD_EOF ? INDEXREAD_EOF : INDEXREAD_NOTFOUND;
+    } else {
+      rc = leaf->SkipTo(leaf->ctx, childId, &lh);
+    }
+    if (rc == INDEXREAD_OK) {
+      // the child is already on this document, skipping it again would move past it
+      ch = IITER_CURRENT_RECORD(child);
+    } else if (rc == INDEXREAD_NOTFOUND) {
+      rc = child->SkipTo(child->ctx, lh->docId, &ch);
+    }
+  }
+}
+
+static int NSI_Read(void *ctx, RSIndexResult **hit) {
+  NumericSortedIterator *it = ctx;
+  if (it->atEOF) {
+    return INDEXREAD_EOF;
+  }
+
+  while (!it->missingPhase) {
+    if (!it->leafIt && !NSI_NextLeaf(it)) {
+      if (it->numYielded >= it->limit) {
+        it->atEOF = 1;
+        return INDEXREAD_EOF;
+      }
+      // all the leaves were exhausted below the limit, continue with the missing values
+      it->missingPhase = 1;
+      it->child->Rewind(it->child->ctx);
+      break;
+    }
+    if (NSI_ReadLeaf(it, hit) == INDEXREAD_OK) {
+      return INDEXREAD_OK;
+    }
+    it->leafIt->Free(it->leafIt);
+    it->leafIt = NULL;
+  }
+
+  RSIndexResult *ch;
+  while (it->child->Read(it->child->ctx, &ch) != INDEXREAD_EOF) {
+    if (ch && NSI_Accept(it, ch->docId)) {
+      *hit = ch;
+      return INDEXREAD_OK;
+    }
+  }
+  it->atEOF = 1;
+  return INDEXREAD_EOF;
+}
+
+static int NSI_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
+  // The documents are not in docId order, this can only be the root iterator
+  return INDEXREAD_EOF;
+}
+
+static t_docId NSI_LastDocId(void *ctx) {
+  NumericSortedIterator *it = ctx;
+  return it->child->LastDocId(it->child->ctx);
+}
+
+static int NSI_HasNext(void *ctx) {
+  NumericSortedIterator *it = ctx;
+  return !it->atEOF;
+}
+
+static size_t NSI_Len(void *ctx) {
+  NumericSortedIterator *it = ctx;
+  return it->child->Len ? it->child->Len(it->child->ctx) : 0;
+}
+
+static size_t NSI_NumEstimated(void *ctx) {
+  NumericSortedIterator *it = ctx;
+  return IITER_NUM_ESTIMATED(it->child);
+}
+
+static void NSI_Abort(void *ctx) {
+  NumericSortedIterator *it = ctx;
+  it->atEOF = 1;
+  it->child->Abort(it->child->ctx);
+}
+
+static void NSI_Rewind(void *ctx) {
+  NumericSortedIterator *it = ctx;
+  if (it->leafIt) {
+    it->leafIt->Free(it->leafIt);
+    it->leafIt = NULL;
+  }
+  it->nextLeaf = 0;
+  it->numYielded = 0;
+  it->missingPhase = 0;
+  it->atEOF = 0;
+  kh_clear(numericSortedSeen, it->seen);
+  it->child->Rewind(it->child->ctx);
+}
+
+static void NSI_Free(IndexIterator *base) {
+  NumericSortedIterator *it = (NumericSortedIterator *)base;
+  if (it->leafIt) {
+    it->leafIt->Free(it->leafIt);
+  }
+  it->child->Free(it->child);
+  kh_destroy(numericSortedSeen, it->seen);
+  array_free(it->leaves);
+  rm_free(it);
+}
+
+IndexIterator *NewNumericSortedIterator(RedisSearchCtx *ctx, const char *fieldName,
+                                        IndexIterator *child, int ascending, size_t limit) {
+  if (child->mode != MODE_SORTED || !child->Rewind || !limit) {
+    return NULL;
+  }
+  NumericRangeTree *t = OpenNumericIndexRead(ctx, fieldName, INDEXFLD_T_NUMERIC);
+  if (!t) {
+    return NULL;
+  }
+
+  NumericSortedIterator *it = rm_calloc(1, sizeof(*it));
+  it->child = child;
+  it->sp = ctx->spec;
+  it->leaves = array_new(NumericRange *, t->numRanges);
+  collectLeaves(t->root, &it->leaves);
+  it->ascending = ascending;
+  it->limit = limit;
+  it->seen = kh_init(numericSortedSeen);
+
+  IndexIterator *ret = &it->base;
+  ret->ctx = it;
+  ret->type = child->type;
+  ret->mode = MODE_UNSORTED;
+  ret->isValid = 1;
+  ret->NumEstimated = NSI_NumEstimated;
+  ret->Read = NSI_Read;
+  ret->SkipTo = NSI_SkipTo;
+  ret->LastDocId = NSI_LastDocId;
+  ret->HasNext = NSI_HasNext;
+  ret->Free = NSI_Free;
+  ret->Len = NSI_Len;
+  ret->Abort = NSI_Abort;
+  ret->Rewind = NSI_Rewind;
+  return ret;
+}
+
 NumericRangeTree *OpenNumericIndex(RedisSearchCtx *ctx, RedisModuleString *keyName,
                                    RedisModuleKey **idxKey) {
 
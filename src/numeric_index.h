@@ -87,6 +87,15 @@ struct indexIterator *NewNumericRangeIterator(const IndexSpec *sp, NumericRange
 struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const NumericFilter *flt,
                                                ConcurrentSearchCtx *csx, FieldType forType);
 
+/* Wrap a sorted iterator so that its documents are read by the order of their value in a numeric
+ * field, stopping once `limit` documents were read and no later document may sort before them.
+ * Documents without a value are read last. The documents are not yielded in docId order, so the
+ * result can only be used as the root iterator. Returns NULL if the child can't be wrapped, in
+ * which case the child is not owned by the caller */
+struct indexIterator *NewNumericSortedIterator(RedisSearchCtx *ctx, const char *fieldName,
+                                               struct indexIterator *child, int ascending,
+                                               size_t limit);
+
 /* Add an entry to a numeric range node. Returns the cardinality of the range after the
  * inserstion.
  * No deduplication is done */
@@ -135,6 +144,10 @@ extern RedisModuleType *NumericIndexType;
 NumericRangeTree *OpenNumericIndex(RedisSearchCtx *ctx, RedisModuleString *keyName,
                                    RedisModuleKey **idxKey);
 
+/* Open the numeric tree of a field for reading, or return NULL if it does not exist */
+NumericRangeTree *OpenNumericIndexRead(RedisSearchCtx *ctx, const char *fieldName,
+                                       FieldType forType);
+
 int NumericIndexType_Register(RedisModuleCtx *ctx);
 void *NumericIndexType_RdbLoad(RedisModuleIO *rdb, int encver);
 void NumericIndexType_RdbSave(RedisModuleIO *rdb, void *value);
@@ -22,6 +22,8 @@
 #include "numeric_filter.h"
 #include "util/strconv.h"
 #include "util/arr.h"
+#include "util/prefix_cache.h"
+#include "trie/fuzzy_index.h"
 #include "rmutil/rm_assert.h"
 #include "module.h"
 #include "query_internal.h"
@@ -426,6 +428,96 @@ static IndexIterator *iterateExpandedTerms(QueryEvalCtx *q, Trie *terms, const c
   return NewUnionIterator(its, itsSz, q->docTable, 1, opts->weight, type, str);
 }
 
+// Prefixes are only cached while the expansion limit keeps the cached lists reasonably small
+#define PREFIX_CACHE_MAX_TERMS 1000
+
+/* Get the expansions of a prefix from the spec's prefix cache, walking the terms trie and caching
+ * the result on a miss. Returns NULL if the prefix cannot be cached */
+static const PrefixCacheEntry *getPrefixExpansions(IndexSpec *sp, const char *str, size_t len) {
+  size_t limit = RSGlobalConfig.maxPrefixExpansions;
+  if (limit > PREFIX_CACHE_MAX_TERMS) {
+    return NULL;
+  }
+
+  // keyed by folded runes, which is what the trie iterator matches against
+  size_t rlen;
+  rune *runes = strToFoldedRunes(str, &rlen);
+  if (!runes || rlen > TRIE_MAX_PREFIX) {
+    rm_free(runes);
+    return NULL;
+  }
+  if (!sp->prefixCache) {
+    sp->prefixCache = NewPrefixCache(0);
+  }
+
+  const char *key = (const char *)runes;
+  size_t keylen = rlen * sizeof(rune);
+  const PrefixCacheEntry *e = PrefixCache_Find(sp->prefixCache, key, keylen, limit);
+  if (!e) {
+    TrieIterator *it = Trie_Iterate(sp->terms, str, len, 0, 1);
+    PrefixCacheEntry *ne = it ? PrefixCache_Add(sp->prefixCache, key, keylen, limit) : NULL;
+    if (ne) {
+      rune *rstr = NULL;
+      t_len slen = 0;
+      float score = 0;
+      int dist = 0;
+      while (ne->numTerms < limit && TrieIterator_Next(it, &rstr, &slen, NULL, &score, &dist)) {
+        size_t tlen;
+        char *term = runesToStr(rstr, slen, &tlen);
+        PrefixCacheEntry_AddTerm(ne, term, tlen);
+        rm_free(term);
+      }
+    }
+    if (it) {
+      DFAFilter_Free(it->ctx);
+      rm_free(it->ctx);
+      TrieIterator_Free(it);
+    }
+    e = ne;
+  }
+  rm_free(runes);
+  return e;
+}
+
+/* Build a union over the readers of the cached expansions of a prefix */
+/* Open a read iterator on an already expanded term. Returns NULL if it has no inverted index */
+static IndexIterator *openExpandedTerm(QueryEvalCtx *q, char *str, size_t len,
+                                       QueryNodeOptions *opts) {
+  RSToken tok = (RSToken){
+      .str = str,
+      .len = len,
+      .expanded = 0,
+      .flags = 0,
+  };
+  RSQueryTerm *term = NewQueryTerm(&tok, q->tokenId++);
+  IndexReader *ir = Redis_OpenReader(q->sctx, term, &q->sctx->spec->docs, 0,
+                                     q->opts->fieldmask & opts->fieldMask, q->conc, 1);
+  if (!ir) {
+    Term_Free(term);
+    return NULL;
+  }
+  return NewReadIterator(ir);
+}
+
+static IndexIterator *iterateCachedExpansions(QueryEvalCtx *q, const PrefixCacheEntry *e,
+                                              const char *str, QueryNodeOptions *opts) {
+  size_t itsSz = 0;
+  IndexIterator **its = rm_calloc(e->numTerms ? e->numTerms : 1, sizeof(*its));
+
+  for (size_t i = 0; i < e->numTerms && itsSz < RSGlobalConfig.maxPrefixExpansions; ++i) {
+    IndexIterator *it = openExpandedTerm(q, e->terms[i].str, e->terms[i].len, opts);
+    if (it) {
+      its[itsSz++] = it;
+    }
+  }
+
+  if (itsSz == 0) {
+    rm_free(its);
+    return NULL;
+  }
+  return NewUnionIterator(its, itsSz, q->docTable, 1, opts->weight, QN_PREFIX, str);
+}
+
 /* Ealuate a prefix node by expanding all its possible matches and creating one big UNION on all
  * of them */
 static IndexIterator *Query_EvalPrefixNode(QueryEvalCtx *q, QueryNode *qn) {
@@ -439,6 +531,10 @@ static IndexIterator *Query_EvalPrefixNode(QueryEvalCtx *q, QueryNode *qn) {
 
   if (!terms) return NULL;
 
+  const PrefixCacheEntry *e = getPrefixExpansions(q->sctx->spec, qn->pfx.str, qn->pfx.len);
+  if (e) {
+    return iterateCachedExpansions(q, e, qn->pfx.str, &qn->opts);
+  }
   return iterateExpandedTerms(q, terms, qn->pfx.str, qn->pfx.len, 0, 1, &qn->opts);
 }
 
@@ -532,7 +628,96 @@ static IndexIterator *Query_EvalFuzzyNode(QueryEvalCtx *q, QueryNode *qn) {
 
   if (!terms) return NULL;
 
-  return iterateExpandedTerms(q, terms, qn->pfx.str, qn->pfx.len, qn->fz.maxDist, 0, &qn->opts);
+  // the fuzzy index answers small distances without walking the trie, larger ones use the DFA
+  if (qn->fz.maxDist > FUZZY_INDEX_MAX_DIST) {
+    return iterateExpandedTerms(q, terms, qn->pfx.str, qn->pfx.len, qn->fz.maxDist, 0,
+                                &qn->opts);
+  }
+  FuzzyIndexMatch *matches = FuzzyIndex_Find(IndexSpec_GetFuzzyIndex(q->sctx->spec), qn->pfx.str,
+                                             qn->pfx.len, qn->fz.maxDist);
+  size_t itsSz = 0, numMatches = array_len(matches);
+  IndexIterator **its = rm_calloc(numMatches ? numMatches : 1, sizeof(*its));
+  // matches are sorted by distance, so the limit drops the farthest expansions
+  for (size_t i = 0; i < numMatches && itsSz < RSGlobalConfig.maxPrefixExpansions; ++i) {
+    IndexIterator *it = openExpandedTerm(q, matches[i].str, matches[i].len, &qn->opts);
+    if (it) {
+      its[itsSz++] = it;
+    }
+  }
+  FuzzyIndex_FreeMatches(matches);
+
+  if (itsSz == 0) {
+    rm_free(its);
+    return NULL;
+  }
+  return NewUnionIterator(its, itsSz, q->docTable, 1, qn->opts.weight, QN_FUZZY, qn->pfx.str);
+}
+
+static IndexIterator *Query_EvalVectorNode(QueryEvalCtx *q, QueryVectorNode *node,
+                                           double weight, IndexIterator *filter);
+
+static IndexIterator *Query_EvalGeofilterNode(QueryEvalCtx *q, QueryNode *node,
+                                              IndexIterator *filter);
+
+/* Whether the node returns the documents nearest to a query, of a vector or a point */
+static int isNearestNode(const QueryNode *n) {
+  return n->type == QN_VECTOR ||
+         (n->type == QN_GEO && n->gn.gf && n->gn.gf->shape == GEO_SHAPE_NEAREST);
+}
+
+static int isNotNearestNode(QueryNode *n, QueryNode *root, void *ctx) {
+  return !isNearestNode(n);
+}
+
+/* The index of the single nearest child of an intersection, which the other children can
+ * filter, or -1 */
+static int filteredNearestChild(QueryNode *qn) {
+  int nearestIdx = -1;
+  for (size_t ii = 0; ii < QueryNode_NumChildren(qn); ++ii) {
+    QueryNode *child = qn->children[ii];
+    if (isNearestNode(child) && nearestIdx == -1) {
+      nearestIdx = ii;
+    } else if (!QueryNode_ForEach(child, isNotNearestNode, NULL, 0)) {
+      return -1;
+    }
+  }
+  return nearestIdx;
+}
+
+/* Evaluate the intersection of all the children but `nearestIdx`, to filter the nearest child.
+ * Returns NULL if the other children match all the documents */
+static IndexIterator *Query_EvalNearestFilter(QueryEvalCtx *q, QueryNode *qn, int nearestIdx) {
+  size_t num = QueryNode_NumChildren(qn) - 1;
+  size_t numWildcards = 0;
+  for (size_t ii = 0; ii < QueryNode_NumChildren(qn); ++ii) {
+    numWildcards += ii != nearestIdx && qn->children[ii]->type == QN_WILDCARD;
+  }
+  if (numWildcards == num) {
+    return NULL;
+  }
+
+  // The filter is only read while the nearest iterator is created. It is not registered for
+  // reopening, and takes no token ids from the query
+  ConcurrentSearchCtx *conc = q->conc;
+  uint32_t tokenId = q->tokenId;
+  q->conc = NULL;
+
+  IndexIterator **iters = rm_calloc(num, sizeof(*iters));
+  for (size_t ii = 0, n = 0; ii < QueryNode_NumChildren(qn); ++ii) {
+    if (ii != nearestIdx) {
+      qn->children[ii]->opts.fieldMask &= qn->opts.fieldMask;
+      iters[n++] = Query_EvalNode(q, qn->children[ii]);
+    }
+  }
+  q->conc = conc;
+  q->tokenId = tokenId;
+
+  if (num > 1) {
+    return NewIntersecIterator(iters, num, q->docTable, EFFECTIVE_FIELDMASK(q, qn), -1, 0, 1);
+  }
+  IndexIterator *ret = iters[0] ? iters[0] : NewEmptyIterator();
+  rm_free(iters);
+  return ret;
 }
 
 static IndexIterator *Query_EvalPhraseNode(QueryEvalCtx *q, QueryNode *qn) {
@@ -548,11 +733,23 @@ static IndexIterator *Query_EvalPhraseNode(QueryEvalCtx *q, QueryNode *qn) {
     return Query_EvalNode(q, qn->children[0]);
   }
 
+  // A vector or NEAREST geo child returns the nearest documents among those which the other
+  // children match, rather than the nearest overall, which they may mostly filter out
+  int nearestIdx = node->exact ? -1 : filteredNearestChild(qn);
+
   // recursively eval the children
   IndexIterator **iters = rm_calloc(QueryNode_NumChildren(qn), sizeof(IndexIterator *));
   for (size_t ii = 0; ii < QueryNode_NumChildren(qn); ++ii) {
     qn->children[ii]->opts.fieldMask &= qn->opts.fieldMask;
-    iters[ii] = Query_EvalNode(q, qn->children[ii]);
+    QueryNode *child = qn->children[ii];
+    if (ii == nearestIdx && child->type == QN_VECTOR) {
+      iters[ii] = Query_EvalVectorNode(q, &child->vn, child->opts.weight,
+                                       Query_EvalNearestFilter(q, qn, nearestIdx));
+    } else if (ii == nearestIdx) {
+      iters[ii] = Query_EvalGeofilterNode(q, child, Query_EvalNearestFilter(q, qn, nearestIdx));
+    } else {
+      iters[ii] = Query_EvalNode(q, qn->children[ii]);
+    }
   }
   IndexIterator *ret;
 
@@ -585,7 +782,7 @@ static IndexIterator *Query_EvalWildcardNode(QueryEvalCtx *q, QueryNode *qn) {
     return NULL;
   }
 
-  return NewWildcardIterator(q->docTable->maxDocId);
+  return NewWildcardIterator(q->docTable->maxDocId, q->docTable);
 }
 
 static IndexIterator *Query_EvalNotNode(QueryEvalCtx *q, QueryNode *qn) {
@@ -595,7 +792,7 @@ static IndexIterator *Query_EvalNotNode(QueryEvalCtx *q, QueryNode *qn) {
   QueryNotNode *node = &qn->inverted;
 
   return NewNotIterator(QueryNode_NumChildren(qn) ? Query_EvalNode(q, qn->children[0]) : NULL,
-                        q->docTable->maxDocId, qn->opts.weight);
+                        q->docTable->maxDocId, q->docTable, qn->opts.weight);
 }
 
 static IndexIterator *Query_EvalOptionalNode(QueryEvalCtx *q, QueryNode *qn) {
@@ -605,7 +802,7 @@ static IndexIterator *Query_EvalOptionalNode(QueryEvalCtx *q, QueryNode *qn) {
   QueryOptionalNode *node = &qn->opt;
 
   return NewOptionalIterator(QueryNode_NumChildren(qn) ? Query_EvalNode(q, qn->children[0]) : NULL,
-                             q->docTable->maxDocId, qn->opts.weight);
+                             q->docTable->maxDocId, q->docTable, qn->opts.weight);
 }
 
 static IndexIterator *Query_EvalNumericNode(QueryEvalCtx *q, QueryNode *node) {
@@ -618,23 +815,34 @@ static IndexIterator *Query_EvalNumericNode(QueryEvalCtx *q, QueryNode *node) {
 }
 
 static IndexIterator *Query_EvalGeofilterNode(QueryEvalCtx *q, QueryNode *node,
-                                              double weight) {
+                                              IndexIterator *filter) {
   const FieldSpec *fs =
       IndexSpec_GetField(q->sctx->spec, node->gn.gf->property, strlen(node->gn.gf->property));
   if (!fs || !FIELD_IS(fs, INDEXFLD_T_GEO)) {
+    if (filter) filter->Free(filter);
     return NULL;
   }
+  if (node->gn.gf->shape == GEO_SHAPE_NEAREST) {
+    return NewGeoNearestIterator(q->sctx, node->gn.gf, filter);
+  }
   return NewGeoRangeIterator(q->sctx, node->gn.gf);
 }
 
-static IndexIterator *Query_EvalVectorNode(QueryEvalCtx *q, QueryVectorNode *node) {
+static IndexIterator *Query_EvalVectorNode(QueryEvalCtx *q, QueryVectorNode *node,
+                                           double weight, IndexIterator *filter) {
   const FieldSpec *fs =
       IndexSpec_GetField(q->sctx->spec, node->vf->property, strlen(node->vf->property));
   if (!fs || !FIELD_IS(fs, INDEXFLD_T_VECTOR)) {
+    if (filter) filter->Free(filter);
     return NULL;
   }
 
-  return NewVectorIterator(q->sctx, node->vf);
+  IndexIterator *ret = NewVectorIterator(q->sctx, node->vf, filter);
+  if (ret) {
+    // scales the vector similarity of hybrid scoring
+    ret->current->weight = weight;
+  }
+  return ret;
 }
 
 static IndexIterator *Query_EvalIdFilterNode(QueryEvalCtx *q, QueryIdFilterNode *node) {
@@ -704,6 +912,38 @@ static IndexIterator *Query_EvalTagLexRangeNode(QueryEvalCtx *q, TagIndex *idx,
   }
 }
 
+/* Get the expansions of a tag prefix from the tag index's prefix cache, caching the values
+ * iterated from the tag index on a miss. Returns NULL if the prefix cannot be cached */
+static const PrefixCacheEntry *getTagPrefixExpansions(TagIndex *idx, const char *str,
+                                                      size_t len) {
+  size_t limit = RSGlobalConfig.maxPrefixExpansions;
+  if (limit > PREFIX_CACHE_MAX_TERMS) {
+    return NULL;
+  }
+  if (!idx->prefixCache) {
+    idx->prefixCache = NewPrefixCache(0);
+  }
+
+  const PrefixCacheEntry *e = PrefixCache_Find(idx->prefixCache, str, len, limit);
+  if (e) {
+    return e;
+  }
+  TrieMapIterator *it = TrieMap_Iterate(idx->values, str, len);
+  if (!it) return NULL;
+
+  PrefixCacheEntry *ne = PrefixCache_Add(idx->prefixCache, str, len, limit);
+  if (ne) {
+    char *s;
+    tm_len_t sl;
+    void *ptr;
+    while (ne->numTerms < limit && TrieMapIterator_Next(it, &s, &sl, &ptr)) {
+      PrefixCacheEntry_AddTerm(ne, s, sl);
+    }
+  }
+  TrieMapIterator_Free(it);
+  return ne;
+}
+
 /* Evaluate a tag prefix by expanding it with a lookup on the tag index */
 static IndexIterator *Query_EvalTagPrefixNode(QueryEvalCtx *q, TagIndex *idx, QueryNode *qn,
                                               IndexIteratorArray *iterout, double weight) {
@@ -717,8 +957,12 @@ static IndexIterator *Query_EvalTagPrefixNode(QueryEvalCtx *q, TagIndex *idx, Qu
   }
   if (!idx || !idx->values) return NULL;
 
-  TrieMapIterator *it = TrieMap_Iterate(idx->values, qn->pfx.str, qn->pfx.len);
-  if (!it) return NULL;
+  const PrefixCacheEntry *e = getTagPrefixExpansions(idx, qn->pfx.str, qn->pfx.len);
+  TrieMapIterator *it = NULL;
+  if (!e) {
+    it = TrieMap_Iterate(idx->values, qn->pfx.str, qn->pfx.len);
+    if (!it) return NULL;
+  }
 
   size_t itsSz = 0, itsCap = 8;
   IndexIterator **its = rm_calloc(itsCap, sizeof(*its));
@@ -728,9 +972,15 @@ static IndexIterator *Query_EvalTagPrefixNode(QueryEvalCtx *q, TagIndex *idx, Qu
   tm_len_t sl;
   void *ptr;
 
-  // Find all completions of the prefix
-  while (TrieMapIterator_Next(it, &s, &sl, &ptr) &&
-         (itsSz < RSGlobalConfig.maxPrefixExpansions)) {
+  // Find all completions of the prefix, either cached or from the tag index
+  for (size_t i = 0; itsSz < RSGlobalConfig.maxPrefixExpansions; ++i) {
+    if (e) {
+      if (i == e->numTerms) break;
+      s = e->terms[i].str;
+      sl = e->terms[i].len;
+    } else if (!TrieMapIterator_Next(it, &s, &sl, &ptr)) {
+      break;
+    }
     IndexIterator *ret = TagIndex_OpenReader(idx, q->sctx->spec, s, sl, 1);
     if (!ret) continue;
 
@@ -742,7 +992,9 @@ static IndexIterator *Query_EvalTagPrefixNode(QueryEvalCtx *q, TagIndex *idx, Qu
     }
   }
 
-  TrieMapIterator_Free(it);
+  if (it) {
+    TrieMapIterator_Free(it);
+  }
 
   // printf("Expanded %d terms!\n", itsSz);
   if (itsSz == 0) {
@@ -914,9 +1166,9 @@ IndexIterator *Query_EvalNode(QueryEvalCtx *q, QueryNode *n) {
     case QN_OPTIONAL:
       return Query_EvalOptionalNode(q, n);
     case QN_GEO:
-      return Query_EvalGeofilterNode(q, n, n->opts.weight);
+      return Query_EvalGeofilterNode(q, n, NULL);
     case QN_VECTOR:
-      return Query_EvalVectorNode(q, &n->vn);
+      return Query_EvalVectorNode(q, &n->vn, n->opts.weight, NULL);
     case QN_IDS:
       return Query_EvalIdFilterNode(q, &n->fn);
     case QN_WILDCARD:
@@ -1225,9 +1477,21 @@ static sds QueryNode_DumpSds(sds s, const IndexSpec *spec, const QueryNode *qs,
       break;
     case QN_GEO:
 
-      s = sdscatprintf(s, "GEO %s:{%f,%f --> %f %s", qs->gn.gf->property, qs->gn.gf->lon,
-                       qs->gn.gf->lat, qs->gn.gf->radius,
-                       GeoDistance_ToString(qs->gn.gf->unitType));
+      if (qs->gn.gf->shape == GEO_SHAPE_BOX) {
+        s = sdscatprintf(s, "GEO %s:{BOX %f,%f --> %f,%f", qs->gn.gf->property,
+                         qs->gn.gf->minLon, qs->gn.gf->minLat, qs->gn.gf->maxLon,
+                         qs->gn.gf->maxLat);
+      } else if (qs->gn.gf->shape == GEO_SHAPE_POLYGON) {
+        s = sdscatprintf(s, "GEO %s:{POLYGON %zu points", qs->gn.gf->property,
+                         qs->gn.gf->numPoints);
+      } else if (qs->gn.gf->shape == GEO_SHAPE_NEAREST) {
+        s = sdscatprintf(s, "GEO %s:{NEAREST %zu to %f,%f", qs->gn.gf->property, qs->gn.gf->k,
+                         qs->gn.gf->lon, qs->gn.gf->lat);
+      } else {
+        s = sdscatprintf(s, "GEO %s:{%f,%f --> %f %s", qs->gn.gf->property, qs->gn.gf->lon,
+                         qs->gn.gf->lat, qs->gn.gf->radius,
+                         GeoDistance_ToString(qs->gn.gf->unitType));
+      }
       break;
     case QN_IDS:
 
@@ -1416,6 +1680,36 @@ static int QueryNode_ApplyAttribute(QueryNode *qn, QueryAttribute *attr, QueryEr
     }
     qn->vn.vf->efRuntime = val;
 
+  } else if (STR_EQCASE(attr->name, attr->namelen, "rerank")) {
+    if (qn->type != QN_VECTOR) {
+      QueryError_SetErrorFmt(status, QUERY_EGENERIC, "Attribute %s requires vector node",
+                             attr->name);
+      return 0;
+    }
+
+    // Recompute the distances of quantized vectors in full precision: true|false
+    int b;
+    if (!ParseBoolean(attr->value, &b)) {
+      MK_INVALID_VALUE();
+      return 0;
+    }
+    qn->vn.vf->rerank = b;
+
+  } else if (STR_EQCASE(attr->name, attr->namelen, "batch")) {
+    if (qn->type != QN_VECTOR) {
+      QueryError_SetErrorFmt(status, QUERY_EGENERIC, "Attribute %s requires vector node",
+                             attr->name);
+      return 0;
+    }
+
+    // The vector data holds several query vectors, one after the other: true|false
+    int b;
+    if (!ParseBoolean(attr->value, &b)) {
+      MK_INVALID_VALUE();
+      return 0;
+    }
+    qn->vn.vf->batch = b;
+
   } else {
     QueryError_SetErrorFmt(status, QUERY_ENOOPTION, "Invalid attribute %.*s", (int)attr->namelen,
                            attr->name);
@@ -12,6 +12,29 @@
 
 RedisModuleType *InvertedIndexType;
 
+static void loadBlockBuffer(RedisModuleIO *rdb, Buffer *b) {
+  b->data = RedisModule_LoadStringBuffer(rdb, &b->offset);
+  b->cap = b->offset;
+  // if we read a buffer of 0 bytes we still read 1 byte from the RDB that needs to be freed
+  if (!b->cap && b->data) {
+    RedisModule_Free(b->data);
+    b->data = NULL;
+  } else {
+    char *buf = rm_malloc(b->offset);
+    memcpy(buf, b->data, b->offset);
+    RedisModule_Free(b->data);
+    b->data = buf;
+  }
+}
+
+static void saveBlockBuffer(RedisModuleIO *rdb, const char *data, size_t len) {
+  if (len) {
+    RedisModule_SaveStringBuffer(rdb, data, len);
+  } else {
+    RedisModule_SaveStringBuffer(rdb, "", 0);
+  }
+}
+
 void *InvertedIndex_RdbLoad(RedisModuleIO *rdb, int encver) {
   if (encver > INVERTED_INDEX_ENCVER) {
     return NULL;
@@ -38,17 +61,9 @@ void *InvertedIndex_RdbLoad(RedisModuleIO *rdb, int encver) {
       ++actualSize;
     }
 
-    blk->buf.data = RedisModule_LoadStringBuffer(rdb, &blk->buf.offset);
-    blk->buf.cap = blk->buf.offset;
-    // if we read a buffer of 0 bytes we still read 1 byte from the RDB that needs to be freed
-    if (!blk->buf.cap && blk->buf.data) {
-      RedisModule_Free(blk->buf.data);
-      blk->buf.data = NULL;
-    } else {
-      char *buf = rm_malloc(blk->buf.offset);
-      memcpy(buf, blk->buf.data, blk->buf.offset);
-      RedisModule_Free(blk->buf.data);
-      blk->buf.data = buf;
+    loadBlockBuffer(rdb, &blk->buf);
+    if (INDEX_SPLIT_OFFSETS(idx->flags)) {
+      loadBlockBuffer(rdb, &blk->offsetsBuf);
     }
   }
   idx->size = actualSize;
@@ -83,10 +98,9 @@ void InvertedIndex_RdbSave(RedisModuleIO *rdb, void *value) {
     RedisModule_SaveUnsigned(rdb, blk->firstId);
     RedisModule_SaveUnsigned(rdb, blk->lastId);
     RedisModule_SaveUnsigned(rdb, blk->numDocs);
-    if (IndexBlock_DataLen(blk)) {
-      RedisModule_SaveStringBuffer(rdb, IndexBlock_DataBuf(blk), IndexBlock_DataLen(blk));
-    } else {
-      RedisModule_SaveStringBuffer(rdb, "", 0);
+    saveBlockBuffer(rdb, IndexBlock_DataBuf(blk), IndexBlock_DataLen(blk));
+    if (INDEX_SPLIT_OFFSETS(idx->flags)) {
+      saveBlockBuffer(rdb, IndexBlock_OffsetsBuf(blk), IndexBlock_OffsetsLen(blk));
     }
   }
 }
@@ -99,6 +113,7 @@ unsigned long InvertedIndex_MemUsage(const void *value) {
   for (size_t i = 0; i < idx->size; i++) {
     ret += sizeof(IndexBlock);
     ret += IndexBlock_DataLen(&idx->blocks[i]);
+    ret += IndexBlock_OffsetsLen(&idx->blocks[i]);
   }
   return ret;
 }
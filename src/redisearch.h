@@ -247,6 +247,16 @@ typedef struct {
   double value;
 } RSNumericRecord;
 
+/* The distance of a vector from the query vector, or of a document from the point of a NEAREST
+ * geo filter. A batch of query vectors returns the distance from the closest one, and its
+ * position in the batch */
+typedef struct {
+  double value;
+  uint32_t query;
+  uint16_t field;  // The position of the vector or geo field in the spec
+  uint8_t isGeo;
+} RSDistanceRecord;
+
 typedef enum {
   RSResultType_Union = 0x1,
   RSResultType_Intersection = 0x2,
@@ -305,6 +315,8 @@ typedef struct RSIndexResult {
     RSVirtualRecord virt;
     // numeric record with float value
     RSNumericRecord num;
+    // distance record of a vector query
+    RSDistanceRecord dist;
   };
 
   RSResultType type;
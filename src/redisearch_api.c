@@ -341,7 +341,8 @@ QueryNode* RediSearch_CreateGeoNode(IndexSpec* sp, const char* field, double lat
   QueryNode* ret = NewQueryNode(QN_GEO);
   ret->opts.fieldMask = IndexSpec_GetFieldBit(sp, field, strlen(field));
 
-  GeoFilter *flt = rm_malloc(sizeof(*flt));
+  GeoFilter *flt = rm_calloc(1, sizeof(*flt));
+  flt->shape = GEO_SHAPE_RADIUS;
   flt->lat = lat;
   flt->lon = lon;
   flt->radius = radius;
@@ -23,6 +23,7 @@ void QITR_Cleanup(QueryIterator *qitr) {
 void SearchResult_Clear(SearchResult *r) {
   // This won't affect anything if the result is null
   r->score = 0;
+  r->sortPrefixKind = RSSortPrefix_None;
   if (r->scoreExplain) {
     SEDestroy(r->scoreExplain);
     r->scoreExplain = NULL;
@@ -124,6 +125,67 @@ static int rpidxNext(ResultProcessor *base, SearchResult *res) {
   return RS_RESULT_OK;
 }
 
+/* The number of matches of `it` if it can be known without reading it, or -1 */
+static ssize_t rpidxCountWithoutReading(IndexIterator *it, const DocTable *dt) {
+  if (it->type == WILDCARD_ITERATOR) {
+    // counted from the live documents bitset when the iterator was created
+    return it->Len(it->ctx);
+  }
+  // Without deletions, the index of a single term holds exactly its matches
+  size_t n;
+  if (it->type == READ_ITERATOR && dt->liveDocs.count == dt->maxDocId &&
+      IR_NumDocsExact(it->ctx, &n)) {
+    return n;
+  }
+  return -1;
+}
+
+/* Next implementation for queries which only need the total number of results. The matches are
+ * counted off the root iterator into the total, without building results, reading document
+ * metadata or scoring. Deleted documents are tested against the live documents bitset, unless
+ * there are none */
+static int rpidxCount(ResultProcessor *base, SearchResult *res) {
+  RPIndexIterator *self = (RPIndexIterator *)base;
+  IndexIterator *it = self->iiter;
+
+  if (it == NULL) {
+    return RS_RESULT_EOF;
+  }
+  if (isTrimming && RedisModule_ShardingGetKeySlot) {
+    // Every document's key slot needs checking
+    return rpidxNext(base, res);
+  }
+
+  const DocTable *dt = &RP_SPEC(base)->docs;
+  ssize_t n = rpidxCountWithoutReading(it, dt);
+  if (n >= 0) {
+    base->parent->totalResults += n;
+    it->Abort(it->ctx);
+    return RS_RESULT_EOF;
+  }
+
+  int checkLive = dt->liveDocs.count != dt->maxDocId;
+  RSIndexResult *r;
+  int rc;
+  while ((rc = it->Read(it->ctx, &r)) != INDEXREAD_EOF) {
+    if (++self->timeoutLimiter == 100) {
+      self->timeoutLimiter = 0;
+      if (TimedOut(self->timeout) == RS_RESULT_TIMEDOUT) {
+        return RS_RESULT_TIMEDOUT;
+      }
+    }
+    if (rc == INDEXREAD_NOTFOUND || !r || (checkLive && !DocTable_IsLive(dt, r->docId))) {
+      continue;
+    }
+    base->parent->totalResults++;
+  }
+  return RS_RESULT_EOF;
+}
+
+void RPIndexIterator_SetCountOnly(ResultProcessor *base) {
+  base->Next = rpidxCount;
+}
+
 static void rpidxFree(ResultProcessor *iter) {
   rm_free(iter);
 }
@@ -297,6 +359,11 @@ typedef struct {
     size_t nLoadKeys;
   } fieldcmp;
 
+  // SEARCHAFTER - only results which sort after this one are admitted
+  SearchResult *after;
+
+  // The vector or geo field sorted by distance, with SORTBY_DISTANCE
+  uint16_t distanceField;
 } RPSorter;
 
 /* Yield - pops the current top result from the heap */
@@ -327,6 +394,11 @@ static void rpsortFree(ResultProcessor *rp) {
     rm_free(self->fieldcmp.loadKeys);
   }
 
+  if (self->after) {
+    SearchResult_Destroy(self->after);
+    rm_free(self->after);
+  }
+
   // calling mmh_free will free all the remaining results in the heap, if any
   mmh_free(self->pq);
   rm_free(rp);
@@ -334,6 +406,22 @@ static void rpsortFree(ResultProcessor *rp) {
 
 #define RESULT_QUEUED RS_RESULT_MAX + 1
 
+/* The distance result of a match for a vector or geo field. It is a child of the match's result
+ * when the vector or NEAREST filter is intersected with other filters */
+static const RSIndexResult *findDistanceResult(const RSIndexResult *r, uint16_t field) {
+  if (r->type == RSResultType_Distance) {
+    return r->dist.field == field ? r : NULL;
+  } else if (RSIndexResult_IsAggregate(r)) {
+    for (int i = 0; i < r->agg.numChildren; i++) {
+      const RSIndexResult *d = findDistanceResult(r->agg.children[i], field);
+      if (d) {
+        return d;
+      }
+    }
+  }
+  return NULL;
+}
+
 static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
   RPSorter *self = (RPSorter *)rp;
 
@@ -348,7 +436,7 @@ static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
 
   // For VecSim and Geo, this passes the calculated value to the sorting heap.
   if (h && h->indexResult && h->indexResult->type == RSResultType_Distance) {
-    h->score = h->indexResult->num.value;
+    h->score = h->indexResult->dist.value;
   }
 
   // if our upstream has finished - just change the state to not accumulating, and yield
@@ -376,7 +464,9 @@ static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
         } else {
           nLoadKeys = 0;
           for (int i = 0; i < nkeys; ++i) {
-            if (RLookup_GetItem(self->fieldcmp.keys[i], &h->rowdata) == NULL) {
+            // a sortable key which is missing from the sorting vector is missing from the document
+            const RLookupKey *kk = self->fieldcmp.keys[i];
+            if (!(kk->flags & RLOOKUP_F_SVSRC) && RLookup_GetItem(kk, &h->rowdata) == NULL) {
               if (!loadKeys) {
                 loadKeys = rm_calloc(nkeys, sizeof(*loadKeys));
               }
@@ -401,14 +491,38 @@ static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
         }
       }
     } else if (self->sortbyType == SORTBY_DISTANCE){
-      RSValue *rsv = RS_NumVal(h->indexResult->num.value);
-      RLookup_WriteKey(self->fieldcmp.keys[0], &h->rowdata, rsv);
-      RSValue_Decref(rsv);
+      // The distance is the last key. Batch queries sort by the position of the closest query
+      // vector first, to group the results of each query vector
+      const RSIndexResult *d =
+          h->indexResult ? findDistanceResult(h->indexResult, self->distanceField) : NULL;
+      if (d) {
+        RSValue *rsv = RS_NumVal(d->dist.value);
+        RLookup_WriteKey(self->fieldcmp.keys[nkeys - 1], &h->rowdata, rsv);
+        RSValue_Decref(rsv);
+        if (nkeys > 1) {
+          rsv = RS_NumVal(d->dist.query);
+          RLookup_WriteKey(self->fieldcmp.keys[0], &h->rowdata, rsv);
+          RSValue_Decref(rsv);
+        }
+      }
     } else {
       RS_LOG_ASSERT(0, "oops");
     }
   }
 
+  // Most comparisons are decided by the first key, keep an integer prefix of it
+  if (nkeys && self->sortbyType != SORTBY_SCORE) {
+    const RSValue *v = RLookup_GetItem(self->fieldcmp.keys[0], &h->rowdata);
+    h->sortPrefixKind = RSValue_SortPrefix(v, &h->sortPrefix);
+  }
+
+  // Skip the results up to the last result of the previous page, including it
+  if (self->after &&
+      (h->docId == self->after->docId || self->cmp(h, self->after, self->cmpCtx) > 0)) {
+    SearchResult_Clear(h);
+    return RESULT_QUEUED;
+  }
+
   // If the queue is not full - we just push the result into it
   // If the pool size is 0 we always do that, letting the heap grow dynamically
   if (!self->size || self->pq->count + 1 < self->pq->size) {
@@ -493,6 +607,12 @@ static int cmpByFields(const void *e1, const void *e2, const void *udata) {
       return ascending ? -rc : rc;
     }
 
+    if (i == 0 && h1->sortPrefixKind && h1->sortPrefixKind == h2->sortPrefixKind &&
+        h1->sortPrefix != h2->sortPrefix) {
+      int rc = h1->sortPrefix < h2->sortPrefix ? -1 : 1;
+      return ascending ? -rc : rc;
+    }
+
     int rc = RSValue_Cmp(v1, v2, qerr);
     // printf("asc? %d Compare: \n", ascending);
     // RSValue_Print(v1);
@@ -554,6 +674,36 @@ ResultProcessor *RPSorter_NewByScore(size_t maxresults) {
   return RPSorter_NewByFields(maxresults, NULL, 0, 0, SORTBY_SCORE);
 }
 
+void RPSorter_SetDistanceField(ResultProcessor *rp, uint16_t field) {
+  ((RPSorter *)rp)->distanceField = field;
+}
+
+void RPSorter_SetSearchAfter(ResultProcessor *rp, RSValue **values, t_docId docId) {
+  RPSorter *self = (RPSorter *)rp;
+  SearchResult *after = rm_calloc(1, sizeof(*after));
+  if (self->sortbyType == SORTBY_SCORE) {
+    RSValue_ToNumber(values[0], &after->score);
+  } else {
+    for (size_t ii = 0; ii < self->fieldcmp.nkeys; ++ii) {
+      // a null value stands for a missing one
+      if (values[ii]->t != RSValue_Null) {
+        RLookup_WriteKey(self->fieldcmp.keys[ii], &after->rowdata, values[ii]);
+      }
+    }
+    after->sortPrefixKind = RSValue_SortPrefix(values[0], &after->sortPrefix);
+  }
+
+  after->docId = docId;
+  if (!docId) {
+    // place it before all the results with the same values, whichever the tie breaking order is
+    SearchResult first = *after, last = *after;
+    first.docId = 0;
+    last.docId = UINT64_MAX;
+    after->docId = self->cmp(&first, &last, self->cmpCtx) > 0 ? 0 : UINT64_MAX;
+  }
+  self->after = after;
+}
+
 void SortAscMap_Dump(uint64_t tt, size_t n) {
   for (size_t ii = 0; ii < n; ++ii) {
     if (SORTASCMAP_GETASC(tt, ii)) {
@@ -120,6 +120,10 @@ typedef struct {
 
   // Row data. Use RLookup_* functions to access
   RLookupRow rowdata;
+
+  // Prefix of the first sort key, set by the sorter. See RSValue_SortPrefix()
+  uint64_t sortPrefix;
+  RSSortPrefixKind sortPrefixKind;
 } SearchResult;
 
 /* Result processor return codes */
@@ -190,6 +194,12 @@ void SearchResult_Destroy(SearchResult *r);
 
 ResultProcessor *RPIndexIterator_New(IndexIterator *itr, struct timespec timeoutTime);
 
+/**
+ * Have the index processor only count the matches into the total, returning no results. Used
+ * when nothing downstream needs the results (LIMIT 0 0)
+ */
+void RPIndexIterator_SetCountOnly(ResultProcessor *rp);
+
 ResultProcessor *RPScorer_New(const ExtScoringFunctionCtx *funcs,
                               const ScoringFunctionArgs *fnargs);
 
@@ -212,6 +222,17 @@ ResultProcessor *RPSorter_NewByFields(size_t maxresults, const RLookupKey **keys
 
 ResultProcessor *RPSorter_NewByScore(size_t maxresults);
 
+/* Set the vector or geo field whose distance a SORTBY_DISTANCE sorter sorts by */
+void RPSorter_SetDistanceField(ResultProcessor *rp, uint16_t field);
+
+/**
+ * Only admit the results which sort strictly after a given result - the last result of the
+ * previous page, for keyset pagination. `values` holds its value for each of the sort keys, or a
+ * single score when sorting by score. If `docId` is 0 (e.g. the document was deleted), results
+ * with the same values are all admitted.
+ */
+void RPSorter_SetSearchAfter(ResultProcessor *rp, RSValue **values, t_docId docId);
+
 ResultProcessor *RPPager_New(size_t offset, size_t limit);
 
 /*******************************************************************************************************************
@@ -1,4 +1,7 @@
 #include "rs_geo.h"
+#include "util/minmax.h"
+
+#include <stdlib.h>
 
 int encodeGeo(double lon, double lat, double *bits) {
   GeoHashBits hash;
@@ -90,6 +93,108 @@ void calcRanges(double longitude, double latitude, double radius_meters, GeoHash
   calcAllNeighbors(&georadius, longitude, latitude, radius_meters, ranges);
 }
 
+/* The child cell of a geohash cell. Each step interleaves a longitude bit above a latitude bit */
+static GeoHashArea childCell(const GeoHashArea *cell, int child) {
+  GeoHashArea ret = *cell;
+  ret.hash.bits = (cell->hash.bits << 2) | child;
+  ret.hash.step++;
+  double midLon = (cell->longitude.min + cell->longitude.max) / 2;
+  double midLat = (cell->latitude.min + cell->latitude.max) / 2;
+  if (child & 2) {
+    ret.longitude.min = midLon;
+  } else {
+    ret.longitude.max = midLon;
+  }
+  if (child & 1) {
+    ret.latitude.min = midLat;
+  } else {
+    ret.latitude.max = midLat;
+  }
+  return ret;
+}
+
+static int cmpRanges(const void *a, const void *b) {
+  const GeoHashRange *r1 = a, *r2 = b;
+  return r1->min < r2->min ? -1 : r1->min > r2->min;
+}
+
+size_t calcCoverRanges(GeoCellTester test, const void *ctx, GeoHashRange *ranges,
+                       size_t maxRanges) {
+  GeoHashArea cells[maxRanges];
+  // cells which are not split any further
+  bool done[maxRanges];
+  size_t n = 0;
+
+  GeoHashArea world = {.longitude = {GEO_LONG_MIN, GEO_LONG_MAX},
+                       .latitude = {GEO_LAT_MIN, GEO_LAT_MAX}};
+  GeoCellRelation rel = test(&world, ctx);
+  if (rel == GEO_CELL_DISJOINT || !maxRanges) {
+    return 0;
+  }
+  cells[n] = world;
+  done[n++] = rel == GEO_CELL_CONTAINED;
+
+  while (1) {
+    // split the largest cell crossing the boundary
+    size_t largest = n;
+    for (size_t i = 0; i < n; i++) {
+      if (!done[i] && (largest == n || cells[i].hash.step < cells[largest].hash.step)) {
+        largest = i;
+      }
+    }
+    if (largest == n) {
+      break;
+    } else if (cells[largest].hash.step == GEO_STEP_MAX) {
+      done[largest] = true;
+      continue;
+    }
+
+    GeoHashArea children[4];
+    bool childDone[4];
+    size_t numChildren = 0;
+    for (int i = 0; i < 4; i++) {
+      GeoHashArea child = childCell(&cells[largest], i);
+      rel = test(&child, ctx);
+      if (rel != GEO_CELL_DISJOINT) {
+        children[numChildren] = child;
+        childDone[numChildren++] = rel == GEO_CELL_CONTAINED;
+      }
+    }
+    if (n - 1 + numChildren > maxRanges) {
+      // out of cells. smaller cells may still be split into fewer children
+      done[largest] = true;
+      continue;
+    }
+    for (size_t i = 0; i < numChildren; i++) {
+      size_t slot = i ? n++ : largest;
+      cells[slot] = children[i];
+      done[slot] = childDone[i];
+    }
+    if (!numChildren) {
+      // the shape only touches the cell at points the test can't place in a child
+      cells[largest] = cells[--n];
+      done[largest] = done[n];
+    }
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    GeoHashFix52Bits min, max;
+    scoresOfGeoHashBox(cells[i].hash, &min, &max);
+    ranges[i].min = min;
+    ranges[i].max = max;
+  }
+  qsort(ranges, n, sizeof(*ranges), cmpRanges);
+  size_t merged = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (merged && ranges[merged - 1].max >= ranges[i].min) {
+      ranges[merged - 1].max = MAX(ranges[merged - 1].max, ranges[i].max);
+    } else {
+      ranges[merged++] = ranges[i];
+    }
+  }
+  return merged;
+}
+
 bool isWithinRadiusLonLat(double lon1, double lat1, double lon2, double lat2, double radius,
                           double *distance) {
   double dist = geohashGetDistance(lon1, lat1, lon2, lat2);
@@ -4,6 +4,8 @@
 #include "geo_index.h"
 
 #define GEO_RANGE_COUNT 9
+// The most geohash cells covering a geo filter
+#define GEO_COVER_MAX_CELLS 16
 
 /*
  * Encode longetude and latitude doubles into a single double.
@@ -25,6 +27,26 @@ int  decodeGeo(double bits, double *xy);
 void calcRanges(double longitude, double latitude, double radius_meters,
                 GeoHashRange *ranges);
 
+typedef enum {
+  GEO_CELL_DISJOINT,
+  GEO_CELL_INTERSECTS,
+  GEO_CELL_CONTAINED,
+} GeoCellRelation;
+
+/* Tests how a geohash cell relates to a shape. It may only return GEO_CELL_DISJOINT if no point of
+ * the shape is in the cell */
+typedef GeoCellRelation (*GeoCellTester)(const GeoHashArea *cell, const void *ctx);
+
+/*
+ * Cover a shape with at most `maxRanges` geohash cells of any size, splitting the largest cells
+ * which cross its boundary first. The cells are returned as sorted geohash ranges, where the min
+ * is inclusive and the max exclusive, and adjacent cells are merged. Returns the number of ranges.
+ *
+ * Unlike `calcRanges`, the cells fit the shape, so far fewer points in them are outside of it.
+ */
+size_t calcCoverRanges(GeoCellTester test, const void *ctx, GeoHashRange *ranges,
+                       size_t maxRanges);
+
 /*
  * Return true is distance is smaller than radius. radius must be in meters.
  * If `distance' is not NULL, the distance value is returned.
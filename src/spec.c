@@ -22,6 +22,8 @@
 #include "dictionary.h"
 #include "doc_types.h"
 #include "rdb.h"
+#include "util/prefix_cache.h"
+#include "trie/fuzzy_index.h"
 
 #define INITIAL_DOC_TABLE_SIZE 1000
 
@@ -320,8 +322,8 @@ static int parseTextField(FieldSpec *fs, ArgsCursor *ac, QueryError *status) {
 }
 
 // Tries to get vector data type from ac. This function need to stay updated with
-// the supported vector data types list of VecSim.
-static int parseVectorField_GetType(ArgsCursor *ac, VecSimType *type) {
+// the supported vector data types list of VecSim. Half precision types are indexed as FLOAT32.
+static int parseVectorField_GetType(ArgsCursor *ac, VecSimType *type, VectorHalfType *half) {
   const char *typeStr;
   size_t len;
   int rc;
@@ -329,8 +331,16 @@ static int parseVectorField_GetType(ArgsCursor *ac, VecSimType *type) {
     return rc;
   }
   // Uncomment these when support for other type is added.
+  *half = VectorHalf_None;
   if (!strncasecmp(VECSIM_TYPE_FLOAT32, typeStr, len)) 
     *type = VecSimType_FLOAT32;
+  else if (!strncasecmp(VECSIM_TYPE_FLOAT16, typeStr, len)) {
+    *type = VecSimType_FLOAT32;
+    *half = VectorHalf_Float16;
+  } else if (!strncasecmp(VECSIM_TYPE_BFLOAT16, typeStr, len)) {
+    *type = VecSimType_FLOAT32;
+    *half = VectorHalf_BFloat16;
+  }
   // else if (!strncasecmp(VECSIM_TYPE_FLOAT64, typeStr, len)) 
   //   *type = VecSimType_FLOAT64;
   // else if (!strncasecmp(VECSIM_TYPE_INT32, typeStr, len)) 
@@ -362,6 +372,21 @@ static int parseVectorField_GetMetric(ArgsCursor *ac, VecSimMetric *metric) {
   return AC_OK;
 }
 
+// Tries to get the quantization of the stored vectors from ac.
+static int parseVectorField_GetQuantization(ArgsCursor *ac, VectorQuantization *quant) {
+  const char *quantStr;
+  size_t len;
+  int rc;
+  if ((rc = AC_GetString(ac, &quantStr, &len, 0)) != AC_OK) {
+    return rc;
+  }
+  if (!strncasecmp(VECSIM_QUANT_INT8, quantStr, len))
+    *quant = VectorQuant_Int8;
+  else
+    return AC_ERR_ENOENT;
+  return AC_OK;
+}
+
 static int parseVectorField_hnsw(FieldSpec *fs, ArgsCursor *ac, QueryError *status) {
   int rc;
 
@@ -384,7 +409,7 @@ static int parseVectorField_hnsw(FieldSpec *fs, ArgsCursor *ac, QueryError *stat
 
   while (expNumParam > numParam && !AC_IsAtEnd(ac)) {
     if (AC_AdvanceIfMatch(ac, VECSIM_TYPE)) {
-      if ((rc = parseVectorField_GetType(ac, &fs->vecSimParams.hnswParams.type)) != AC_OK) {
+      if ((rc = parseVectorField_GetType(ac, &fs->vecSimParams.hnswParams.type, &fs->vecHalf)) != AC_OK) {
         QERR_MKBADARGS_AC(status, "vector similarity HNSW index type", rc);
         return 0;
       }
@@ -421,6 +446,10 @@ static int parseVectorField_hnsw(FieldSpec *fs, ArgsCursor *ac, QueryError *stat
         QERR_MKBADARGS_AC(status, "vector similarity HNSW index efRuntime", rc);
         return 0;
       }
+    } else if (AC_AdvanceIfMatch(ac, VECSIM_QUANTIZE)) {
+      QERR_MKBADARGS_FMT(status, "%s is only supported by the %s algorithm", VECSIM_QUANTIZE,
+                         VECSIM_ALGORITHM_BF);
+      return 0;
     } else {
       QERR_MKBADARGS_FMT(status, "Bad arguments for algorithm %s: %s", VECSIM_ALGORITHM_HNSW, AC_GetStringNC(ac, NULL));
       return 0;
@@ -469,7 +498,7 @@ static int parseVectorField_flat(FieldSpec *fs, ArgsCursor *ac, QueryError *stat
 
   while (expNumParam > numParam && !AC_IsAtEnd(ac)) {
     if (AC_AdvanceIfMatch(ac, VECSIM_TYPE)) {
-      if ((rc = parseVectorField_GetType(ac, &fs->vecSimParams.bfParams.type)) != AC_OK) {
+      if ((rc = parseVectorField_GetType(ac, &fs->vecSimParams.bfParams.type, &fs->vecHalf)) != AC_OK) {
         QERR_MKBADARGS_AC(status, "vector similarity FLAT index type", rc);
         return 0;
       }
@@ -496,6 +525,11 @@ static int parseVectorField_flat(FieldSpec *fs, ArgsCursor *ac, QueryError *stat
         QERR_MKBADARGS_AC(status, "vector similarity FLAT index blocksize", rc);
         return 0;
       }
+    } else if (AC_AdvanceIfMatch(ac, VECSIM_QUANTIZE)) {
+      if ((rc = parseVectorField_GetQuantization(ac, &fs->vecQuant)) != AC_OK) {
+        QERR_MKBADARGS_AC(status, "vector similarity FLAT index quantization", rc);
+        return 0;
+      }
     } else {
       QERR_MKBADARGS_FMT(status, "Bad arguments for algorithm %s: %s", VECSIM_ALGORITHM_BF, AC_GetStringNC(ac, NULL));
       return 0;
@@ -526,6 +560,8 @@ static int parseVectorField(FieldSpec *fs, ArgsCursor *ac, QueryError *status) {
   // init default type, size, distance metric and algorithm
 
   bzero(&fs->vecSimParams, sizeof(VecSimParams));
+  fs->vecQuant = VectorQuant_None;
+  fs->vecHalf = VectorHalf_None;
 
   // parse algorithm
   const char *algStr;
@@ -886,10 +922,59 @@ int IndexSpec_AddTerm(IndexSpec *sp, const char *term, size_t len) {
   if (isNew) {
     sp->stats.numTerms++;
     sp->stats.termsSize += len;
+    IndexSpec_InvalidatePrefixCache(sp, term, len);
+    if (sp->fuzzyIndex) {
+      FuzzyIndex_Add(sp->fuzzyIndex, term, len);
+    }
   }
   return isNew;
 }
 
+void IndexSpec_InvalidatePrefixCache(IndexSpec *sp, const char *term, size_t len) {
+  if (!sp->prefixCache || len > TRIE_INITIAL_STRING_LEN * sizeof(rune)) {
+    return;
+  }
+  // Prefix queries match folded runes, so the cache is keyed the same way
+  rune runes[TRIE_INITIAL_STRING_LEN * sizeof(rune)];
+  size_t rlen = strToRunesN(term, len, runes);
+  for (size_t i = 0; i < rlen; ++i) {
+    runes[i] = runeFold(runes[i]);
+  }
+  PrefixCache_InvalidatePrefixesOf(sp->prefixCache, (const char *)runes, rlen * sizeof(rune),
+                                   sizeof(rune));
+}
+
+FuzzyIndex *IndexSpec_GetFuzzyIndex(IndexSpec *sp) {
+  if (sp->fuzzyIndex) {
+    return sp->fuzzyIndex;
+  }
+  sp->fuzzyIndex = NewFuzzyIndex(FUZZY_INDEX_MAX_DIST, 0);
+  TrieIterator *it = Trie_Iterate(sp->terms, "", 0, 0, 1);
+  rune *rstr = NULL;
+  t_len slen = 0;
+  float score = 0;
+  int dist = 0;
+  while (TrieIterator_Next(it, &rstr, &slen, NULL, &score, &dist)) {
+    FuzzyIndex_AddRunes(sp->fuzzyIndex, rstr, slen);
+  }
+  DFAFilter_Free(it->ctx);
+  rm_free(it->ctx);
+  TrieIterator_Free(it);
+  return sp->fuzzyIndex;
+}
+
+void IndexSpec_DeleteFuzzyTerm(IndexSpec *sp, const char *term, size_t len) {
+  if (!sp->fuzzyIndex) {
+    return;
+  }
+  FuzzyIndex_Delete(sp->fuzzyIndex, term, len);
+  // drop it once it's mostly tombstones, the next fuzzy query rebuilds it
+  if (FuzzyIndex_NeedsRebuild(sp->fuzzyIndex)) {
+    FuzzyIndex_Free(sp->fuzzyIndex);
+    sp->fuzzyIndex = NULL;
+  }
+}
+
 void Spec_AddToDict(const IndexSpec *sp) {
   dictAdd(specDict_g, sp->name, (void *)sp);
 }
@@ -1013,6 +1098,12 @@ void IndexSpec_FreeInternals(IndexSpec *spec) {
   if (spec->terms) {
     TrieType_Free(spec->terms);
   }
+  if (spec->prefixCache) {
+    PrefixCache_Free(spec->prefixCache);
+  }
+  if (spec->fuzzyIndex) {
+    FuzzyIndex_Free(spec->fuzzyIndex);
+  }
   DocTable_Free(&spec->docs);
 
   if (spec->uniqueId) {
@@ -1421,6 +1512,58 @@ fail:
   return REDISMODULE_ERR;
 }
 
+static void VectorParams_RdbSave(RedisModuleIO *rdb, FieldSpec *f) {
+  const VecSimParams *params = &f->vecSimParams;
+  RedisModule_SaveUnsigned(rdb, params->algo);
+  if (params->algo == VecSimAlgo_BF) {
+    RedisModule_SaveUnsigned(rdb, params->bfParams.type);
+    RedisModule_SaveUnsigned(rdb, params->bfParams.dim);
+    RedisModule_SaveUnsigned(rdb, params->bfParams.metric);
+    RedisModule_SaveUnsigned(rdb, params->bfParams.initialCapacity);
+    RedisModule_SaveUnsigned(rdb, params->bfParams.blockSize);
+  } else {
+    RedisModule_SaveUnsigned(rdb, params->hnswParams.type);
+    RedisModule_SaveUnsigned(rdb, params->hnswParams.dim);
+    RedisModule_SaveUnsigned(rdb, params->hnswParams.metric);
+    RedisModule_SaveUnsigned(rdb, params->hnswParams.initialCapacity);
+    RedisModule_SaveUnsigned(rdb, params->hnswParams.M);
+    RedisModule_SaveUnsigned(rdb, params->hnswParams.efConstruction);
+    RedisModule_SaveUnsigned(rdb, params->hnswParams.efRuntime);
+  }
+  RedisModule_SaveUnsigned(rdb, f->vecQuant);
+  RedisModule_SaveUnsigned(rdb, f->vecHalf);
+}
+
+static int VectorParams_RdbLoad(RedisModuleIO *rdb, FieldSpec *f, int encver) {
+  VecSimParams *params = &f->vecSimParams;
+  params->algo = LoadUnsigned_IOError(rdb, goto fail);
+  if (params->algo == VecSimAlgo_BF) {
+    params->bfParams.type = LoadUnsigned_IOError(rdb, goto fail);
+    params->bfParams.dim = LoadUnsigned_IOError(rdb, goto fail);
+    params->bfParams.metric = LoadUnsigned_IOError(rdb, goto fail);
+    params->bfParams.initialCapacity = LoadUnsigned_IOError(rdb, goto fail);
+    params->bfParams.blockSize = LoadUnsigned_IOError(rdb, goto fail);
+  } else if (params->algo == VecSimAlgo_HNSWLIB) {
+    params->hnswParams.type = LoadUnsigned_IOError(rdb, goto fail);
+    params->hnswParams.dim = LoadUnsigned_IOError(rdb, goto fail);
+    params->hnswParams.metric = LoadUnsigned_IOError(rdb, goto fail);
+    params->hnswParams.initialCapacity = LoadUnsigned_IOError(rdb, goto fail);
+    params->hnswParams.M = LoadUnsigned_IOError(rdb, goto fail);
+    params->hnswParams.efConstruction = LoadUnsigned_IOError(rdb, goto fail);
+    params->hnswParams.efRuntime = LoadUnsigned_IOError(rdb, goto fail);
+  } else {
+    goto fail;
+  }
+  f->vecQuant = LoadUnsigned_IOError(rdb, goto fail);
+  if (encver >= INDEX_VECSIM_HALF_VERSION) {
+    f->vecHalf = LoadUnsigned_IOError(rdb, goto fail);
+  }
+  return REDISMODULE_OK;
+
+fail:
+  return REDISMODULE_ERR;
+}
+
 static void FieldSpec_RdbSave(RedisModuleIO *rdb, FieldSpec *f) {
   RedisModule_SaveStringBuffer(rdb, f->name, strlen(f->name) + 1);
   if (f->path != f->name) {
@@ -1441,6 +1584,10 @@ static void FieldSpec_RdbSave(RedisModuleIO *rdb, FieldSpec *f) {
     RedisModule_SaveUnsigned(rdb, f->tagFlags);
     RedisModule_SaveStringBuffer(rdb, &f->tagSep, 1);
   }
+  // Save vector specific options
+  if (FIELD_IS(f, INDEXFLD_T_VECTOR)) {
+    VectorParams_RdbSave(rdb, f);
+  }
 }
 
 static const FieldType fieldTypeMap[] = {[IDXFLD_LEGACY_FULLTEXT] = INDEXFLD_T_FULLTEXT,
@@ -1488,6 +1635,12 @@ static int FieldSpec_RdbLoad(RedisModuleIO *rdb, FieldSpec *f, int encver) {
     f->tagSep = *s;
     RedisModule_Free(s);
   }
+  // Load vector specific options
+  if (FIELD_IS(f, INDEXFLD_T_VECTOR) && encver >= INDEX_VECSIM_VERSION) {
+    if (VectorParams_RdbLoad(rdb, f, encver) != REDISMODULE_OK) {
+      goto fail;
+    }
+  }
   return REDISMODULE_OK;
 
 fail:
@@ -2248,8 +2401,11 @@ int IndexSpec_DeleteDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString
         if (!kdv) {
           continue;
         }
-        VecSimIndex *vecsim = kdv->p;
-        VecSimIndex_DeleteVector(vecsim, id);
+        if (spec->fields[i].vecQuant != VectorQuant_None) {
+          QuantizedVectors_Delete(kdv->p, id);
+        } else {
+          VectorIndex_DeleteVector(kdv->p, id);
+        }
       }
     }
   }
@@ -147,6 +147,10 @@ typedef enum {
   Index_FromLLAPI = 0x2000,
   Index_HasFieldAlias = 0x4000,
   Index_HasVecSim = 0x8000,
+
+  // Term offsets of full-layout term indexes are kept in a per-block stream, parallel to the
+  // records, rather than interleaved with them
+  Index_SplitTermOffsets = 0x10000,
 } IndexFlags;
 
 // redis version (its here because most file include it with no problem,
@@ -172,14 +176,21 @@ extern bool isTrimming;
  */
 typedef uint16_t FieldSpecDedupeArray[SPEC_MAX_FIELDS];
 
-#define INDEX_DEFAULT_FLAGS \
-  Index_StoreFreqs | Index_StoreTermOffsets | Index_StoreFieldFlags | Index_StoreByteOffsets
+#define INDEX_DEFAULT_FLAGS                                                                  \
+  Index_StoreFreqs | Index_StoreTermOffsets | Index_StoreFieldFlags | Index_StoreByteOffsets | \
+      Index_SplitTermOffsets
 
 #define INDEX_STORAGE_MASK                                                                  \
   (Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets | Index_StoreNumeric | \
    Index_WideSchema)
 
-#define INDEX_CURRENT_VERSION 18
+// Offsets are only split out of the full (freqs, fields, offsets) layout
+#define INDEX_FULL_STORAGE (Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets)
+#define INDEX_SPLIT_OFFSETS(flags)                                \
+  (((flags) & (INDEX_FULL_STORAGE | Index_SplitTermOffsets)) == \
+   (INDEX_FULL_STORAGE | Index_SplitTermOffsets))
+
+#define INDEX_CURRENT_VERSION 20
 #define INDEX_JSON_VERSION 18
 #define INDEX_MIN_COMPAT_VERSION 17
 
@@ -215,6 +226,11 @@ typedef uint16_t FieldSpecDedupeArray[SPEC_MAX_FIELDS];
 
 #define INDEX_MIN_ALIAS_VERSION 15
 
+// Versions below this one don't save the vector field parameters
+#define INDEX_VECSIM_VERSION 19
+// Versions below this one don't save the half precision type of vector fields
+#define INDEX_VECSIM_HALF_VERSION 20
+
 #define IDXFLD_LEGACY_FULLTEXT 0
 #define IDXFLD_LEGACY_NUMERIC 1
 #define IDXFLD_LEGACY_GEO 2
@@ -241,6 +257,11 @@ typedef struct IndexSpec {
   IndexFlags flags;
 
   Trie *terms;
+  // cached prefix expansions of `terms`, keyed by the folded runes of the prefix. Lazily created
+  struct PrefixCache *prefixCache;
+  // deletion-neighbourhood index of `terms` for fuzzy matching. Lazily built on the first fuzzy
+  // query, see IndexSpec_GetFuzzyIndex()
+  struct FuzzyIndex *fuzzyIndex;
 
   RSSortingTable *sortables;
 
@@ -471,6 +492,16 @@ extern void (*IndexSpec_OnCreate)(const IndexSpec *sp);
 
 int IndexSpec_AddTerm(IndexSpec *sp, const char *term, size_t len);
 
+/* Drop the cached prefix expansions which `term` belongs to. Must be called whenever a term is
+ * added to or removed from the spec's terms trie */
+void IndexSpec_InvalidatePrefixCache(IndexSpec *sp, const char *term, size_t len);
+
+/* Get the fuzzy index of the spec's terms, building it if needed */
+struct FuzzyIndex *IndexSpec_GetFuzzyIndex(IndexSpec *sp);
+
+/* Remove a term deleted from the terms trie from the fuzzy index, if there is one */
+void IndexSpec_DeleteFuzzyTerm(IndexSpec *sp, const char *term, size_t len);
+
 /* Get a random term from the index spec using weighted random. Weighted random is done by sampling
  * N terms from the index and then doing weighted random on them. A sample size of 10-20 should be
  * enough */
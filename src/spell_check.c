@@ -1,6 +1,7 @@
 #include "spell_check.h"
 #include "util/arr.h"
 #include "dictionary.h"
+#include "trie/fuzzy_index.h"
 #include <stdbool.h>
 
 /** Forward declaration **/
@@ -137,6 +138,21 @@ static void SpellCheck_FindSuggestions(SpellCheckCtx *scCtx, Trie *t, const char
   int dist = 0;
   size_t suggestionLen;
 
+  // the index terms are looked up in the spec's fuzzy index, dictionaries walk their trie
+  IndexSpec *spec = scCtx->sctx->spec;
+  if (t == spec->terms && scCtx->distance <= FUZZY_INDEX_MAX_DIST) {
+    FuzzyIndexMatch *matches =
+        FuzzyIndex_Find(IndexSpec_GetFuzzyIndex(spec), term, len, (int)scCtx->distance);
+    for (uint32_t i = 0; i < array_len(matches); ++i) {
+      double score;
+      if ((score = SpellCheck_GetScore(scCtx, matches[i].str, matches[i].len, fieldMask)) != -1) {
+        RS_SuggestionsAdd(s, matches[i].str, matches[i].len, score, incr);
+      }
+    }
+    FuzzyIndex_FreeMatches(matches);
+    return;
+  }
+
   TrieIterator *it = Trie_Iterate(t, term, len, (int)scCtx->distance, 0);
   // TrieIterator can be NULL when rune length exceed TRIE_MAX_PREFIX
   if (it == NULL) {
@@ -6,6 +6,7 @@
 #include "rmutil/util.h"
 #include "util/misc.h"
 #include "util/arr.h"
+#include "util/prefix_cache.h"
 #include "rmutil/rm_assert.h"
 
 extern RedisModuleCtx *RSDummyContext;
@@ -18,6 +19,7 @@ static uint32_t tagUniqueId = 0;
 TagIndex *NewTagIndex() {
   TagIndex *idx = rm_new(TagIndex);
   idx->values = NewTrieMap();
+  idx->prefixCache = NULL;
   idx->uniqueId = tagUniqueId++;
   return idx;
 }
@@ -108,6 +110,7 @@ struct InvertedIndex *TagIndex_OpenIndex(TagIndex *idx, const char *value, size_
     if (create) {
       iv = NewInvertedIndex(Index_DocIdsOnly, 1);
       TrieMap_Add(idx->values, (char *)value, len, iv, NULL);
+      PrefixCache_InvalidatePrefixesOf(idx->prefixCache, value, len, 1);
     }
   }
   return iv;
@@ -333,6 +336,9 @@ void TagIndex_RdbSave(RedisModuleIO *rdb, void *value) {
 void TagIndex_Free(void *p) {
   TagIndex *idx = p;
   TrieMap_Free(idx->values, InvertedIndex_Free);
+  if (idx->prefixCache) {
+    PrefixCache_Free(idx->prefixCache);
+  }
   rm_free(idx);
 }
 
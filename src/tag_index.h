@@ -96,6 +96,8 @@ extern "C" {
 typedef struct {
   uint32_t uniqueId;
   TrieMap *values;
+  // cached prefix expansions of `values`. Lazily created
+  struct PrefixCache *prefixCache;
 } TagIndex;
 
 #define TAG_INDEX_KEY_FMT "tag:%s/%s"
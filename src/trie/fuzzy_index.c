@@ -0,0 +1,283 @@
+#include "fuzzy_index.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+#include "util/fnv.h"
+#include "util/khash.h"
+#include <string.h>
+#include <sys/param.h>
+
+#define FUZZY_INDEX_MAX_PREFIX_LEN 16
+#define FNV1A_64_INIT 0xcbf29ce484222325ULL
+// Different seeds for the term identity hash and the deletion hashes, so that a term and one of
+// its own deletions never share a key by construction
+#define FUZZY_TERM_SEED (FNV1A_64_INIT)
+#define FUZZY_DELETE_SEED (FNV1A_64_INIT ^ 0x5bd1e995)
+
+// deletion hash -> array of the ids of the terms it was generated from
+KHASH_MAP_INIT_INT64(fuzzyDeletes, uint32_t *)
+// term hash -> term id
+KHASH_MAP_INIT_INT64(fuzzyIds, uint32_t)
+
+typedef struct {
+  // NULL once the term was deleted
+  rune *runes;
+  uint32_t len;
+} fuzzyTerm;
+
+struct FuzzyIndex {
+  khash_t(fuzzyDeletes) * deletes;
+  khash_t(fuzzyIds) * ids;
+  // all the terms ever added, indexed by id
+  fuzzyTerm *terms;
+  size_t numTerms;
+  size_t numDeleted;
+  int maxDist;
+  int prefixLen;
+};
+
+FuzzyIndex *NewFuzzyIndex(int maxDist, int prefixLen) {
+  FuzzyIndex *fi = rm_calloc(1, sizeof(*fi));
+  fi->deletes = kh_init(fuzzyDeletes);
+  fi->ids = kh_init(fuzzyIds);
+  fi->terms = array_new(fuzzyTerm, 16);
+  fi->maxDist = maxDist;
+  fi->prefixLen = prefixLen ? MIN(prefixLen, FUZZY_INDEX_MAX_PREFIX_LEN) : FUZZY_INDEX_PREFIX_LEN;
+  return fi;
+}
+
+void FuzzyIndex_Free(FuzzyIndex *fi) {
+  for (khiter_t it = kh_begin(fi->deletes); it != kh_end(fi->deletes); ++it) {
+    if (kh_exist(fi->deletes, it)) {
+      array_free(kh_value(fi->deletes, it));
+    }
+  }
+  kh_destroy(fuzzyDeletes, fi->deletes);
+  kh_destroy(fuzzyIds, fi->ids);
+  for (size_t i = 0; i < array_len(fi->terms); ++i) {
+    rm_free(fi->terms[i].runes);
+  }
+  array_free(fi->terms);
+  rm_free(fi);
+}
+
+int FuzzyIndex_MaxDist(const FuzzyIndex *fi) {
+  return fi->maxDist;
+}
+
+size_t FuzzyIndex_NumTerms(const FuzzyIndex *fi) {
+  return fi->numTerms;
+}
+
+int FuzzyIndex_NeedsRebuild(const FuzzyIndex *fi) {
+  return fi->numDeleted > fi->numTerms;
+}
+
+typedef void (*fuzzyDeleteCallback)(uint64_t key, void *ctx);
+
+/* Call cb with the hash of s and of every string obtained by deleting up to `edits` runes from it.
+ * Deletions are done in increasing position order so each combination is only visited once */
+static void fuzzyGenDeletes(const rune *s, size_t n, size_t start, int edits,
+                            fuzzyDeleteCallback cb, void *ctx) {
+  cb(fnv_64a_buf(s, n * sizeof(rune), FUZZY_DELETE_SEED), ctx);
+  if (!edits) {
+    return;
+  }
+  rune buf[FUZZY_INDEX_MAX_PREFIX_LEN];
+  for (size_t i = start; i < n; ++i) {
+    memcpy(buf, s, i * sizeof(rune));
+    memcpy(buf + i, s + i + 1, (n - i - 1) * sizeof(rune));
+    fuzzyGenDeletes(buf, n - 1, i, edits - 1, cb, ctx);
+  }
+}
+
+static fuzzyTerm *fuzzyIndex_FindTerm(FuzzyIndex *fi, const rune *runes, size_t len,
+                                      khiter_t *pit) {
+  uint64_t h = fnv_64a_buf(runes, len * sizeof(rune), FUZZY_TERM_SEED);
+  khiter_t it = kh_get(fuzzyIds, fi->ids, h);
+  if (it == kh_end(fi->ids)) {
+    return NULL;
+  }
+  fuzzyTerm *t = fi->terms + kh_value(fi->ids, it);
+  if (t->len != len || memcmp(t->runes, runes, len * sizeof(rune))) {
+    return NULL;
+  }
+  if (pit) *pit = it;
+  return t;
+}
+
+typedef struct {
+  FuzzyIndex *fi;
+  uint32_t id;
+} fuzzyAddCtx;
+
+static void fuzzyAddDelete(uint64_t key, void *p) {
+  fuzzyAddCtx *ctx = p;
+  int added;
+  khiter_t it = kh_put(fuzzyDeletes, ctx->fi->deletes, key, &added);
+  if (added) {
+    kh_value(ctx->fi->deletes, it) = array_new(uint32_t, 1);
+  }
+  uint32_t *ids = kh_value(ctx->fi->deletes, it);
+  // repeated runes generate the same deletion more than once
+  if (array_len(ids) && array_tail(ids) == ctx->id) {
+    return;
+  }
+  kh_value(ctx->fi->deletes, it) = array_append(ids, ctx->id);
+}
+
+int FuzzyIndex_AddRunes(FuzzyIndex *fi, const rune *runes, size_t len) {
+  if (!len || fuzzyIndex_FindTerm(fi, runes, len, NULL)) {
+    return 0;
+  }
+
+  fuzzyTerm t = {.runes = rm_malloc(len * sizeof(rune)), .len = len};
+  memcpy(t.runes, runes, len * sizeof(rune));
+  uint32_t id = array_len(fi->terms);
+  fi->terms = array_append(fi->terms, t);
+  fi->numTerms++;
+
+  int added;
+  uint64_t h = fnv_64a_buf(runes, len * sizeof(rune), FUZZY_TERM_SEED);
+  khiter_t it = kh_put(fuzzyIds, fi->ids, h, &added);
+  // on a hash collision the older term keeps the slot, the new one just can't be deleted
+  if (added) {
+    kh_value(fi->ids, it) = id;
+  }
+
+  fuzzyAddCtx ctx = {.fi = fi, .id = id};
+  fuzzyGenDeletes(runes, MIN(len, fi->prefixLen), 0, fi->maxDist, fuzzyAddDelete, &ctx);
+  return 1;
+}
+
+int FuzzyIndex_Add(FuzzyIndex *fi, const char *str, size_t len) {
+  rune *runes = rm_malloc(len * sizeof(rune) + 1);
+  size_t rlen = strToRunesN(str, len, runes);
+  int rc = FuzzyIndex_AddRunes(fi, runes, rlen);
+  rm_free(runes);
+  return rc;
+}
+
+int FuzzyIndex_Delete(FuzzyIndex *fi, const char *str, size_t len) {
+  rune *runes = rm_malloc(len * sizeof(rune) + 1);
+  size_t rlen = strToRunesN(str, len, runes);
+  khiter_t it;
+  fuzzyTerm *t = fuzzyIndex_FindTerm(fi, runes, rlen, &it);
+  rm_free(runes);
+  if (!t) {
+    return 0;
+  }
+  // the postings still point at the tombstone, they are only dropped by a rebuild
+  rm_free(t->runes);
+  t->runes = NULL;
+  kh_del(fuzzyIds, fi->ids, it);
+  fi->numTerms--;
+  fi->numDeleted++;
+  return 1;
+}
+
+/* Levenshtein distance between a and b, or maxDist + 1 if it is larger than maxDist */
+static int fuzzyDistance(const rune *a, size_t alen, const rune *b, size_t blen, int maxDist) {
+  if ((alen > blen ? alen - blen : blen - alen) > maxDist) {
+    return maxDist + 1;
+  }
+  int row[blen + 1];
+  for (size_t j = 0; j <= blen; ++j) {
+    row[j] = j;
+  }
+  for (size_t i = 1; i <= alen; ++i) {
+    int diag = row[0];
+    int rowMin = row[0] = i;
+    for (size_t j = 1; j <= blen; ++j) {
+      int up = row[j];
+      int v = diag + (a[i - 1] != b[j - 1]);
+      v = MIN(v, up + 1);
+      v = MIN(v, row[j - 1] + 1);
+      row[j] = v;
+      diag = up;
+      rowMin = MIN(rowMin, v);
+    }
+    if (rowMin > maxDist) {
+      return maxDist + 1;
+    }
+  }
+  return row[blen];
+}
+
+typedef struct {
+  FuzzyIndex *fi;
+  uint32_t *candidates;
+} fuzzyFindCtx;
+
+static void fuzzyCollectDelete(uint64_t key, void *p) {
+  fuzzyFindCtx *ctx = p;
+  khiter_t it = kh_get(fuzzyDeletes, ctx->fi->deletes, key);
+  if (it == kh_end(ctx->fi->deletes)) {
+    return;
+  }
+  uint32_t *ids = kh_value(ctx->fi->deletes, it);
+  for (uint32_t i = 0; i < array_len(ids); ++i) {
+    ctx->candidates = array_append(ctx->candidates, ids[i]);
+  }
+}
+
+static int cmpIds(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+static int cmpMatches(const void *a, const void *b) {
+  const FuzzyIndexMatch *x = a, *y = b;
+  if (x->dist != y->dist) {
+    return x->dist - y->dist;
+  }
+  // utf-8 byte order is the same as code point order
+  int rc = memcmp(x->str, y->str, MIN(x->len, y->len));
+  return rc ? rc : (x->len > y->len) - (x->len < y->len);
+}
+
+FuzzyIndexMatch *FuzzyIndex_Find(FuzzyIndex *fi, const char *str, size_t len, int maxDist) {
+  if (maxDist < 0 || maxDist > fi->maxDist) {
+    return NULL;
+  }
+  FuzzyIndexMatch *matches = array_new(FuzzyIndexMatch, 8);
+
+  rune *runes = rm_malloc(len * sizeof(rune) + 1);
+  size_t rlen = strToRunesN(str, len, runes);
+  for (size_t i = 0; i < rlen; ++i) {
+    runes[i] = runeFold(runes[i]);
+  }
+
+  fuzzyFindCtx ctx = {.fi = fi, .candidates = array_new(uint32_t, 16)};
+  fuzzyGenDeletes(runes, MIN(rlen, fi->prefixLen), 0, maxDist, fuzzyCollectDelete, &ctx);
+
+  uint32_t *cands = ctx.candidates;
+  qsort(cands, array_len(cands), sizeof(*cands), cmpIds);
+  for (uint32_t i = 0; i < array_len(cands); ++i) {
+    if (i && cands[i] == cands[i - 1]) {
+      continue;
+    }
+    fuzzyTerm *t = fi->terms + cands[i];
+    if (!t->runes) {
+      continue;
+    }
+    int dist = fuzzyDistance(runes, rlen, t->runes, t->len, maxDist);
+    if (dist > maxDist) {
+      continue;
+    }
+    FuzzyIndexMatch m = {.dist = dist};
+    m.str = runesToStr(t->runes, t->len, &m.len);
+    matches = array_append(matches, m);
+  }
+  array_free(cands);
+  rm_free(runes);
+
+  qsort(matches, array_len(matches), sizeof(*matches), cmpMatches);
+  return matches;
+}
+
+void FuzzyIndex_FreeMatches(FuzzyIndexMatch *matches) {
+  for (uint32_t i = 0; i < array_len(matches); ++i) {
+    rm_free(matches[i].str);
+  }
+  array_free(matches);
+}
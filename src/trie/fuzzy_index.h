@@ -0,0 +1,65 @@
+#ifndef __RS_FUZZY_INDEX_H__
+#define __RS_FUZZY_INDEX_H__
+
+/* FuzzyIndex - a symmetric delete (SymSpell style) index over a set of terms, used to find all the
+ * terms within a small Levenshtein distance of a query without walking the whole trie.
+ *
+ * Every term is indexed under all the strings obtained by deleting up to `maxDist` runes from its
+ * first `prefixLen` runes. A query generates the same deletions of its own prefix, and every term
+ * sharing at least one of them is a candidate. Candidates are then verified with the real edit
+ * distance, so the deletion keys are only stored as 64 bit hashes - a collision costs an extra
+ * verification, never a wrong result.
+ *
+ * Deleted terms are tombstoned; callers should rebuild the index once
+ * FuzzyIndex_NeedsRebuild() says so. Not thread safe. */
+#include <stdlib.h>
+#include <stdint.h>
+#include "rune_util.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FUZZY_INDEX_MAX_DIST 2
+#define FUZZY_INDEX_PREFIX_LEN 7
+
+typedef struct {
+  char *str;
+  size_t len;
+  int dist;
+} FuzzyIndexMatch;
+
+typedef struct FuzzyIndex FuzzyIndex;
+
+/* Create an index answering queries of up to maxDist edits. A prefixLen of 0 means the default */
+FuzzyIndex *NewFuzzyIndex(int maxDist, int prefixLen);
+
+void FuzzyIndex_Free(FuzzyIndex *fi);
+
+/* Add a term. Returns 1 if it was added, 0 if it already exists */
+int FuzzyIndex_Add(FuzzyIndex *fi, const char *str, size_t len);
+int FuzzyIndex_AddRunes(FuzzyIndex *fi, const rune *runes, size_t len);
+
+/* Remove a term. Returns 1 if it was found */
+int FuzzyIndex_Delete(FuzzyIndex *fi, const char *str, size_t len);
+
+/* The maximal distance the index can answer queries for */
+int FuzzyIndex_MaxDist(const FuzzyIndex *fi);
+
+/* Number of live terms in the index */
+size_t FuzzyIndex_NumTerms(const FuzzyIndex *fi);
+
+/* True once tombstoned terms outnumber the live ones */
+int FuzzyIndex_NeedsRebuild(const FuzzyIndex *fi);
+
+/* Find all the terms within maxDist edits of str, after case folding it. Returns an array (see
+ * util/arr.h) sorted by distance and then lexicographically, which the caller frees with
+ * FuzzyIndex_FreeMatches(). Returns NULL if maxDist is larger than the index supports */
+FuzzyIndexMatch *FuzzyIndex_Find(FuzzyIndex *fi, const char *str, size_t len, int maxDist);
+
+void FuzzyIndex_FreeMatches(FuzzyIndexMatch *matches);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,63 @@
+#include "bitset.h"
+#include <string.h>
+#include "rmalloc.h"
+
+void Bitset_Init(Bitset *bs) {
+  bs->words = NULL;
+  bs->nwords = 0;
+  bs->count = 0;
+}
+
+void Bitset_Free(Bitset *bs) {
+  rm_free(bs->words);
+  Bitset_Init(bs);
+}
+
+static void Bitset_Grow(Bitset *bs, size_t minWords) {
+  // grow by half of the current size to amortize the reallocations of an incrementing id
+  size_t nwords = bs->nwords + bs->nwords / 2 + 1;
+  if (nwords < minWords) {
+    nwords = minWords;
+  }
+  bs->words = rm_realloc(bs->words, nwords * sizeof(*bs->words));
+  memset(bs->words + bs->nwords, 0, (nwords - bs->nwords) * sizeof(*bs->words));
+  bs->nwords = nwords;
+}
+
+void Bitset_Set(Bitset *bs, uint64_t id) {
+  size_t w = id / BITSET_WORD_BITS;
+  if (w >= bs->nwords) {
+    Bitset_Grow(bs, w + 1);
+  }
+  uint64_t mask = 1ULL << (id % BITSET_WORD_BITS);
+  if (!(bs->words[w] & mask)) {
+    bs->words[w] |= mask;
+    ++bs->count;
+  }
+}
+
+void Bitset_Clear(Bitset *bs, uint64_t id) {
+  size_t w = id / BITSET_WORD_BITS;
+  if (w >= bs->nwords) {
+    return;
+  }
+  uint64_t mask = 1ULL << (id % BITSET_WORD_BITS);
+  if (bs->words[w] & mask) {
+    bs->words[w] &= ~mask;
+    --bs->count;
+  }
+}
+
+size_t Bitset_CountUpTo(const Bitset *bs, uint64_t upto) {
+  size_t last = upto / BITSET_WORD_BITS;
+  if (last >= bs->nwords) {
+    return bs->count;
+  }
+  size_t n = 0;
+  for (size_t w = 0; w < last; ++w) {
+    n += __builtin_popcountll(bs->words[w]);
+  }
+  unsigned shift = BITSET_WORD_BITS - 1 - (upto % BITSET_WORD_BITS);
+  n += __builtin_popcountll(bs->words[last] << shift);
+  return n;
+}
@@ -0,0 +1,66 @@
+#ifndef __RS_BITSET_H__
+#define __RS_BITSET_H__
+
+/* Bitset - a growable, thread-unsafe set of non-negative integer ids, stored one bit per id.
+ * Iteration is done a 64-bit word at a time, so sparse regions are skipped quickly */
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BITSET_WORD_BITS 64
+#define BITSET_NOTFOUND UINT64_MAX
+
+typedef struct {
+  uint64_t *words;
+  size_t nwords;
+  // number of bits set
+  size_t count;
+} Bitset;
+
+void Bitset_Init(Bitset *bs);
+
+void Bitset_Free(Bitset *bs);
+
+/* Set the bit for `id`, growing the set if needed */
+void Bitset_Set(Bitset *bs, uint64_t id);
+
+/* Clear the bit for `id`. Out of range ids are ignored */
+void Bitset_Clear(Bitset *bs, uint64_t id);
+
+static inline int Bitset_Test(const Bitset *bs, uint64_t id) {
+  size_t w = id / BITSET_WORD_BITS;
+  return w < bs->nwords && (bs->words[w] >> (id % BITSET_WORD_BITS)) & 1;
+}
+
+/* Return the smallest set id which is >= `from`, or BITSET_NOTFOUND if there is none */
+static inline uint64_t Bitset_NextSet(const Bitset *bs, uint64_t from) {
+  size_t w = from / BITSET_WORD_BITS;
+  if (w >= bs->nwords) {
+    return BITSET_NOTFOUND;
+  }
+  // mask out the bits below `from` in the first word
+  uint64_t word = bs->words[w] & (~0ULL << (from % BITSET_WORD_BITS));
+  while (!word) {
+    if (++w == bs->nwords) {
+      return BITSET_NOTFOUND;
+    }
+    word = bs->words[w];
+  }
+  return w * BITSET_WORD_BITS + __builtin_ctzll(word);
+}
+
+/* Return the number of set ids in the range [0, upto] */
+size_t Bitset_CountUpTo(const Bitset *bs, uint64_t upto);
+
+/* Return the memory used by the set */
+static inline size_t Bitset_MemUsage(const Bitset *bs) {
+  return bs->nwords * sizeof(*bs->words);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -1,8 +1,8 @@
 #ifndef MINMAX_H
 #define MINMAX_H
 
-#define Min(a, b) (a) < (b) ? (a) : (b)
-#define Max(a, b) (a) > (b) ? (a) : (b)
+#define Min(a, b) ((a) < (b) ? (a) : (b))
+#define Max(a, b) ((a) > (b) ? (a) : (b))
 #ifndef MIN
 #define MIN Min
 #endif
@@ -0,0 +1,82 @@
+#include "prefix_cache.h"
+#include "rmalloc.h"
+#include <string.h>
+
+// TrieMap keys are limited by the width of tm_len_t
+#define PREFIX_CACHE_MAX_KEYLEN ((tm_len_t)-1)
+
+PrefixCache *NewPrefixCache(size_t maxEntries) {
+  PrefixCache *pc = rm_calloc(1, sizeof(*pc));
+  pc->entries = NewTrieMap();
+  pc->maxEntries = maxEntries ? maxEntries : PREFIX_CACHE_DEFAULT_SIZE;
+  return pc;
+}
+
+static void prefixCacheEntry_Free(void *p) {
+  PrefixCacheEntry *e = p;
+  for (size_t i = 0; i < e->numTerms; ++i) {
+    rm_free(e->terms[i].str);
+  }
+  rm_free(e->terms);
+  rm_free(e);
+}
+
+void PrefixCache_Free(PrefixCache *pc) {
+  TrieMap_Free(pc->entries, prefixCacheEntry_Free);
+  rm_free(pc);
+}
+
+void PrefixCache_Clear(PrefixCache *pc) {
+  TrieMap_Free(pc->entries, prefixCacheEntry_Free);
+  pc->entries = NewTrieMap();
+}
+
+const PrefixCacheEntry *PrefixCache_Find(PrefixCache *pc, const char *key, size_t len,
+                                         size_t limit) {
+  if (len > PREFIX_CACHE_MAX_KEYLEN) {
+    return NULL;
+  }
+  PrefixCacheEntry *e = TrieMap_Find(pc->entries, (char *)key, len);
+  // An entry truncated at a lower limit cannot serve a larger expansion
+  if (e == TRIEMAP_NOTFOUND || (e->numTerms == e->limit && e->limit < limit)) {
+    pc->misses++;
+    return NULL;
+  }
+  pc->hits++;
+  return e;
+}
+
+PrefixCacheEntry *PrefixCache_Add(PrefixCache *pc, const char *key, size_t len, size_t limit) {
+  if (len > PREFIX_CACHE_MAX_KEYLEN) {
+    return NULL;
+  }
+  if (pc->entries->cardinality >= pc->maxEntries) {
+    PrefixCache_Clear(pc);
+  }
+  PrefixCacheEntry *e = rm_calloc(1, sizeof(*e));
+  e->limit = limit;
+  TrieMap_Delete(pc->entries, (char *)key, len, prefixCacheEntry_Free);
+  TrieMap_Add(pc->entries, (char *)key, len, e, NULL);
+  return e;
+}
+
+void PrefixCacheEntry_AddTerm(PrefixCacheEntry *e, const char *str, size_t len) {
+  // grow in powers of two
+  if (!(e->numTerms & (e->numTerms - 1))) {
+    e->terms = rm_realloc(e->terms, (e->numTerms ? e->numTerms * 2 : 1) * sizeof(*e->terms));
+  }
+  PrefixCacheTerm *t = e->terms + e->numTerms++;
+  t->str = rm_malloc(len + 1);
+  memcpy(t->str, str, len);
+  t->str[len] = '\0';
+  t->len = len;
+}
+
+void PrefixCache_InvalidatePrefixesOf(PrefixCache *pc, const char *s, size_t len, size_t unit) {
+  if (!pc || pc->entries->cardinality == 0) {
+    return;
+  }
+  for (size_t n = unit; n <= len && n <= PREFIX_CACHE_MAX_KEYLEN; n += unit) {
+    TrieMap_Delete(pc->entries, (char *)s, n, prefixCacheEntry_Free);
+  }
+}
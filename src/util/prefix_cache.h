@@ -0,0 +1,65 @@
+#ifndef __RS_PREFIX_CACHE_H__
+#define __RS_PREFIX_CACHE_H__
+
+/* PrefixCache - a bounded map of prefix -> the list of terms it expands to, so that repeated
+ * prefix queries do not need to walk the terms trie again. Keys are opaque byte strings, so the
+ * caller decides on the key encoding (e.g. folded runes for the terms trie, raw bytes for tags).
+ *
+ * The owner of the cached trie must call PrefixCache_InvalidatePrefixesOf() whenever a term is
+ * added or removed. When the cache is full it is simply cleared. Not thread safe. */
+#include <stdlib.h>
+#include "triemap/triemap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PREFIX_CACHE_DEFAULT_SIZE 256
+
+typedef struct {
+  char *str;
+  size_t len;
+} PrefixCacheTerm;
+
+typedef struct {
+  // array of expanded terms, in trie order
+  PrefixCacheTerm *terms;
+  size_t numTerms;
+  // the expansion limit the entry was built with. If numTerms is below it, the list is complete
+  size_t limit;
+} PrefixCacheEntry;
+
+typedef struct PrefixCache {
+  TrieMap *entries;
+  size_t maxEntries;
+  // stats
+  size_t hits;
+  size_t misses;
+} PrefixCache;
+
+PrefixCache *NewPrefixCache(size_t maxEntries);
+
+void PrefixCache_Free(PrefixCache *pc);
+
+/* Drop all the cached entries */
+void PrefixCache_Clear(PrefixCache *pc);
+
+/* Get the cached expansion of `key`, if it can serve a query expanding up to `limit` terms.
+ * Returns NULL otherwise */
+const PrefixCacheEntry *PrefixCache_Find(PrefixCache *pc, const char *key, size_t len,
+                                         size_t limit);
+
+/* Create a new, empty entry for `key`, replacing any existing one. The caller fills it with
+ * PrefixCacheEntry_AddTerm(). Returns NULL if the key is too long to be cached */
+PrefixCacheEntry *PrefixCache_Add(PrefixCache *pc, const char *key, size_t len, size_t limit);
+
+void PrefixCacheEntry_AddTerm(PrefixCacheEntry *e, const char *str, size_t len);
+
+/* Remove every entry whose key is a prefix of `s`, i.e. all the expansions `s` belongs to. Only
+ * prefixes whose length is a multiple of `unit` are checked */
+void PrefixCache_InvalidatePrefixesOf(PrefixCache *pc, const char *s, size_t len, size_t unit);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
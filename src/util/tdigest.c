@@ -0,0 +1,225 @@
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+#include "tdigest.h"
+#include "rmalloc.h"
+
+#define TD_MIN_COMPRESSION 10
+#define TD_MAX_COMPRESSION 10000
+#define TD_INITIAL_CAP 16
+
+typedef struct {
+  double mean;
+  double weight;
+} Centroid;
+
+struct TDigest {
+  double compression;
+
+  // The merged centroids, sorted by mean, followed by the values not merged yet
+  Centroid *nodes;
+  size_t numMerged;
+  size_t numUnmerged;
+  size_t cap;
+  // Once there are this many nodes, the unmerged ones are merged
+  size_t maxNodes;
+
+  double totalWeight;
+  double min;
+  double max;
+};
+
+/* Serialization header, followed by the centroids */
+typedef struct {
+  double compression;
+  double min;
+  double max;
+  uint64_t numCentroids;
+} TDHeader;
+
+TDigest *NewTDigest(double compression) {
+  if (compression < TD_MIN_COMPRESSION) {
+    compression = TD_MIN_COMPRESSION;
+  } else if (compression > TD_MAX_COMPRESSION) {
+    compression = TD_MAX_COMPRESSION;
+  }
+  TDigest *td = rm_calloc(1, sizeof(*td));
+  td->compression = compression;
+  // The scale function bounds the merged centroids to about `compression`. The
+  // rest of the space is the insertion buffer
+  td->maxNodes = 3 * (2 * (size_t)ceil(compression) + 10);
+  td->min = INFINITY;
+  td->max = -INFINITY;
+  return td;
+}
+
+void TD_Free(TDigest *td) {
+  rm_free(td->nodes);
+  rm_free(td);
+}
+
+double TD_GetCount(const TDigest *td) {
+  return td->totalWeight;
+}
+
+static int cmpCentroids(const void *a, const void *b) {
+  double x = ((const Centroid *)a)->mean, y = ((const Centroid *)b)->mean;
+  return x < y ? -1 : x > y;
+}
+
+/* The arcsine scale function, k(q) = compression / 2pi * asin(2q - 1), and its inverse */
+static double scaleK(const TDigest *td, double q) {
+  return td->compression / (2 * M_PI) * asin(2 * q - 1);
+}
+
+static double scaleQ(const TDigest *td, double k) {
+  if (k >= td->compression / 4) {
+    return 1;
+  }
+  return (sin(k * 2 * M_PI / td->compression) + 1) / 2;
+}
+
+/**
+ * Merge the unmerged values into the centroids: sort everything by mean, and
+ * merge neighbours as long as the result spans at most one unit of k
+ */
+static void tdCompress(TDigest *td) {
+  if (!td->numUnmerged) {
+    return;
+  }
+  size_t n = td->numMerged + td->numUnmerged;
+  Centroid *c = td->nodes;
+  qsort(c, n, sizeof(*c), cmpCentroids);
+
+  double total = td->totalWeight;
+  double weightSoFar = 0;
+  double limit = total * scaleQ(td, scaleK(td, 0) + 1);
+  size_t out = 0;
+  for (size_t ii = 1; ii < n; ++ii) {
+    Centroid *cur = c + out;
+    if (weightSoFar + cur->weight + c[ii].weight <= limit) {
+      cur->weight += c[ii].weight;
+      cur->mean += (c[ii].mean - cur->mean) * c[ii].weight / cur->weight;
+    } else {
+      weightSoFar += cur->weight;
+      limit = total * scaleQ(td, scaleK(td, weightSoFar / total) + 1);
+      c[++out] = c[ii];
+    }
+  }
+  td->numMerged = out + 1;
+  td->numUnmerged = 0;
+}
+
+void TD_InsertWeighted(TDigest *td, double val, double weight) {
+  if (isnan(val) || !(weight > 0)) {
+    return;
+  }
+  if (td->numMerged + td->numUnmerged == td->maxNodes) {
+    tdCompress(td);
+  }
+  size_t n = td->numMerged + td->numUnmerged;
+  if (n == td->cap) {
+    td->cap = td->cap ? td->cap * 2 : TD_INITIAL_CAP;
+    if (td->cap > td->maxNodes) {
+      td->cap = td->maxNodes;
+    }
+    td->nodes = rm_realloc(td->nodes, td->cap * sizeof(*td->nodes));
+  }
+  td->nodes[n].mean = val;
+  td->nodes[n].weight = weight;
+  td->numUnmerged++;
+  td->totalWeight += weight;
+  if (val < td->min) td->min = val;
+  if (val > td->max) td->max = val;
+}
+
+void TD_Insert(TDigest *td, double val) {
+  TD_InsertWeighted(td, val, 1);
+}
+
+void TD_Merge(TDigest *dst, const TDigest *src) {
+  size_t n = src->numMerged + src->numUnmerged;
+  for (size_t ii = 0; ii < n; ++ii) {
+    TD_InsertWeighted(dst, src->nodes[ii].mean, src->nodes[ii].weight);
+  }
+  // the centroid means are inside the bounds, but are not the bounds themselves
+  if (src->min < dst->min) dst->min = src->min;
+  if (src->max > dst->max) dst->max = src->max;
+}
+
+/**
+ * Each centroid is assumed to hold half of its weight on each side of its mean,
+ * and values are interpolated linearly between neighbouring means. The first
+ * and last half centroids are interpolated with the minimum and maximum.
+ */
+double TD_Quantile(TDigest *td, double q) {
+  tdCompress(td);
+  size_t n = td->numMerged;
+  if (!n) {
+    return 0;
+  }
+  const Centroid *c = td->nodes;
+  if (q <= 0) {
+    return td->min;
+  } else if (q >= 1) {
+    return td->max;
+  } else if (n == 1) {
+    return c[0].mean;
+  }
+
+  double index = q * td->totalWeight;
+  double weightSoFar = c[0].weight / 2;
+  if (index < weightSoFar) {
+    return td->min + (c[0].mean - td->min) * index / weightSoFar;
+  }
+  for (size_t ii = 0; ii < n - 1; ++ii) {
+    double dw = (c[ii].weight + c[ii + 1].weight) / 2;
+    if (weightSoFar + dw > index) {
+      return c[ii].mean + (c[ii + 1].mean - c[ii].mean) * (index - weightSoFar) / dw;
+    }
+    weightSoFar += dw;
+  }
+  double lastHalf = c[n - 1].weight / 2;
+  double frac = lastHalf > 0 ? (index - weightSoFar) / lastHalf : 0;
+  return c[n - 1].mean + (td->max - c[n - 1].mean) * frac;
+}
+
+char *TD_Serialize(TDigest *td, size_t *len) {
+  tdCompress(td);
+  TDHeader hdr = {.compression = td->compression,
+                  .min = td->min,
+                  .max = td->max,
+                  .numCentroids = td->numMerged};
+  *len = sizeof(hdr) + td->numMerged * sizeof(*td->nodes);
+  char *buf = rm_malloc(*len);
+  memcpy(buf, &hdr, sizeof(hdr));
+  if (td->numMerged) {
+    memcpy(buf + sizeof(hdr), td->nodes, td->numMerged * sizeof(*td->nodes));
+  }
+  return buf;
+}
+
+TDigest *TD_Deserialize(const char *buf, size_t len) {
+  TDHeader hdr;
+  if (len < sizeof(hdr)) {
+    return NULL;
+  }
+  memcpy(&hdr, buf, sizeof(hdr));
+  if (hdr.numCentroids > (len - sizeof(hdr)) / sizeof(Centroid) ||
+      len != sizeof(hdr) + hdr.numCentroids * sizeof(Centroid)) {
+    return NULL;
+  }
+
+  TDigest *td = NewTDigest(hdr.compression);
+  const char *p = buf + sizeof(hdr);
+  for (size_t ii = 0; ii < hdr.numCentroids; ++ii, p += sizeof(Centroid)) {
+    Centroid c;
+    memcpy(&c, p, sizeof(c));
+    TD_InsertWeighted(td, c.mean, c.weight);
+  }
+  if (hdr.numCentroids) {
+    td->min = hdr.min;
+    td->max = hdr.max;
+  }
+  return td;
+}
@@ -0,0 +1,46 @@
+#ifndef TDIGEST_H
+#define TDIGEST_H
+
+#include <stdlib.h>
+
+/**
+ * A merging t-digest (Dunning & Ertl) for estimating quantiles of a stream of
+ * values. Values are collected into clusters (centroids) whose size is bounded
+ * by the arcsine scale function, so the clusters near the tails are small and
+ * the extreme quantiles stay accurate.
+ *
+ * Unlike QuantStream, two digests can be merged into a digest of the union of
+ * their values, and a digest can be serialized. This allows computing partial
+ * digests separately (e.g. on each shard) and merging them later.
+ */
+typedef struct TDigest TDigest;
+
+/**
+ * Create a new digest. The compression bounds the number of centroids to about
+ * `compression`; higher values are more accurate and use more memory.
+ */
+TDigest *NewTDigest(double compression);
+void TD_Free(TDigest *td);
+
+void TD_Insert(TDigest *td, double val);
+void TD_InsertWeighted(TDigest *td, double val, double weight);
+
+/* Add the values of `src` to `dst` */
+void TD_Merge(TDigest *dst, const TDigest *src);
+
+/* Estimate the value at quantile `q`, in [0, 1]. Returns 0 for an empty digest */
+double TD_Quantile(TDigest *td, double q);
+
+/* Total weight (the number of values, if all weights are 1) */
+double TD_GetCount(const TDigest *td);
+
+/**
+ * Serialize the digest into a newly allocated buffer (freed with rm_free), and
+ * set its length in `len`. The format uses the native byte order.
+ */
+char *TD_Serialize(TDigest *td, size_t *len);
+
+/* Load a digest serialized with TD_Serialize(). Returns NULL if the buffer is malformed */
+TDigest *TD_Deserialize(const char *buf, size_t len);
+
+#endif
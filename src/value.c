@@ -560,6 +560,49 @@ int RSValue_Cmp(const RSValue *v1, const RSValue *v2, QueryError *qerr) {
   return cmp_strings(s1, s2, l1, l2);
 }
 
+RSSortPrefixKind RSValue_SortPrefix(const RSValue *v, uint64_t *prefix) {
+  if (!v) {
+    return RSSortPrefix_None;
+  }
+  v = RSValue_Dereference(v);
+  switch (v->t) {
+    case RSValue_Number: {
+      double d = v->numval;
+      if (isnan(d)) {
+        return RSSortPrefix_None;
+      }
+      if (d == 0) {
+        d = 0;  // -0 and 0 are equal
+      }
+      uint64_t u;
+      memcpy(&u, &d, sizeof(u));
+      // flip negatives entirely so they order in reverse, and set the sign bit of positives
+      *prefix = (u & (1ULL << 63)) ? ~u : u | (1ULL << 63);
+      return RSSortPrefix_Number;
+    }
+    case RSValue_String:
+    case RSValue_RedisString:
+    case RSValue_OwnRstring: {
+      size_t len;
+      const char *str = RSValue_StringPtrLen(v, &len);
+      // big endian, padded with zeros - as strncmp() compares unsigned bytes up to a NUL
+      uint64_t u = 0;
+      for (size_t ii = 0; ii < sizeof(u); ++ii) {
+        u <<= 8;
+        if (ii < len && str[ii]) {
+          u |= (unsigned char)str[ii];
+        } else {
+          len = 0;
+        }
+      }
+      *prefix = u;
+      return RSSortPrefix_String;
+    }
+    default:
+      return RSSortPrefix_None;
+  }
+}
+
 int RSValue_Equal(const RSValue *v1, const RSValue *v2, QueryError *qerr) {
   RS_LOG_ASSERT(v1 && v2, "missing RSvalue");
 
@@ -329,6 +329,21 @@ RSValue *RS_StringArrayT(char **strs, uint32_t sz, RSStringType st);
 /* Compare 2 values for sorting */
 int RSValue_Cmp(const RSValue *v1, const RSValue *v2, QueryError *status);
 
+/* Kinds of sort prefixes. Prefixes are only comparable when they have the same kind */
+typedef enum {
+  RSSortPrefix_None = 0,
+  RSSortPrefix_Number,
+  RSSortPrefix_String,
+} RSSortPrefixKind;
+
+/**
+ * Compute a byte-comparable prefix of a value: two values of the same kind whose prefixes differ
+ * compare by RSValue_Cmp() like their prefixes compare as integers. Values with equal prefixes
+ * must still be compared with RSValue_Cmp(). Strings use their first 8 bytes, and numbers an
+ * order preserving encoding of the double. Returns RSSortPrefix_None if the value has no prefix.
+ */
+RSSortPrefixKind RSValue_SortPrefix(const RSValue *v, uint64_t *prefix);
+
 /* Return 1 if the two values are equal */
 int RSValue_Equal(const RSValue *v1, const RSValue *v2, QueryError *status);
 
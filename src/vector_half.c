@@ -0,0 +1,83 @@
+#include "vector_half.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define VECTOR_HALF_F16C
+#endif
+
+static inline uint16_t loadHalf(const uint8_t *p) {
+  uint16_t h;
+  memcpy(&h, p, sizeof(h));
+  return h;
+}
+
+static inline float bitsToFloat(uint32_t bits) {
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+static float float16ToFloat32(uint16_t h) {
+  uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+  uint32_t exp = (h >> 10) & 0x1f, mant = h & 0x3ff;
+  if (exp == 0x1f) {
+    // infinity or NaN
+    return bitsToFloat(sign | 0x7f800000 | (mant << 13));
+  } else if (exp) {
+    // rebias the exponent from 15 to 127
+    return bitsToFloat(sign | ((exp + 112) << 23) | (mant << 13));
+  }
+  // zero or subnormal: mant * 2^-24
+  float f = mant * (1.0f / (1 << 24));
+  return sign ? -f : f;
+}
+
+static void float16ToFloat32Scalar(const uint8_t *src, float *dst, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    dst[i] = float16ToFloat32(loadHalf(src + 2 * i));
+  }
+}
+
+#ifdef VECTOR_HALF_F16C
+__attribute__((target("avx,f16c"))) static void float16ToFloat32F16C(const uint8_t *src,
+                                                                      float *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm_loadu_si128((const __m128i *)(src + 2 * i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+  }
+  float16ToFloat32Scalar(src + 2 * i, dst + i, n - i);
+}
+
+static int hasF16C(void) {
+  static int supported = -1;
+  if (supported == -1) {
+    unsigned a, b, c, d;
+    // F16C is ecx bit 29 of leaf 1. It uses the AVX registers, which the OS must enable
+    supported = __get_cpuid(1, &a, &b, &c, &d) && (c & (1 << 29)) && __builtin_cpu_supports("avx");
+  }
+  return supported;
+}
+#endif
+
+void VectorHalf_ToFloat32(VectorHalfType type, const void *src, float *dst, size_t n) {
+  const uint8_t *p = src;
+  if (type == VectorHalf_BFloat16) {
+    // a plain loop the compiler vectorizes
+    for (size_t i = 0; i < n; i++) {
+      dst[i] = bitsToFloat((uint32_t)loadHalf(p + 2 * i) << 16);
+    }
+    return;
+  }
+#ifdef VECTOR_HALF_F16C
+  if (hasF16C()) {
+    float16ToFloat32F16C(p, dst, n);
+    return;
+  }
+#endif
+  float16ToFloat32Scalar(p, dst, n);
+}
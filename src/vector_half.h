@@ -0,0 +1,14 @@
+#pragma once
+
+#include "field_spec.h"
+
+#include <stddef.h>
+
+/**
+ * Half precision vector elements: IEEE FLOAT16, and BFLOAT16 (the upper half of a FLOAT32).
+ * The vector index has no half precision types, so vectors of these fields are converted to
+ * FLOAT32 when they are indexed and queried. Documents and queries still hold 2 bytes per element.
+ */
+
+/* Convert `n` elements of `src`, which need not be aligned, to FLOAT32 */
+void VectorHalf_ToFloat32(VectorHalfType type, const void *src, float *dst, size_t n);
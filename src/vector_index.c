@@ -1,7 +1,15 @@
 #include "vector_index.h"
+#include "index.h"
 #include "list_reader.h"
 #include "base64/base64.h"
 #include "query_param.h"
+#include "util/minmax.h"
+#include "util/arr.h"
+#include "config.h"
+#include "thpool/thpool.h"
+
+#include <pthread.h>
+#include <math.h>
 
 // taken from parser.c
 void unescape(char *s, size_t *sz) {
@@ -21,8 +29,221 @@ void unescape(char *s, size_t *sz) {
   }
 }
 
-static VecSimIndex *openVectorKeysDict(RedisSearchCtx *ctx, RedisModuleString *keyName,
-                                             int write) {
+/* The element type, dimension and metric of vector index parameters */
+static void vecSimParamsGet(const VecSimParams *params, VecSimType *type, size_t *dim,
+                            VecSimMetric *metric) {
+  if (params->algo == VecSimAlgo_BF) {
+    *type = params->bfParams.type;
+    *dim = params->bfParams.dim;
+    *metric = params->bfParams.metric;
+  } else {
+    *type = params->hnswParams.type;
+    *dim = params->hnswParams.dim;
+    *metric = params->hnswParams.metric;
+  }
+}
+
+/* The element type, dimension and metric of a vector field */
+static void vectorFieldParams(const FieldSpec *fs, VecSimType *type, size_t *dim,
+                              VecSimMetric *metric) {
+  vecSimParamsGet(&fs->vecSimParams, type, dim, metric);
+}
+
+typedef struct {
+  t_docId docId;
+  void *blob;  // NULL if the document was deleted before the vector was inserted
+  size_t len;
+} PendingVector;
+
+struct VectorIndex {
+  VecSimIndex *index;
+  VecSimType type;
+  size_t dim;
+  VecSimMetric metric;
+  // Whether insertions are queued for the worker pool
+  bool async;
+
+  // Guards the index, once insertions are queued. Queries hold it for reading, while the worker
+  // inserts a batch and deletions hold it for writing
+  pthread_rwlock_t indexLock;
+  // Guards the queue. Taken after indexLock
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  arrayof(PendingVector) pending;
+  size_t next;  // The next pending vector to insert
+  bool scheduled;  // A worker job is queued or running
+  bool closing;
+};
+
+/* What a query searches: the index, and a copy of the vectors still queued for it, sorted by id.
+ * Their blobs are not copied, and stay valid while the index is acquired */
+typedef struct {
+  VecSimIndex *index;
+  VecSimType type;
+  size_t dim;
+  VecSimMetric metric;
+  PendingVector *pending;
+  size_t numPending;
+} VectorSearch;
+
+// The worker takes this many vectors off the queue at a time, and inserts them with the queue
+// unlocked
+#define VECSIM_INSERT_BATCH 16
+
+static threadpool vecsimPool_g = NULL;
+
+static VectorIndex *newVectorIndex(VecSimParams *params) {
+  VectorIndex *vi = rm_calloc(1, sizeof(*vi));
+  vi->index = VecSimIndex_New(params);
+  vecSimParamsGet(params, &vi->type, &vi->dim, &vi->metric);
+  // Flat indexes only copy the vector, which is not worth queuing
+  vi->async = RSGlobalConfig.vecsimThreads > 0 && params->algo == VecSimAlgo_HNSWLIB;
+  if (vi->async) {
+    pthread_rwlock_init(&vi->indexLock, NULL);
+    pthread_mutex_init(&vi->lock, NULL);
+    pthread_cond_init(&vi->cond, NULL);
+    vi->pending = array_new(PendingVector, 16);
+  }
+  return vi;
+}
+
+/* Take up to VECSIM_INSERT_BATCH vectors off the queue, with the queue locked. Returns how many */
+static size_t vectorIndexTakeBatch(VectorIndex *vi, PendingVector *batch) {
+  if (vi->closing) {
+    return 0;
+  }
+  size_t n = MIN(array_len(vi->pending) - vi->next, VECSIM_INSERT_BATCH);
+  memcpy(batch, vi->pending + vi->next, n * sizeof(*batch));
+  vi->next += n;
+  if (vi->next == array_len(vi->pending)) {
+    array_clear(vi->pending);
+    vi->next = 0;
+  }
+  return n;
+}
+
+static void vectorIndexWorker(void *p) {
+  VectorIndex *vi = p;
+  PendingVector batch[VECSIM_INSERT_BATCH];
+  while (1) {
+    pthread_rwlock_wrlock(&vi->indexLock);
+    pthread_mutex_lock(&vi->lock);
+    size_t n = vectorIndexTakeBatch(vi, batch);
+    if (!n) {
+      vi->scheduled = false;
+      pthread_cond_broadcast(&vi->cond);
+      pthread_mutex_unlock(&vi->lock);
+      pthread_rwlock_unlock(&vi->indexLock);
+      return;
+    }
+    // documents are added to the queue while the batch is inserted
+    pthread_mutex_unlock(&vi->lock);
+    for (size_t ii = 0; ii < n; ++ii) {
+      if (batch[ii].blob) {
+        VecSimIndex_AddVector(vi->index, batch[ii].blob, batch[ii].docId);
+        rm_free(batch[ii].blob);
+      }
+    }
+    pthread_rwlock_unlock(&vi->indexLock);
+  }
+}
+
+static void vectorIndexFree(VectorIndex *vi) {
+  if (vi->async) {
+    // the worker may still hold the index
+    pthread_mutex_lock(&vi->lock);
+    vi->closing = true;
+    while (vi->scheduled) {
+      pthread_cond_wait(&vi->cond, &vi->lock);
+    }
+    pthread_mutex_unlock(&vi->lock);
+    for (size_t ii = vi->next; ii < array_len(vi->pending); ++ii) {
+      rm_free(vi->pending[ii].blob);
+    }
+    array_free(vi->pending);
+    pthread_cond_destroy(&vi->cond);
+    pthread_mutex_destroy(&vi->lock);
+    pthread_rwlock_destroy(&vi->indexLock);
+  }
+  VecSimIndex_Free(vi->index);
+  rm_free(vi);
+}
+
+void VectorIndex_AddVector(VectorIndex *vi, const void *blob, size_t len, t_docId docId) {
+  if (!vi->async) {
+    VecSimIndex_AddVector(vi->index, blob, docId);
+    return;
+  }
+  PendingVector pv = {.docId = docId, .blob = rm_malloc(len), .len = len};
+  memcpy(pv.blob, blob, len);
+  pthread_mutex_lock(&vi->lock);
+  vi->pending = array_append(vi->pending, pv);
+  if (!vi->scheduled) {
+    vi->scheduled = true;
+    if (!vecsimPool_g) {
+      vecsimPool_g = thpool_init(RSGlobalConfig.vecsimThreads);
+    }
+    thpool_add_work(vecsimPool_g, vectorIndexWorker, vi);
+  }
+  pthread_mutex_unlock(&vi->lock);
+}
+
+void VectorIndex_DeleteVector(VectorIndex *vi, t_docId docId) {
+  if (!vi->async) {
+    VecSimIndex_DeleteVector(vi->index, docId);
+    return;
+  }
+  pthread_rwlock_wrlock(&vi->indexLock);
+  pthread_mutex_lock(&vi->lock);
+  for (size_t ii = vi->next; ii < array_len(vi->pending); ++ii) {
+    if (vi->pending[ii].docId == docId) {
+      rm_free(vi->pending[ii].blob);
+      vi->pending[ii].blob = NULL;
+    }
+  }
+  pthread_mutex_unlock(&vi->lock);
+  VecSimIndex_DeleteVector(vi->index, docId);
+  pthread_rwlock_unlock(&vi->indexLock);
+}
+
+static int cmpPendingByDocId(const void *p1, const void *p2) {
+  const PendingVector *a = p1, *b = p2;
+  return a->docId < b->docId ? -1 : a->docId > b->docId;
+}
+
+/* Lock the index for a query, which searches the index as it stands and compares the query vector
+ * with the vectors still queued for it */
+static void vectorIndexAcquire(VectorIndex *vi, VectorSearch *vs) {
+  *vs = (VectorSearch){.index = vi->index, .type = vi->type, .dim = vi->dim,
+                       .metric = vi->metric};
+  if (!vi->async) {
+    return;
+  }
+  pthread_rwlock_rdlock(&vi->indexLock);
+  pthread_mutex_lock(&vi->lock);
+  size_t n = array_len(vi->pending) - vi->next;
+  if (n) {
+    vs->pending = rm_malloc(n * sizeof(*vs->pending));
+    for (size_t ii = vi->next; ii < array_len(vi->pending); ++ii) {
+      if (vi->pending[ii].blob) {
+        vs->pending[vs->numPending++] = vi->pending[ii];
+      }
+    }
+  }
+  pthread_mutex_unlock(&vi->lock);
+  if (vs->numPending) {
+    qsort(vs->pending, vs->numPending, sizeof(*vs->pending), cmpPendingByDocId);
+  }
+}
+
+static void vectorIndexRelease(VectorIndex *vi, VectorSearch *vs) {
+  if (vi->async) {
+    rm_free(vs->pending);
+    pthread_rwlock_unlock(&vi->indexLock);
+  }
+}
+
+static void *openVectorKeysDict(RedisSearchCtx *ctx, RedisModuleString *keyName, int write) {
   IndexSpec *spec = ctx->spec;
   KeysDictValue *kdv = dictFetchValue(spec->keysDict, keyName);
   if (kdv) {
@@ -46,49 +267,547 @@ static VecSimIndex *openVectorKeysDict(RedisSearchCtx *ctx, RedisModuleString *k
 
   // create new vector data structure
   kdv = rm_calloc(1, sizeof(*kdv));
-  kdv->p = VecSimIndex_New(&fieldSpec->vecSimParams);
+  if (fieldSpec->vecQuant != VectorQuant_None) {
+    VecSimType type;
+    size_t dim;
+    VecSimMetric metric;
+    vectorFieldParams(fieldSpec, &type, &dim, &metric);
+    kdv->p = NewQuantizedVectors(type, dim, metric);
+    kdv->dtor = (void (*)(void *))QuantizedVectors_Free;
+  } else {
+    kdv->p = newVectorIndex(&fieldSpec->vecSimParams);
+    kdv->dtor = (void (*)(void *))vectorIndexFree;
+  }
   dictAdd(ctx->spec->keysDict, keyName, kdv);
-  kdv->dtor = (void (*)(void *))VecSimIndex_Free;
   return kdv->p;
 }
 
-VecSimIndex *OpenVectorIndex(RedisSearchCtx *ctx,
+VectorIndex *OpenVectorIndex(RedisSearchCtx *ctx,
                             RedisModuleString *keyName) {
   return openVectorKeysDict(ctx, keyName, 1);
 }
 
-IndexIterator *NewVectorIterator(RedisSearchCtx *ctx, VectorFilter *vf) {
+QuantizedVectors *OpenQuantizedVectors(RedisSearchCtx *ctx, RedisModuleString *keyName) {
+  return openVectorKeysDict(ctx, keyName, 1);
+}
+
+size_t IndexSpec_QuantizedVectorsMemUsage(IndexSpec *sp) {
+  size_t total = 0;
+  for (int i = 0; i < sp->numFields; ++i) {
+    const FieldSpec *fs = sp->fields + i;
+    if (!FIELD_IS(fs, INDEXFLD_T_VECTOR) || fs->vecQuant == VectorQuant_None) {
+      continue;
+    }
+    RedisModuleString *keyName = IndexSpec_GetFormattedKey(sp, fs, INDEXFLD_T_VECTOR);
+    KeysDictValue *kdv = dictFetchValue(sp->keysDict, keyName);
+    if (kdv) {
+      total += QuantizedVectors_MemUsage(kdv->p);
+    }
+  }
+  return total;
+}
+
+const void *VectorField_IndexedVectors(const FieldSpec *fs, const void *blob, size_t *len) {
+  if (fs->vecHalf == VectorHalf_None) {
+    return blob;
+  }
+  VecSimType type;
+  size_t dim;
+  VecSimMetric metric;
+  vectorFieldParams(fs, &type, &dim, &metric);
+  size_t halfLen = dim * sizeof(uint16_t);
+  if (!halfLen || !*len || *len % halfLen) {
+    return NULL;
+  }
+  size_t n = *len / sizeof(uint16_t);
+  float *vectors = rm_malloc(n * sizeof(*vectors));
+  VectorHalf_ToFloat32(fs->vecHalf, blob, vectors, n);
+  *len = n * sizeof(*vectors);
+  return vectors;
+}
+
+// Filters estimated to pass at most this fraction of the indexed vectors are searched by
+// computing the distance of every document which passes them, instead of querying the index
+#define VECSIM_ADHOC_MAX_SELECTIVITY 0.05
+
+// The vector index has no range query, so range queries ask it for growing numbers of the
+// closest vectors, starting with this many
+#define VECSIM_RANGE_INITIAL_BATCH 1024
+
+// Reranked queries of quantized vectors recompute the distances of this many times K vectors
+#define VECSIM_RERANK_FACTOR 4
+
+static int cmpScoredByScore(const void *p1, const void *p2) {
+  const ScoredDocId *a = p1, *b = p2;
+  if (a->score != b->score) {
+    return a->score < b->score ? -1 : 1;
+  }
+  return a->docId < b->docId ? -1 : a->docId > b->docId;
+}
+
+static int cmpScoredByDocId(const void *p1, const void *p2) {
+  const ScoredDocId *a = p1, *b = p2;
+  return a->docId < b->docId ? -1 : a->docId > b->docId;
+}
+
+/* Keep the `k` closest results, sorted by document id */
+static size_t scoredTopK(ScoredDocId *results, size_t len, size_t k) {
+  if (len > k) {
+    qsort(results, len, sizeof(*results), cmpScoredByScore);
+    len = k;
+  }
+  qsort(results, len, sizeof(*results), cmpScoredByDocId);
+  return len;
+}
+
+static inline double vectorElement(VecSimType type, const char *blob, size_t i) {
+  // the blobs are not necessarily aligned
+  if (type == VecSimType_FLOAT32) {
+    float f;
+    memcpy(&f, blob + i * sizeof(f), sizeof(f));
+    return f;
+  }
+  double d;
+  memcpy(&d, blob + i * sizeof(d), sizeof(d));
+  return d;
+}
+
+/* The distance between two vectors, as the vector index computes it */
+static double vectorDistance(VecSimType type, VecSimMetric metric, const char *a, const char *b,
+                             size_t dim) {
+  double sum = 0, na = 0, nb = 0;
+  for (size_t i = 0; i < dim; i++) {
+    double x = vectorElement(type, a, i), y = vectorElement(type, b, i);
+    if (metric == VecSimMetric_L2) {
+      sum += (x - y) * (x - y);
+    } else {
+      sum += x * y;
+      na += x * x;
+      nb += y * y;
+    }
+  }
+  if (metric == VecSimMetric_L2) {
+    return sum;
+  } else if (metric == VecSimMetric_Cosine) {
+    sum = na && nb ? sum / sqrt(na * nb) : 0;
+  }
+  return 1 - sum;
+}
+
+/* The length of a vector of the field, or 0 if its elements can't be read */
+static size_t vectorLength(const FieldSpec *fs) {
+  VecSimType type;
+  size_t dim;
+  VecSimMetric metric;
+  vectorFieldParams(fs, &type, &dim, &metric);
+  size_t elemSize = type == VecSimType_FLOAT32 ? sizeof(float)
+                    : type == VecSimType_FLOAT64 ? sizeof(double) : 0;
+  return dim * elemSize;
+}
+
+/* Whether the vectors of the field can be read from the documents, to compare with the query */
+static bool canReadVectors(RedisSearchCtx *ctx, const FieldSpec *fs, size_t vecLen) {
+  return isSpecHash(ctx->spec) && vecLen && vecLen == vectorLength(fs);
+}
+
+/**
+ * Compute the distances of every document which passes the filter from each of `numVectors`
+ * query vectors, reading its vector from the document once, and keep the `k` closest within
+ * `radius` for each query vector. Returns false if the vectors can't be read this way.
+ */
+static bool vectorQueryAdHocEach(RedisSearchCtx *ctx, const FieldSpec *fs, const char *vectors,
+                                 size_t vecLen, size_t numVectors, size_t k, double radius,
+                                 IndexIterator *filter, ScoredDocId **results, size_t *lens) {
+  if (!canReadVectors(ctx, fs, vecLen)) {
+    return false;
+  }
+  VecSimType type;
+  size_t dim;
+  VecSimMetric metric;
+  vectorFieldParams(fs, &type, &dim, &metric);
+
+  const DocTable *dt = &ctx->spec->docs;
+  size_t *caps = rm_malloc(numVectors * sizeof(*caps));
+  for (size_t q = 0; q < numVectors; q++) {
+    caps[q] = 16;
+    lens[q] = 0;
+    results[q] = rm_malloc(caps[q] * sizeof(*results[q]));
+  }
+  RSIndexResult *hit;
+  int rc;
+  while ((rc = filter->Read(filter->ctx, &hit)) != INDEXREAD_EOF) {
+    if (rc != INDEXREAD_OK || !DocTable_IsLive(dt, hit->docId)) {
+      continue;
+    }
+    const RSDocumentMetadata *dmd = DocTable_Get(dt, hit->docId);
+    if (!dmd) {
+      continue;
+    }
+    RedisModuleString *keyName =
+        RedisModule_CreateString(ctx->redisCtx, dmd->keyPtr, sdslen(dmd->keyPtr));
+    RedisModuleKey *key = RedisModule_OpenKey(ctx->redisCtx, keyName, REDISMODULE_READ);
+    RedisModule_FreeString(ctx->redisCtx, keyName);
+    RedisModuleString *val = NULL;
+    if (key && RedisModule_KeyType(key) == REDISMODULE_KEYTYPE_HASH) {
+      RedisModule_HashGet(key, REDISMODULE_HASH_CFIELDS, fs->path, &val, NULL);
+    }
+    if (key) {
+      RedisModule_CloseKey(key);
+    }
+    if (!val) {
+      continue;
+    }
+    size_t blobLen;
+    const char *blob = RedisModule_StringPtrLen(val, &blobLen);
+    const char *docVector = VectorField_IndexedVectors(fs, blob, &blobLen);
+    if (!docVector) {
+      blobLen = 0;
+    }
+    for (size_t q = 0; q < numVectors; q++) {
+      const char *vector = vectors + q * vecLen;
+      double dist =
+          blobLen == vecLen ? vectorDistance(type, metric, vector, docVector, dim) : INFINITY;
+      if (dist <= radius) {
+        if (lens[q] == caps[q]) {
+          caps[q] *= 2;
+          results[q] = rm_realloc(results[q], caps[q] * sizeof(*results[q]));
+        }
+        results[q][lens[q]++] = (ScoredDocId){.docId = hit->docId, .score = dist};
+      }
+    }
+    if (docVector != blob) {
+      rm_free((void *)docVector);
+    }
+    RedisModule_FreeString(ctx->redisCtx, val);
+  }
+  for (size_t q = 0; q < numVectors; q++) {
+    lens[q] = scoredTopK(results[q], lens[q], k);
+  }
+  rm_free(caps);
+  return true;
+}
+
+/* Query the vectors read from the documents for a single query vector. Returns NULL if they can't
+ * be read */
+static ScoredDocId *vectorQueryAdHoc(RedisSearchCtx *ctx, const FieldSpec *fs, const void *vector,
+                                     size_t vecLen, size_t k, double radius,
+                                     IndexIterator *filter, size_t *len) {
+  ScoredDocId *results = NULL;
+  if (!vectorQueryAdHocEach(ctx, fs, vector, vecLen, 1, k, radius, filter, &results, len)) {
+    return NULL;
+  }
+  return results;
+}
+
+/* Append the queued vectors which pass the filter and are within `radius` to the `n` results.
+ * The filter is optional */
+static ScoredDocId *vectorQueryPending(const VectorSearch *vs, const void *vector, double radius,
+                                       IndexIterator *filter, ScoredDocId *results, size_t *n) {
+  results = rm_realloc(results, MAX(*n + vs->numPending, 1) * sizeof(*results));
+  size_t vecLen = vs->dim * (vs->type == VecSimType_FLOAT32 ? sizeof(float) : sizeof(double));
+  if (filter) {
+    filter->Rewind(filter->ctx);
+  }
+  t_docId filterNext = 0;
+  for (size_t ii = 0; ii < vs->numPending; ii++) {
+    const PendingVector *pv = vs->pending + ii;
+    if (pv->len != vecLen) {
+      continue;
+    }
+    double score = vectorDistance(vs->type, vs->metric, vector, pv->blob, vs->dim);
+    if (score > radius) {
+      continue;
+    }
+    if (!filter || IndexIterator_HasDocId(filter, pv->docId, &filterNext) == INDEXREAD_OK) {
+      results[(*n)++] = (ScoredDocId){.docId = pv->docId, .score = score};
+    }
+  }
+  return results;
+}
+
+/**
+ * Query the vector index for growing numbers of the closest vectors, starting with `batch`, until
+ * `k` of them pass the filter, one is farther than `radius`, or the whole index was searched.
+ * The vectors still queued for the index are compared with the query vector directly. The filter
+ * is optional.
+ */
+static ScoredDocId *vectorQueryBatches(const VectorSearch *vs, const void *vector,
+                                       VecSimQueryParams *qParams, size_t k, double radius,
+                                       size_t batch, IndexIterator *filter, size_t *len) {
+  VecSimIndex *vecsim = vs->index;
+  size_t indexSize = VecSimIndex_IndexSize(vecsim);
+  batch = MIN(batch, indexSize);
+  ScoredDocId *results = NULL;
+  size_t n;
+  while (1) {
+    VecSimQueryResult_List list = VecSimIndex_TopKQuery(vecsim, vector, batch, qParams, BY_ID);
+    results = rm_realloc(results, MAX(VecSimQueryResult_Len(list), 1) * sizeof(*results));
+    n = 0;
+    double farthest = 0;
+    if (filter) {
+      filter->Rewind(filter->ctx);
+    }
+    t_docId filterNext = 0;
+    VecSimQueryResult_Iterator *iter = VecSimQueryResult_List_GetIterator(list);
+    while (VecSimQueryResult_IteratorHasNext(iter)) {
+      VecSimQueryResult *res = VecSimQueryResult_IteratorNext(iter);
+      t_docId id = VecSimQueryResult_GetId(res);
+      double score = VecSimQueryResult_GetScore(res);
+      farthest = MAX(farthest, score);
+      if (score > radius) {
+        continue;
+      }
+      if (!filter || IndexIterator_HasDocId(filter, id, &filterNext) == INDEXREAD_OK) {
+        results[n++] = (ScoredDocId){.docId = id, .score = score};
+      }
+    }
+    VecSimQueryResult_IteratorFree(iter);
+    VecSimQueryResult_Free(list);
+    if (n >= k || farthest > radius || batch >= indexSize) {
+      break;
+    }
+    batch = MIN(batch * 2, indexSize);
+  }
+  if (vs->numPending) {
+    results = vectorQueryPending(vs, vector, radius, filter, results, &n);
+  }
+  *len = scoredTopK(results, n, k);
+  return results;
+}
+
+/**
+ * Query the quantized vectors of a field. With `rerank`, the distances of the closest vectors are
+ * recomputed from the full precision vectors of the documents, when they can be read, and the
+ * `k` closest within `radius` are kept.
+ */
+static ScoredDocId *vectorQueryQuantized(RedisSearchCtx *ctx, const FieldSpec *fs,
+                                         QuantizedVectors *qv, const void *vector, size_t vecLen,
+                                         size_t k, double radius, bool rerank,
+                                         IndexIterator *filter, size_t *len) {
+  rerank = rerank && canReadVectors(ctx, fs, vecLen);
+  size_t candidates = k;
+  if (rerank && k <= SIZE_MAX / VECSIM_RERANK_FACTOR) {
+    candidates = k * VECSIM_RERANK_FACTOR;
+  }
+  size_t n = 0;
+  ScoredDocId *results =
+      QuantizedVectors_Query(qv, vector, vecLen, candidates, radius, filter, &n);
+  if (!results || !rerank) {
+    *len = results ? scoredTopK(results, n, k) : 0;
+    return results;
+  }
+  qsort(results, n, sizeof(*results), cmpScoredByDocId);
+  IndexIterator *it = NewScoredListIterator(results, n);
+  results = vectorQueryAdHoc(ctx, fs, vector, vecLen, k, radius, it, len);
+  it->Free(it);
+  return results;
+}
+
+/* The fraction of the indexed and queued vectors which the filter is estimated to pass */
+static double filterSelectivity(const VectorSearch *vs, IndexIterator *filter) {
+  size_t indexSize = VecSimIndex_IndexSize(vs->index) + vs->numPending;
+  size_t estimate = filter ? filter->NumEstimated(filter->ctx) : indexSize;
+  return indexSize ? MIN((double)estimate / indexSize, 1) : 1;
+}
+
+/* The union of the results of each query vector of a batch, sorted by id. A document in the
+ * results of several query vectors keeps the closest of them, so the others are left with fewer
+ * than K results. Takes ownership of the results */
+static ScoredDocId *mergeBatchResults(ScoredDocId **results, size_t *lens, size_t numVectors,
+                                      size_t *len) {
+  size_t total = 0;
+  for (size_t q = 0; q < numVectors; q++) {
+    total += lens[q];
+  }
+  ScoredDocId *merged = rm_malloc(MAX(total, 1) * sizeof(*merged));
+  size_t n = 0;
+  for (size_t q = 0; q < numVectors; q++) {
+    for (size_t ii = 0; ii < lens[q]; ii++) {
+      merged[n] = results[q][ii];
+      merged[n++].query = q;
+    }
+    rm_free(results[q]);
+  }
+  qsort(merged, n, sizeof(*merged), cmpScoredByDocId);
+  size_t out = 0;
+  for (size_t ii = 0; ii < n; ii++) {
+    if (out && merged[out - 1].docId == merged[ii].docId) {
+      const ScoredDocId *prev = merged + out - 1, *cur = merged + ii;
+      if (cur->score < prev->score || (cur->score == prev->score && cur->query < prev->query)) {
+        merged[out - 1] = *cur;
+      }
+    } else {
+      merged[out++] = merged[ii];
+    }
+  }
+  *len = out;
+  return merged;
+}
+
+/**
+ * Query a batch of query vectors, one after the other in `vectors`. The filter is read once, and
+ * the vectors of the documents are read once for all the query vectors when they are searched by
+ * computing their distances. Returns NULL if the batch isn't made of vectors of the field. The
+ * filter is consumed by the call.
+ */
+static ScoredDocId *vectorQueryEach(RedisSearchCtx *ctx, const FieldSpec *fs, void *vecIdx,
+                                    const VectorSearch *vs, const VectorFilter *vf,
+                                    const char *vectors, size_t vecLen, IndexIterator *filter,
+                                    size_t *len) {
+  *len = 0;
+  size_t queryLen = vectorLength(fs);
+  if (!queryLen || !vecLen || vecLen % queryLen) {
+    if (filter) filter->Free(filter);
+    return NULL;
+  }
+  size_t numVectors = vecLen / queryLen;
+
+  // Read the filter once, into a list which each query vector rewinds
+  if (filter) {
+    size_t cap = 16, n = 0;
+    ScoredDocId *ids = rm_malloc(cap * sizeof(*ids));
+    RSIndexResult *hit;
+    int rc;
+    while ((rc = filter->Read(filter->ctx, &hit)) != INDEXREAD_EOF) {
+      if (rc != INDEXREAD_OK) {
+        continue;
+      }
+      if (n == cap) {
+        cap *= 2;
+        ids = rm_realloc(ids, cap * sizeof(*ids));
+      }
+      ids[n++] = (ScoredDocId){.docId = hit->docId};
+    }
+    filter->Free(filter);
+    filter = NewScoredListIterator(ids, n);
+  }
+
+  VecSimQueryParams qParams = {.hnswRuntimeParams.efRuntime = vf->efRuntime};
+  size_t k = vf->type == VECTOR_SIM_TOPK ? vf->value : SIZE_MAX;
+  double radius = vf->type == VECTOR_SIM_RANGE ? vf->value : INFINITY;
+  ScoredDocId **results = rm_calloc(numVectors, sizeof(*results));
+  size_t *lens = rm_calloc(numVectors, sizeof(*lens));
+  double selectivity = vs->index ? filterSelectivity(vs, filter) : 1;
+  bool adhoc = vs->index && filter && selectivity <= VECSIM_ADHOC_MAX_SELECTIVITY &&
+               vectorQueryAdHocEach(ctx, fs, vectors, queryLen, numVectors, k, radius, filter,
+                                    results, lens);
+  // quantized fields have no vector index
+  for (size_t q = 0; q < numVectors && !adhoc; q++) {
+    const char *vector = vectors + q * queryLen;
+    if (filter) {
+      filter->Rewind(filter->ctx);
+    }
+    if (!vs->index) {
+      results[q] = vectorQueryQuantized(ctx, fs, vecIdx, vector, queryLen, k, radius, vf->rerank,
+                                        filter, &lens[q]);
+    } else {
+      size_t batch = vf->type == VECTOR_SIM_TOPK ? k : VECSIM_RANGE_INITIAL_BATCH;
+      batch = selectivity > 0 ? batch / selectivity : VecSimIndex_IndexSize(vs->index);
+      results[q] = vectorQueryBatches(vs, vector, &qParams, k, radius, batch, filter, &lens[q]);
+    }
+  }
+  if (filter) filter->Free(filter);
+
+  ScoredDocId *merged = mergeBatchResults(results, lens, numVectors, len);
+  rm_free(results);
+  rm_free(lens);
+  return merged;
+}
+
+IndexIterator *NewVectorIterator(RedisSearchCtx *ctx, VectorFilter *vf, IndexIterator *filter) {
   VecSimQueryResult *result;
   // TODO: change Dict to hold strings
   RedisModuleString *key = RedisModule_CreateStringPrintf(ctx->redisCtx, "%s", vf->property);
-  VecSimIndex *vecsim = openVectorKeysDict(ctx, key, 0);
+  void *vecIdx = openVectorKeysDict(ctx, key, 0);
   RedisModule_FreeString(ctx->redisCtx, key);
-  if (!vecsim) {
+  if (!vecIdx) {
+    if (filter) filter->Free(filter);
     return NULL;
   }
+  const FieldSpec *fs = IndexSpec_GetField(ctx->spec, vf->property, strlen(vf->property));
+  bool quantized = fs && fs->vecQuant != VectorQuant_None;
+  VectorSearch vs = {0};
+  if (!quantized) {
+    vectorIndexAcquire(vecIdx, &vs);
+  }
 
   size_t outLen;
   unsigned char *vector = vf->vector;
+  size_t vecLen = vf->vecLen;
+  const void *query = NULL;
+  ScoredDocId *scored = NULL;
+  size_t scoredLen = 0;
   switch (vf->type) {
     case VECTOR_SIM_TOPK:
+    case VECTOR_SIM_RANGE:
       if (vf->isBase64) {
         unescape((char *)vector, &vf->vecLen);
         vector = base64_decode(vector, vf->vecLen, &outLen);
+        vecLen = outLen;
       }
-      
+      // the vector index holds FLOAT32 vectors of half precision fields
+      query = fs ? VectorField_IndexedVectors(fs, vector, &vecLen) : vector;
+
       VecSimQueryParams qParams = {.hnswRuntimeParams.efRuntime = vf->efRuntime};
-      vf->results = VecSimIndex_TopKQuery(vecsim, vector, vf->value, &qParams, BY_ID );
-      vf->resultsLen = VecSimQueryResult_Len(vf->results);
+      size_t k = vf->type == VECTOR_SIM_TOPK ? vf->value : SIZE_MAX;
+      double radius = vf->type == VECTOR_SIM_RANGE ? vf->value : INFINITY;
+      if (!query) {
+        // not whole vectors of the field
+        if (filter) filter->Free(filter);
+      } else if (vf->batch) {
+        scored = vectorQueryEach(ctx, fs, vecIdx, &vs, vf, query, vecLen, filter, &scoredLen);
+      } else if (quantized) {
+        scored = vectorQueryQuantized(ctx, fs, vecIdx, query, vecLen, k, radius, vf->rerank,
+                                      filter, &scoredLen);
+        if (filter) filter->Free(filter);
+      } else if (filter || vf->type == VECTOR_SIM_RANGE || vs.numPending) {
+        // Estimate how selective the filter is, to either compute the distances of the
+        // documents passing it, or keep the closest vectors which pass it
+        double selectivity = filterSelectivity(&vs, filter);
+        if (filter && selectivity <= VECSIM_ADHOC_MAX_SELECTIVITY) {
+          scored = vectorQueryAdHoc(ctx, fs, query, vecLen, k, radius, filter, &scoredLen);
+        }
+        if (!scored) {
+          size_t batch = vf->type == VECTOR_SIM_TOPK ? k : VECSIM_RANGE_INITIAL_BATCH;
+          batch = selectivity > 0 ? batch / selectivity : VecSimIndex_IndexSize(vs.index);
+          scored = vectorQueryBatches(&vs, query, &qParams, k, radius, batch, filter,
+                                      &scoredLen);
+        }
+        if (filter) filter->Free(filter);
+      } else {
+        vf->results = VecSimIndex_TopKQuery(vs.index, query, vf->value, &qParams, BY_ID );
+        vf->resultsLen = VecSimQueryResult_Len(vf->results);
+      }
+      if (query && query != vector) {
+        rm_free((void *)query);
+      }
       if (vf->isBase64) {
         rm_free(vector);
       }
       break;
 
     case VECTOR_SIM_INVALID:
-      return NULL;
+      if (filter) filter->Free(filter);
+      break;
+  }
+  if (!quantized) {
+    vectorIndexRelease(vecIdx, &vs);
+  }
+  if (vf->type == VECTOR_SIM_INVALID) {
+    return NULL;
   }
 
-  return NewListIterator(vf->results, vf->resultsLen);
+  IndexIterator *it;
+  if (scored || quantized || vf->batch || !query) {
+    vf->resultsLen = scoredLen;
+    it = NewScoredListIterator(scored, scoredLen);
+  } else {
+    it = NewListIterator(vf->results, vf->resultsLen);
+  }
+  if (fs) {
+    ListIterator_SetDistanceField(it, fs);
+  }
+  return it;
 }
 
 void VectorFilter_InitValues(VectorFilter *vf) {
@@ -100,7 +819,7 @@ VectorQueryType VectorFilter_ParseType(const char *s, size_t len) {
   if (!strncasecmp(s, "TOPK", len)) {
     return VECTOR_SIM_TOPK;
   } else if (!strncasecmp(s, "RANGE", len)) {
-    return VECTOR_SIM_TOPK;
+    return VECTOR_SIM_RANGE;
   } else {
     return VECTOR_SIM_INVALID;
   }
@@ -111,6 +830,10 @@ int VectorFilter_Validate(const VectorFilter *vf, QueryError *status) {
       QERR_MKSYNTAXERR(status, "Invalid Vector similarity type");
       return 0;
     }
+    if (vf->type == VECTOR_SIM_RANGE && !(vf->value >= 0)) {
+      QERR_MKSYNTAXERR(status, "Invalid Vector similarity radius");
+      return 0;
+    }
     return 1;
 }
 
@@ -148,6 +871,19 @@ const char *VecSimType_ToString(VecSimType type) {
   return NULL;
 }
 
+const char *VectorField_TypeToString(const FieldSpec *fs) {
+  switch (fs->vecHalf) {
+    case VectorHalf_Float16: return VECSIM_TYPE_FLOAT16;
+    case VectorHalf_BFloat16: return VECSIM_TYPE_BFLOAT16;
+    case VectorHalf_None: break;
+  }
+  VecSimType type;
+  size_t dim;
+  VecSimMetric metric;
+  vectorFieldParams(fs, &type, &dim, &metric);
+  return VecSimType_ToString(type);
+}
+
 const char *VecSimMetric_ToString(VecSimMetric metric) {
   switch (metric) {
     case VecSimMetric_IP: return VECSIM_METRIC_IP;
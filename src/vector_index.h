@@ -1,6 +1,8 @@
 #pragma once
 #include "search_ctx.h"
 #include "VecSim/vec_sim.h"
+#include "vector_quant.h"
+#include "vector_half.h"
 #include "index_iterator.h"
 #include "query_node.h"
 
@@ -8,6 +10,8 @@
 #define VECSIM_TYPE_FLOAT64 "FLOAT64"
 #define VECSIM_TYPE_INT32 "INT32"
 #define VECSIM_TYPE_INT64 "INT64"
+#define VECSIM_TYPE_FLOAT16 "FLOAT16"
+#define VECSIM_TYPE_BFLOAT16 "BFLOAT16"
 
 #define VECSIM_METRIC_IP "IP"
 #define VECSIM_METRIC_L2 "L2"
@@ -24,6 +28,8 @@
 #define VECSIM_TYPE "TYPE"
 #define VECSIM_DIM "DIM"
 #define VECSIM_DISTANCE_METRIC "DISTANCE_METRIC"
+#define VECSIM_QUANTIZE "QUANTIZE"
+#define VECSIM_QUANT_INT8 "INT8"
 
 #define VECSIM_ERR_MANDATORY(status,algorithm,arg) \
   QERR_MKBADARGS_FMT(status, "Missing mandatory parameter: cannot create %s index without specifying %s argument", algorithm, arg)
@@ -31,26 +37,60 @@
 typedef enum {
   VECTOR_SIM_INVALID = 0,
   VECTOR_SIM_TOPK = 1,
+  VECTOR_SIM_RANGE = 2,
 } VectorQueryType;
 
 typedef struct VectorFilter {
   char *property;                 // name of field
   void *vector;                   // vector data
   size_t vecLen;                  // vector length
-  VectorQueryType type;           // TOPK
+  VectorQueryType type;           // TOPK or RANGE
   bool isBase64;                  // uses base64 strings
   long long efRuntime;            // efRuntime
+  bool rerank;                    // recompute the distances of quantized vectors
+  bool batch;                     // the vector data is a batch of query vectors
   double value;                   // can hold int for TOPK or double for RANGE.
 
   VecSimQueryResult *results;     // array for K results
   int resultsLen;                 // length of array
 } VectorFilter;
 
+/**
+ * The vector index of a field. With VECSIM_THREADS, vectors added to HNSW indexes are queued and
+ * inserted by a worker pool, a batch at a time. Queries and deletions wait for the current batch.
+ * Queries search the index as it stands and compare the query vector with the queued vectors
+ * directly, so they see every added vector.
+ */
+typedef struct VectorIndex VectorIndex;
+
 // TODO: remove idxKey from all OpenFooIndex functions
-VecSimIndex *OpenVectorIndex(RedisSearchCtx *ctx,
+VectorIndex *OpenVectorIndex(RedisSearchCtx *ctx,
   RedisModuleString *keyName/*, RedisModuleKey **idxKey*/);
+void VectorIndex_AddVector(VectorIndex *vi, const void *blob, size_t len, t_docId docId);
+void VectorIndex_DeleteVector(VectorIndex *vi, t_docId docId);
+/* The vectors of a field created with QUANTIZE, which are not stored in a vector index */
+QuantizedVectors *OpenQuantizedVectors(RedisSearchCtx *ctx, RedisModuleString *keyName);
+/* The memory used by the quantized vectors of all the fields of the index, for FT.INFO */
+size_t IndexSpec_QuantizedVectorsMemUsage(IndexSpec *sp);
+
+/**
+ * The vectors which the vector index of the field holds for `blob`: a new FLOAT32 copy for half
+ * precision fields, which sets `len` and is freed with rm_free, or `blob` itself otherwise.
+ * Returns NULL if the blob is not a whole number of vectors of a half precision field.
+ */
+const void *VectorField_IndexedVectors(const FieldSpec *fs, const void *blob, size_t *len);
 
-IndexIterator *NewVectorIterator(RedisSearchCtx *ctx, VectorFilter *vf);
+/**
+ * Iterate the results of a vector query: the K closest vectors for TOPK, or all the vectors within
+ * the radius for RANGE. If `filter` is given, only the vectors of the documents it matches are
+ * returned, so a TOPK query still returns K results if enough documents match. The filter is
+ * consumed by the call.
+ *
+ * A batch query returns the union of the results of each of its query vectors. The filter is read
+ * once for all of them. A document in the results of several query vectors is returned once, with
+ * its distance from the closest of them, and the position of that one in the batch.
+ */
+IndexIterator *NewVectorIterator(RedisSearchCtx *ctx, VectorFilter *vf, IndexIterator *filter);
 
 void VectorFilter_InitValues(VectorFilter *vf);
 VectorQueryType VectorFilter_ParseType(const char *s, size_t len);
@@ -59,5 +99,6 @@ int VectorFilter_EvalParams(dict *params, QueryNode *node, QueryError *status);
 void VectorFilter_Free(VectorFilter *vf);
 
 const char *VecSimType_ToString(VecSimType type);
+const char *VectorField_TypeToString(const FieldSpec *fs);
 const char *VecSimMetric_ToString(VecSimMetric metric);
 const char *VecSimAlgorithm_ToString(VecSimAlgo algo);
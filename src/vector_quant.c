@@ -0,0 +1,286 @@
+#include "vector_quant.h"
+#include "index.h"
+#include "rmalloc.h"
+#include "util/minmax.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// Blocks of this many products can be summed in 32 bits without overflowing
+#define QV_DOT_BLOCK 65536
+// Deleted vectors are compacted away once they are this many, and at least half of the vectors
+#define QV_MIN_COMPACT 64
+
+struct QuantizedVectors {
+  VecSimType type;
+  size_t dim;
+  VecSimMetric metric;
+
+  // Sorted by document id. Deleted vectors have a negative norm until compacted
+  t_docId *ids;
+  float *scales;
+  float *norms;
+  int8_t *codes;
+  size_t len;
+  size_t cap;
+  size_t numDeleted;
+};
+
+static size_t elementSize(VecSimType type) {
+  switch (type) {
+    case VecSimType_FLOAT32: return sizeof(float);
+    case VecSimType_FLOAT64: return sizeof(double);
+    default: return 0;
+  }
+}
+
+static inline double readElement(VecSimType type, const char *blob, size_t i) {
+  // the blobs are not necessarily aligned
+  if (type == VecSimType_FLOAT32) {
+    float f;
+    memcpy(&f, blob + i * sizeof(f), sizeof(f));
+    return f;
+  }
+  double d;
+  memcpy(&d, blob + i * sizeof(d), sizeof(d));
+  return d;
+}
+
+QuantizedVectors *NewQuantizedVectors(VecSimType type, size_t dim, VecSimMetric metric) {
+  QuantizedVectors *qv = rm_calloc(1, sizeof(*qv));
+  qv->type = type;
+  qv->dim = dim;
+  qv->metric = metric;
+  return qv;
+}
+
+void QuantizedVectors_Free(QuantizedVectors *qv) {
+  rm_free(qv->ids);
+  rm_free(qv->scales);
+  rm_free(qv->norms);
+  rm_free(qv->codes);
+  rm_free(qv);
+}
+
+size_t QuantizedVectors_Size(const QuantizedVectors *qv) {
+  return qv->len - qv->numDeleted;
+}
+
+size_t QuantizedVectors_MemUsage(const QuantizedVectors *qv) {
+  return sizeof(*qv) + qv->cap * (sizeof(*qv->ids) + sizeof(*qv->scales) +
+                                  sizeof(*qv->norms) + qv->dim);
+}
+
+/**
+ * Quantize a vector into `codes`, and set its scale and squared norm. Returns -1 if the blob
+ * isn't a vector of this dimension
+ */
+static int quantize(const QuantizedVectors *qv, const void *blob, size_t len, int8_t *codes,
+                    float *scale, float *norm) {
+  size_t elemSize = elementSize(qv->type);
+  if (!elemSize || len != qv->dim * elemSize) {
+    return -1;
+  }
+  double maxAbs = 0, sumSq = 0;
+  for (size_t i = 0; i < qv->dim; i++) {
+    double x = readElement(qv->type, blob, i);
+    maxAbs = MAX(maxAbs, fabs(x));
+    sumSq += x * x;
+  }
+  double factor = 1;
+  if (qv->metric == VecSimMetric_Cosine && sumSq > 0) {
+    factor = 1 / sqrt(sumSq);
+    maxAbs *= factor;
+    sumSq = 1;
+  }
+  double step = maxAbs / 127;
+  for (size_t i = 0; i < qv->dim; i++) {
+    long code = step > 0 ? lrint(readElement(qv->type, blob, i) * factor / step) : 0;
+    codes[i] = code < -127 ? -127 : code > 127 ? 127 : code;
+  }
+  *scale = step;
+  *norm = sumSq;
+  return 0;
+}
+
+static int64_t dotInt8(const int8_t *a, const int8_t *b, size_t dim) {
+  int64_t sum = 0;
+  for (size_t i = 0; i < dim; i += QV_DOT_BLOCK) {
+    size_t end = MIN(i + QV_DOT_BLOCK, dim);
+    int32_t block = 0;
+    // a plain loop the compiler vectorizes
+    for (size_t j = i; j < end; j++) {
+      block += (int32_t)a[j] * b[j];
+    }
+    sum += block;
+  }
+  return sum;
+}
+
+static double distance(const QuantizedVectors *qv, size_t slot, const int8_t *codes, float scale,
+                       float norm) {
+  double dot = (double)qv->scales[slot] * scale * dotInt8(qv->codes + slot * qv->dim, codes, qv->dim);
+  if (qv->metric == VecSimMetric_L2) {
+    return MAX(0, qv->norms[slot] + norm - 2 * dot);
+  }
+  return 1 - dot;
+}
+
+/* The slot of the first vector with an id not below `docId` */
+static size_t findSlot(const QuantizedVectors *qv, t_docId docId) {
+  size_t lo = 0, hi = qv->len;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (qv->ids[mid] < docId) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static void compact(QuantizedVectors *qv) {
+  size_t out = 0;
+  for (size_t i = 0; i < qv->len; i++) {
+    if (qv->norms[i] < 0) {
+      continue;
+    }
+    if (out != i) {
+      qv->ids[out] = qv->ids[i];
+      qv->scales[out] = qv->scales[i];
+      qv->norms[out] = qv->norms[i];
+      memcpy(qv->codes + out * qv->dim, qv->codes + i * qv->dim, qv->dim);
+    }
+    out++;
+  }
+  qv->len = out;
+  qv->numDeleted = 0;
+}
+
+static void grow(QuantizedVectors *qv) {
+  qv->cap = qv->cap ? qv->cap * 2 : 16;
+  qv->ids = rm_realloc(qv->ids, qv->cap * sizeof(*qv->ids));
+  qv->scales = rm_realloc(qv->scales, qv->cap * sizeof(*qv->scales));
+  qv->norms = rm_realloc(qv->norms, qv->cap * sizeof(*qv->norms));
+  qv->codes = rm_realloc(qv->codes, qv->cap * qv->dim);
+}
+
+int QuantizedVectors_Add(QuantizedVectors *qv, const void *blob, size_t len, t_docId docId) {
+  int8_t *codes = rm_malloc(MAX(qv->dim, 1));
+  float scale, norm;
+  if (quantize(qv, blob, len, codes, &scale, &norm) != 0) {
+    rm_free(codes);
+    return -1;
+  }
+
+  // document ids only grow, so this is almost always an append
+  size_t slot = qv->len && qv->ids[qv->len - 1] >= docId ? findSlot(qv, docId) : qv->len;
+  if (slot < qv->len && qv->ids[slot] == docId) {
+    if (qv->norms[slot] < 0) {
+      qv->numDeleted--;
+    }
+  } else {
+    if (qv->len == qv->cap) {
+      grow(qv);
+    }
+    size_t tail = qv->len - slot;
+    memmove(qv->ids + slot + 1, qv->ids + slot, tail * sizeof(*qv->ids));
+    memmove(qv->scales + slot + 1, qv->scales + slot, tail * sizeof(*qv->scales));
+    memmove(qv->norms + slot + 1, qv->norms + slot, tail * sizeof(*qv->norms));
+    memmove(qv->codes + (slot + 1) * qv->dim, qv->codes + slot * qv->dim, tail * qv->dim);
+    qv->len++;
+  }
+  qv->ids[slot] = docId;
+  qv->scales[slot] = scale;
+  qv->norms[slot] = norm;
+  memcpy(qv->codes + slot * qv->dim, codes, qv->dim);
+  rm_free(codes);
+  return 0;
+}
+
+void QuantizedVectors_Delete(QuantizedVectors *qv, t_docId docId) {
+  size_t slot = findSlot(qv, docId);
+  if (slot == qv->len || qv->ids[slot] != docId || qv->norms[slot] < 0) {
+    return;
+  }
+  qv->norms[slot] = -1;
+  qv->numDeleted++;
+  if (qv->numDeleted >= QV_MIN_COMPACT && qv->numDeleted * 2 >= qv->len) {
+    compact(qv);
+  }
+}
+
+/* Sift the farthest result to the top of a max-heap of results */
+static void heapSiftDown(ScoredDocId *heap, size_t n, size_t i) {
+  while (1) {
+    size_t largest = i, l = 2 * i + 1, r = l + 1;
+    if (l < n && heap[l].score > heap[largest].score) largest = l;
+    if (r < n && heap[r].score > heap[largest].score) largest = r;
+    if (largest == i) {
+      return;
+    }
+    ScoredDocId tmp = heap[i];
+    heap[i] = heap[largest];
+    heap[largest] = tmp;
+    i = largest;
+  }
+}
+
+static void heapSiftUp(ScoredDocId *heap, size_t i) {
+  while (i > 0 && heap[(i - 1) / 2].score < heap[i].score) {
+    ScoredDocId tmp = heap[i];
+    heap[i] = heap[(i - 1) / 2];
+    heap[(i - 1) / 2] = tmp;
+    i = (i - 1) / 2;
+  }
+}
+
+ScoredDocId *QuantizedVectors_Query(QuantizedVectors *qv, const void *query, size_t len,
+                                    size_t k, double radius, IndexIterator *filter,
+                                    size_t *numResults) {
+  int8_t *codes = rm_malloc(MAX(qv->dim, 1));
+  float scale, norm;
+  if (quantize(qv, query, len, codes, &scale, &norm) != 0) {
+    rm_free(codes);
+    return NULL;
+  }
+
+  // the results are a max-heap while there are k of them, to replace the farthest
+  size_t cap = MIN(MAX(k, 1), 16), n = 0;
+  ScoredDocId *results = rm_malloc(cap * sizeof(*results));
+  t_docId filterNext = 0;
+  for (size_t slot = 0; slot < qv->len; slot++) {
+    t_docId id = qv->ids[slot];
+    if (qv->norms[slot] < 0) {
+      continue;
+    }
+    if (filter) {
+      int rc = IndexIterator_HasDocId(filter, id, &filterNext);
+      if (rc == INDEXREAD_EOF) {
+        break;
+      } else if (rc != INDEXREAD_OK) {
+        continue;
+      }
+    }
+    double dist = distance(qv, slot, codes, scale, norm);
+    if (dist > radius) {
+      continue;
+    }
+    if (n < k) {
+      if (n == cap) {
+        cap = MIN(cap * 2, k);
+        results = rm_realloc(results, cap * sizeof(*results));
+      }
+      results[n] = (ScoredDocId){.docId = id, .score = dist};
+      heapSiftUp(results, n++);
+    } else if (k && dist < results[0].score) {
+      results[0] = (ScoredDocId){.docId = id, .score = dist};
+      heapSiftDown(results, n, 0);
+    }
+  }
+  rm_free(codes);
+  *numResults = n;
+  return results;
+}
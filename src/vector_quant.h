@@ -0,0 +1,36 @@
+#pragma once
+
+#include "VecSim/vec_sim.h"
+#include "index_iterator.h"
+#include "list_reader.h"
+
+/**
+ * Vectors quantized to int8, for vector fields created with QUANTIZE INT8. Each vector is scaled
+ * by its own largest absolute element, so that element maps to 127, and stored as one byte per
+ * dimension with its scale and its exact squared norm. COSINE vectors are normalized first.
+ *
+ * Distances are computed with integer dot products, and approximate the distances of the full
+ * precision vectors, with the same meaning as the vector index's (squared L2, 1 - dot product).
+ * Vectors are kept sorted by document id, so filters can be intersected while scanning.
+ */
+typedef struct QuantizedVectors QuantizedVectors;
+
+QuantizedVectors *NewQuantizedVectors(VecSimType type, size_t dim, VecSimMetric metric);
+void QuantizedVectors_Free(QuantizedVectors *qv);
+
+/* Add the vector of a document. Returns 0, or -1 if the blob isn't a vector of this dimension */
+int QuantizedVectors_Add(QuantizedVectors *qv, const void *blob, size_t len, t_docId docId);
+void QuantizedVectors_Delete(QuantizedVectors *qv, t_docId docId);
+
+/* The number of vectors, and the memory they use */
+size_t QuantizedVectors_Size(const QuantizedVectors *qv);
+size_t QuantizedVectors_MemUsage(const QuantizedVectors *qv);
+
+/**
+ * Return the `k` closest vectors within `radius` of the query vector, in no particular order, and
+ * set their number in `len`. If `filter` is given, only the documents it matches are returned.
+ * Returns NULL if the query isn't a vector of this dimension. The result is freed with rm_free.
+ */
+ScoredDocId *QuantizedVectors_Query(QuantizedVectors *qv, const void *query, size_t len,
+                                    size_t k, double radius, IndexIterator *filter,
+                                    size_t *numResults);
@@ -10,6 +10,7 @@
 #include "version.h"
 
 #include <vector>
+#include <algorithm>
 #include <array>
 #include <iostream>
 #include <cstdarg>
@@ -246,6 +247,161 @@ TEST_F(AggTest, testGroupSplit) {
   RLookup_Cleanup(&lk_out);
 }
 
+class NumberGenerator : public ResultProcessor {
+ public:
+  RLookupKey *kvalue = NULL;
+  RLookupKey *kscore = NULL;
+  size_t counter = 0;
+  size_t numGroups = 0;
+  size_t numResults = 0;
+
+  NumberGenerator() {
+    memset(static_cast<ResultProcessor *>(this), 0, sizeof(ResultProcessor));
+  }
+};
+
+static void testManyGroups() {
+  QueryIterator qitr = {0};
+  NumberGenerator gen;
+  gen.numGroups = 20000;
+  gen.numResults = 100000;
+  RLookup lk_in = {0};
+  RLookup lk_out = {0};
+  gen.kvalue = RLookup_GetKey(&lk_in, "value", RLOOKUP_F_OCREAT);
+  gen.kscore = RLookup_GetKey(&lk_in, "score", RLOOKUP_F_OCREAT);
+  RLookupKey *val_out = RLookup_GetKey(&lk_out, "value", RLOOKUP_F_OCREAT);
+  RLookupKey *count_out = RLookup_GetKey(&lk_out, "COUNT", RLOOKUP_F_OCREAT);
+  RLookupKey *sum_out = RLookup_GetKey(&lk_out, "SUM", RLOOKUP_F_OCREAT);
+  RLookupKey *max_out = RLookup_GetKey(&lk_out, "MAX", RLOOKUP_F_OCREAT);
+  Grouper *gr = Grouper_New((const RLookupKey **)&gen.kvalue, (const RLookupKey **)&val_out, 1);
+
+  ArgsCursor args = {0};
+  ReducerOptions opt = {0};
+  opt.args = &args;
+  Grouper_AddReducer(gr, RDCRCount_New(&opt), count_out);
+  ReducerOptionsCXX sumOptions("SUM", &lk_in, "score");
+  Grouper_AddReducer(gr, RDCRSum_New(&sumOptions), sum_out);
+  ReducerOptionsCXX maxOptions("MAX", &lk_in, "score");
+  Grouper_AddReducer(gr, RDCRMax_New(&maxOptions), max_out);
+
+  // row i belongs to group i % numGroups, and has a score of i
+  gen.Next = [](ResultProcessor *rp, SearchResult *res) -> int {
+    NumberGenerator *p = static_cast<NumberGenerator *>(rp);
+    if (p->counter >= p->numResults) return RS_RESULT_EOF;
+    size_t ii = p->counter++;
+    res->docId = p->counter;
+    RLookup_WriteOwnKey(p->kvalue, &res->rowdata, RS_NumVal(ii % p->numGroups));
+    RLookup_WriteOwnKey(p->kscore, &res->rowdata, RS_NumVal(ii));
+    return RS_RESULT_OK;
+  };
+  QITR_PushRP(&qitr, &gen);
+  ResultProcessor *gp = Grouper_GetRP(gr);
+  QITR_PushRP(&qitr, gp);
+
+  SearchResult res = {0};
+  size_t perGroup = gen.numResults / gen.numGroups;
+  std::vector<bool> seen(gen.numGroups);
+  size_t ngroups = 0;
+  while (gp->Next(gp, &res) == RS_RESULT_OK) {
+    double key, count, sum, max;
+    ASSERT_TRUE(RSValue_ToNumber(RLookup_GetItem(val_out, &res.rowdata), &key));
+    ASSERT_TRUE(RSValue_ToNumber(RLookup_GetItem(count_out, &res.rowdata), &count));
+    ASSERT_TRUE(RSValue_ToNumber(RLookup_GetItem(sum_out, &res.rowdata), &sum));
+    ASSERT_TRUE(RSValue_ToNumber(RLookup_GetItem(max_out, &res.rowdata), &max));
+    ASSERT_FALSE(seen[key]);
+    seen[key] = true;
+    ASSERT_EQ(perGroup, count);
+    // key + (key + n) + ... + (key + (perGroup - 1) * n)
+    ASSERT_EQ(perGroup * key + gen.numGroups * perGroup * (perGroup - 1) / 2, sum);
+    ASSERT_EQ(key + (perGroup - 1) * gen.numGroups, max);
+    ngroups++;
+    SearchResult_Clear(&res);
+  }
+  ASSERT_EQ(gen.numGroups, ngroups);
+  ASSERT_EQ(gen.numGroups, qitr.totalResults);
+  SearchResult_Destroy(&res);
+  gp->Free(gp);
+  RLookup_Cleanup(&lk_in);
+  RLookup_Cleanup(&lk_out);
+}
+
+TEST_F(AggTest, testGroupByManyGroups) {
+  testManyGroups();
+}
+
+TEST_F(AggTest, testGroupByParallel) {
+  RSGlobalConfig.groupbyThreads = 4;
+  testManyGroups();
+  RSGlobalConfig.groupbyThreads = 0;
+}
+
+TEST_F(AggTest, testGroupByTopK) {
+  RLookup lk_in = {0};
+  RLookup lk_out = {0};
+  RLookupKey *kvalue = RLookup_GetKey(&lk_in, "value", RLOOKUP_F_OCREAT);
+  RLookupKey *kscore = RLookup_GetKey(&lk_in, "score", RLOOKUP_F_OCREAT);
+  RLookupKey *val_out = RLookup_GetKey(&lk_out, "value", RLOOKUP_F_OCREAT);
+  RLookupKey *sum_out = RLookup_GetKey(&lk_out, "SUM", RLOOKUP_F_OCREAT);
+  RLookupKey *other = RLookup_GetKey(&lk_out, "other", RLOOKUP_F_OCREAT);
+
+  // {sort key, ascending, expected keys}
+  struct {
+    RLookupKey *sortkey;
+    int ascending;
+    std::vector<double> expected;
+  } cases[] = {{sum_out, 0, {999, 998, 997, 996, 995}},
+               {sum_out, 1, {0, 1, 2, 3, 4}},
+               {val_out, 0, {999, 998, 997, 996, 995}}};
+
+  for (auto &c : cases) {
+    QueryIterator qitr = {0};
+    NumberGenerator gen;
+    gen.numGroups = 1000;
+    gen.numResults = 10000;
+    gen.kvalue = kvalue;
+    gen.kscore = kscore;
+    Grouper *gr = Grouper_New((const RLookupKey **)&kvalue, (const RLookupKey **)&val_out, 1);
+    ReducerOptionsCXX sumOptions("SUM", &lk_in, "score");
+    Grouper_AddReducer(gr, RDCRSum_New(&sumOptions), sum_out);
+    ASSERT_FALSE(Grouper_SetTopK(gr, other, c.ascending, 5));
+    ASSERT_TRUE(Grouper_SetTopK(gr, c.sortkey, c.ascending, 5));
+
+    // row i belongs to group i % numGroups, and has a score of i
+    gen.Next = [](ResultProcessor *rp, SearchResult *res) -> int {
+      NumberGenerator *p = static_cast<NumberGenerator *>(rp);
+      if (p->counter >= p->numResults) return RS_RESULT_EOF;
+      size_t ii = p->counter++;
+      res->docId = p->counter;
+      RLookup_WriteOwnKey(p->kvalue, &res->rowdata, RS_NumVal(ii % p->numGroups));
+      RLookup_WriteOwnKey(p->kscore, &res->rowdata, RS_NumVal(ii));
+      return RS_RESULT_OK;
+    };
+    QITR_PushRP(&qitr, &gen);
+    ResultProcessor *gp = Grouper_GetRP(gr);
+    QITR_PushRP(&qitr, gp);
+
+    SearchResult res = {0};
+    std::vector<double> keys;
+    while (gp->Next(gp, &res) == RS_RESULT_OK) {
+      double key, sum;
+      ASSERT_TRUE(RSValue_ToNumber(RLookup_GetItem(val_out, &res.rowdata), &key));
+      ASSERT_TRUE(RSValue_ToNumber(RLookup_GetItem(sum_out, &res.rowdata), &sum));
+      ASSERT_EQ(10 * key + gen.numGroups * 45, sum);
+      keys.push_back(key);
+      SearchResult_Clear(&res);
+    }
+    std::sort(keys.begin(), keys.end());
+    std::sort(c.expected.begin(), c.expected.end());
+    ASSERT_EQ(c.expected, keys);
+    // the total is still the number of groups
+    ASSERT_EQ(gen.numGroups, qitr.totalResults);
+    SearchResult_Destroy(&res);
+    gp->Free(gp);
+  }
+  RLookup_Cleanup(&lk_in);
+  RLookup_Cleanup(&lk_out);
+}
+
 #if 0
 int testAggregatePlan() {
   CmdString *argv = CmdParser_NewArgListV(
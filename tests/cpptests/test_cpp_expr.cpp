@@ -1,6 +1,7 @@
 #include "gtest/gtest.h"
 #include "aggregate/expr/expression.h"
 #include "aggregate/expr/exprast.h"
+#include "aggregate/expr/exprvm.h"
 #include "aggregate/functions/function.h"
 #include "util/arr.h"
 
@@ -261,4 +262,61 @@ TEST_F(ExprTest, testPropertyFetch) {
   // RSValue_Print(&ctx.result());
   RLookupRow_Cleanup(&rr);
   RLookup_Cleanup(&lk);
-}
\ No newline at end of file
+}
+
+TEST_F(ExprTest, testProgram) {
+  RLookup lk = {0};
+  RLookup_Init(&lk, NULL);
+  auto *kfoo = RLookup_GetKey(&lk, "foo", RLOOKUP_F_OCREAT);
+  auto *kbar = RLookup_GetKey(&lk, "bar", RLOOKUP_F_OCREAT);
+  auto *kstr = RLookup_GetKey(&lk, "str", RLOOKUP_F_OCREAT);
+  RLookup_GetKey(&lk, "baz", RLOOKUP_F_OCREAT);
+  RLookupRow rr = {0};
+  RLookup_WriteOwnKey(kfoo, &rr, RS_NumVal(1));
+  RLookup_WriteOwnKey(kbar, &rr, RS_NumVal(2));
+  RLookup_WriteOwnKey(kstr, &rr, RS_ConstStringVal((char *)"3", 1));
+
+  // expressions the VM compiles must give the interpreter's result, or ask for a fallback
+  const struct {
+    const char *expr;
+    bool compiles;
+    bool runs;
+  } cases[] = {
+      {"@foo + @bar * 2", true, true},
+      {"(((2 + @foo) * (3 / @bar) + 2 % 3 - 0.43) ^ -3)", true, true},
+      {"@foo < @bar && !(@bar == 3)", true, true},
+      {"@foo >= @bar || @foo != 1", true, true},
+      {"!(@foo - 1) + (@bar > 1)", true, true},
+      {"@str * 2", true, true},
+      {"@str == 3", true, false},
+      {"@baz + 1", true, false},
+      {"@foo", false, false},
+      {"@foo == 'foo'", false, false},
+      {"@foo == NULL", false, false},
+      {"sqrt(@foo) + 1", false, false},
+  };
+  for (auto &c : cases) {
+    QueryError status = {QueryErrorCode(0)};
+    TEvalCtx ctx(ExprAST_Parse(c.expr, strlen(c.expr), &status));
+    ASSERT_TRUE(ctx.root) << c.expr;
+    ctx.lookup = &lk;
+    ctx.srcrow = &rr;
+    ASSERT_EQ(EXPR_EVAL_OK, ctx.bindLookupKeys()) << c.expr;
+
+    ExprProgram *prog = ExprProgram_Compile(ctx.root);
+    ASSERT_EQ(c.compiles, prog != NULL) << c.expr;
+    if (!prog) continue;
+
+    double d;
+    ASSERT_EQ(c.runs, ExprProgram_Run(prog, &rr, &d)) << c.expr;
+    if (c.runs) {
+      ASSERT_EQ(EXPR_EVAL_OK, ctx.eval()) << c.expr;
+      ASSERT_EQ(RSValue_Number, ctx.result().t) << c.expr;
+      ASSERT_DOUBLE_EQ(ctx.result().numval, d) << c.expr;
+    }
+    ExprProgram_Free(prog);
+  }
+
+  RLookupRow_Cleanup(&rr);
+  RLookup_Cleanup(&lk);
+}
@@ -20,6 +20,7 @@
 #include <time.h>
 #include <float.h>
 #include <vector>
+#include <algorithm>
 #include <cstdint>
 
 class IndexTest : public ::testing::Test {};
@@ -131,6 +132,77 @@ TEST_F(IndexTest, testDistance) {
   VVW_Free(vw3);
 }
 
+// Brute force reference for IndexResult_IsWithinRange on the positions of the terms
+static bool bruteWithinRange(const std::vector<std::vector<uint32_t>> &terms, size_t i,
+                             std::vector<uint32_t> &picked, int maxSlop, bool inOrder) {
+  if (i == terms.size()) {
+    if (inOrder) {
+      int span = 0;
+      for (size_t j = 1; j < picked.size(); j++) {
+        if (picked[j] < picked[j - 1]) return false;
+        span += (int)picked[j] - (int)picked[j - 1] - 1;
+      }
+      return span <= maxSlop;
+    }
+    uint32_t mn = *std::min_element(picked.begin(), picked.end());
+    uint32_t mx = *std::max_element(picked.begin(), picked.end());
+    return mn != mx && (int)mx - (int)mn - (int)(picked.size() - 1) <= maxSlop;
+  }
+  for (uint32_t pos : terms[i]) {
+    picked.push_back(pos);
+    bool ok = bruteWithinRange(terms, i + 1, picked, maxSlop, inOrder);
+    picked.pop_back();
+    if (ok) return true;
+  }
+  return false;
+}
+
+TEST_F(IndexTest, testPhraseWithinRange) {
+  srand(1234);
+  for (int round = 0; round < 200; round++) {
+    // three terms at distinct positions of a document. Every few rounds use a long document, so
+    // the positions are decoded on the heap
+    uint32_t docLen = round % 10 ? 4 + rand() % 40 : 500;
+    std::vector<std::vector<uint32_t>> terms(3);
+    for (uint32_t pos = 1; pos <= docLen; pos++) {
+      int t = rand() % 5;
+      if (t < 3) terms[t].push_back(pos);
+    }
+    if (terms[0].empty() || terms[1].empty() || terms[2].empty()) {
+      continue;
+    }
+    std::vector<VarintVectorWriter *> writers;
+    RSIndexResult *res = NewIntersectResult(3, 1);
+    std::vector<RSIndexResult *> records;
+    for (auto &positions : terms) {
+      VarintVectorWriter *vw = NewVarintVectorWriter(8);
+      for (uint32_t pos : positions) {
+        VVW_Write(vw, pos);
+      }
+      VVW_Truncate(vw);
+      RSIndexResult *tr = NewTokenRecord(NULL, 1);
+      tr->docId = 1;
+      tr->term.offsets = offsetsFromVVW(vw);
+      AggregateResult_AddChild(res, tr);
+      writers.push_back(vw);
+      records.push_back(tr);
+    }
+
+    std::vector<uint32_t> picked;
+    for (int slop = 0; slop < 4; slop++) {
+      for (int inOrder = 0; inOrder < 2; inOrder++) {
+        ASSERT_EQ(bruteWithinRange(terms, 0, picked, slop, inOrder),
+                  (bool)IndexResult_IsWithinRange(res, slop, inOrder))
+            << "round " << round << " slop " << slop << " inOrder " << inOrder;
+      }
+    }
+
+    for (auto tr : records) IndexResult_Free(tr);
+    for (auto vw : writers) VVW_Free(vw);
+    IndexResult_Free(res);
+  }
+}
+
 class IndexFlagsTest : public testing::TestWithParam<int> {};
 
 TEST_P(IndexFlagsTest, testRWFlags) {
@@ -370,7 +442,7 @@ TEST_F(IndexTest, testNot) {
   // printf("Reading!\n");
   IndexIterator **irs = (IndexIterator **)calloc(2, sizeof(IndexIterator *));
   irs[0] = NewReadIterator(r1);
-  irs[1] = NewNotIterator(NewReadIterator(r2), w2->lastId, 1);
+  irs[1] = NewNotIterator(NewReadIterator(r2), w2->lastId, NULL, 1);
 
   IndexIterator *ui = NewIntersecIterator(irs, 2, NULL, RS_FIELDMASK_ALL, -1, 0, 1);
   RSIndexResult *h = NULL;
@@ -394,7 +466,7 @@ TEST_F(IndexTest, testPureNot) {
   IndexReader *r1 = NewTermIndexReader(w, NULL, RS_FIELDMASK_ALL, NULL, 1);  //
   printf("last id: %llu\n", (unsigned long long)w->lastId);
 
-  IndexIterator *ir = NewNotIterator(NewReadIterator(r1), w->lastId + 5, 1);
+  IndexIterator *ir = NewNotIterator(NewReadIterator(r1), w->lastId + 5, NULL, 1);
 
   RSIndexResult *h = NULL;
   int expected[] = {1,  2,  4,  5,  7,  8,  10, 11, 13, 14, 16, 17, 19,
@@ -409,6 +481,56 @@ TEST_F(IndexTest, testPureNot) {
   InvertedIndex_Free(w);
 }
 
+TEST_F(IndexTest, testLiveDocsIterators) {
+  // ids 1..200, every 7th document is deleted
+  DocTable dt = NewDocTable(10, 1000);
+  char buf[16];
+  for (int i = 1; i <= 200; ++i) {
+    size_t n = sprintf(buf, "doc%d", i);
+    DocTable_Put(&dt, buf, n, 1.0, Document_DefaultFlags, NULL, 0, DocumentType_Hash);
+  }
+  for (int i = 7; i <= 200; i += 7) {
+    size_t n = sprintf(buf, "doc%d", i);
+    ASSERT_TRUE(DocTable_Delete(&dt, buf, n));
+  }
+  ASSERT_FALSE(DocTable_IsLive(&dt, 14));
+  ASSERT_TRUE(DocTable_IsLive(&dt, 15));
+
+  IndexIterator *wi = NewWildcardIterator(dt.maxDocId, &dt);
+  ASSERT_EQ(200 - 200 / 7, wi->Len(wi->ctx));
+  RSIndexResult *h = NULL;
+  t_docId expected = 0;
+  while (wi->Read(wi->ctx, &h) != INDEXREAD_EOF) {
+    if (++expected % 7 == 0) ++expected;
+    ASSERT_EQ(expected, h->docId);
+  }
+  ASSERT_EQ(200, expected);
+
+  // skipping to a deleted id lands on the next live one
+  wi->Rewind(wi->ctx);
+  ASSERT_EQ(INDEXREAD_NOTFOUND, wi->SkipTo(wi->ctx, 21, &h));
+  ASSERT_EQ(22, h->docId);
+  ASSERT_EQ(INDEXREAD_OK, wi->SkipTo(wi->ctx, 23, &h));
+  ASSERT_EQ(23, h->docId);
+  wi->Free(wi);
+
+  // multiples of 3 are in the child, so we expect neither multiples of 3 nor of 7
+  InvertedIndex *w = createIndex(70, 3);
+  IndexReader *r = NewTermIndexReader(w, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  IndexIterator *ni = NewNotIterator(NewReadIterator(r), dt.maxDocId, &dt, 1);
+  expected = 0;
+  while (ni->Read(ni->ctx, &h) != INDEXREAD_EOF) {
+    do {
+      ++expected;
+    } while (expected % 3 == 0 || expected % 7 == 0);
+    ASSERT_EQ(expected, h->docId);
+  }
+  ASSERT_EQ(200, expected);
+  ni->Free(ni);
+  InvertedIndex_Free(w);
+  DocTable_Free(&dt);
+}
+
 // Note -- in test_index.c, this test was never actually run!
 TEST_F(IndexTest, DISABLED_testOptional) {
   InvertedIndex *w = createIndex(16, 1);
@@ -420,7 +542,7 @@ TEST_F(IndexTest, DISABLED_testOptional) {
   // printf("Reading!\n");
   IndexIterator **irs = (IndexIterator **)calloc(2, sizeof(IndexIterator *));
   irs[0] = NewReadIterator(r1);
-  irs[1] = NewOptionalIterator(NewReadIterator(r2), w2->lastId, 1);
+  irs[1] = NewOptionalIterator(NewReadIterator(r2), w2->lastId, NULL, 1);
 
   IndexIterator *ui = NewIntersecIterator(irs, 2, NULL, RS_FIELDMASK_ALL, -1, 0, 1);
   RSIndexResult *h = NULL;
@@ -1120,6 +1242,108 @@ TEST_F(IndexTest, testVarintFieldMask) {
   Buffer_Free(&b);
 }
 
+static InvertedIndex *createOffsetsIndex(IndexFlags flags, int size) {
+  InvertedIndex *idx = NewInvertedIndex(flags, 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder(idx->flags);
+  for (int i = 1; i <= size; i++) {
+    ForwardIndexEntry h = {0};
+    h.docId = i;
+    h.fieldMask = i % 3 ? 1 : 2;
+    h.freq = 1 + i % 5;
+    h.vw = NewVarintVectorWriter(8);
+    for (int n = 0; n < i % 5; n++) {
+      VVW_Write(h.vw, i + n);
+    }
+    InvertedIndex_WriteForwardIndexEntry(idx, enc, &h);
+    VVW_Free(h.vw);
+  }
+  return idx;
+}
+
+static void assertSameRecord(RSIndexResult *a, RSIndexResult *b) {
+  ASSERT_EQ(a->docId, b->docId);
+  ASSERT_EQ(a->freq, b->freq);
+  ASSERT_EQ(a->fieldMask, b->fieldMask);
+  ASSERT_EQ(a->term.offsets.len, b->term.offsets.len);
+  ASSERT_EQ(0, memcmp(a->term.offsets.data, b->term.offsets.data, a->term.offsets.len));
+}
+
+TEST_F(IndexTest, testSplitOffsets) {
+  IndexFlags flags = (IndexFlags)(INDEX_DEFAULT_FLAGS);
+  ASSERT_TRUE(INDEX_SPLIT_OFFSETS(flags));
+  InvertedIndex *split = createOffsetsIndex(flags, 250);
+  InvertedIndex *inter = createOffsetsIndex((IndexFlags)(flags & ~Index_SplitTermOffsets), 250);
+  ASSERT_EQ(3, split->size);
+  ASSERT_EQ(inter->size, split->size);
+  for (uint32_t i = 0; i < split->size; ++i) {
+    IndexBlock *sb = split->blocks + i, *ib = inter->blocks + i;
+    ASSERT_EQ(IndexBlock_DataLen(ib), IndexBlock_DataLen(sb) + IndexBlock_OffsetsLen(sb));
+    ASSERT_EQ(0, IndexBlock_OffsetsLen(ib));
+  }
+
+  // sequential reads return the same records, offsets included
+  IndexReader *sr = NewTermIndexReader(split, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  IndexReader *ir = NewTermIndexReader(inter, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  RSIndexResult *sh = NULL, *ih = NULL;
+  int n = 0;
+  while (IR_Read(ir, &ih) == INDEXREAD_OK) {
+    ASSERT_EQ(INDEXREAD_OK, IR_Read(sr, &sh));
+    assertSameRecord(ih, sh);
+    ++n;
+  }
+  ASSERT_EQ(250, n);
+  ASSERT_EQ(INDEXREAD_EOF, IR_Read(sr, &sh));
+  IR_Free(sr);
+  IR_Free(ir);
+
+  // skipping with a field mask keeps the offsets stream in sync
+  sr = NewTermIndexReader(split, NULL, 2, NULL, 1);
+  ir = NewTermIndexReader(inter, NULL, 2, NULL, 1);
+  for (t_docId id = 5; id <= 250; id += 7) {
+    int rc = IR_SkipTo(ir, id, &ih);
+    ASSERT_EQ(rc, IR_SkipTo(sr, id, &sh));
+    if (rc == INDEXREAD_EOF) break;
+    assertSameRecord(ih, sh);
+  }
+  IR_Free(sr);
+  IR_Free(ir);
+
+  // repairing compacts the offsets stream along with the records
+  DocTable dt = NewDocTable(10, 1000);
+  char buf[16];
+  for (int i = 1; i <= 250; ++i) {
+    size_t len = sprintf(buf, "doc%d", i);
+    DocTable_Put(&dt, buf, len, 1.0, Document_DefaultFlags, NULL, 0, DocumentType_Hash);
+  }
+  for (int i = 4; i <= 250; i += 4) {
+    size_t len = sprintf(buf, "doc%d", i);
+    ASSERT_TRUE(DocTable_Delete(&dt, buf, len));
+  }
+  IndexRepairParams params = {0};
+  InvertedIndex_Repair(split, &dt, 0, &params);
+  ASSERT_EQ(250 / 4, params.docsCollected);
+  params = (IndexRepairParams){0};
+  InvertedIndex_Repair(inter, &dt, 0, &params);
+
+  sr = NewTermIndexReader(split, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  ir = NewTermIndexReader(inter, NULL, RS_FIELDMASK_ALL, NULL, 1);
+  n = 0;
+  while (IR_Read(ir, &ih) == INDEXREAD_OK) {
+    ASSERT_EQ(INDEXREAD_OK, IR_Read(sr, &sh));
+    ASSERT_NE(0, sh->docId % 4);
+    assertSameRecord(ih, sh);
+    ++n;
+  }
+  ASSERT_EQ(250 - 250 / 4, n);
+  ASSERT_EQ(INDEXREAD_EOF, IR_Read(sr, &sh));
+  IR_Free(sr);
+  IR_Free(ir);
+
+  DocTable_Free(&dt);
+  InvertedIndex_Free(split);
+  InvertedIndex_Free(inter);
+}
+
 TEST_F(IndexTest, testDeltaSplits) {
   InvertedIndex *idx = NewInvertedIndex((IndexFlags)(INDEX_DEFAULT_FLAGS), 1);
   ForwardIndexEntry ent = {0};
@@ -2,6 +2,7 @@
 #include "src/redisearch_api.h"
 #include "gtest/gtest.h"
 #include "common.h"
+#include "util/prefix_cache.h"
 
 #include <set>
 #include <string>
@@ -278,6 +279,51 @@ TEST_F(LLApiTest, testAddDocumetTagField) {
   RediSearch_DropIndex(index);
 }
 
+static void addTextAndTagDoc(RSIndex* index, const char* id, const char* text, const char* tag) {
+  RSDoc* d = RediSearch_CreateDocument(id, strlen(id), 1.0, NULL);
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_1, text, RSFLDTYPE_DEFAULT);
+  RediSearch_DocumentAddFieldCString(d, TAG_FIELD_NAME1, tag, RSFLDTYPE_DEFAULT);
+  RediSearch_SpecAddDocument(index, d);
+}
+
+static size_t searchTagPrefix(RSIndex* index, const char* prefix) {
+  RSQNode* qn = RediSearch_CreateTagNode(index, TAG_FIELD_NAME1);
+  RediSearch_QueryNodeAddChild(qn, RediSearch_CreatePrefixNode(index, NULL, prefix));
+  return search(index, qn).size();
+}
+
+TEST_F(LLApiTest, testPrefixCache) {
+  // small enough for prefix expansions to be cached
+  RSGlobalConfig.maxPrefixExpansions = 3;
+
+  RSIndex* index = RediSearch_CreateIndex("index", NULL);
+  RediSearch_CreateField(index, FIELD_NAME_1, RSFLDTYPE_FULLTEXT, RSFLDOPT_NONE);
+  RediSearch_CreateTagField(index, TAG_FIELD_NAME1);
+
+  addTextAndTagDoc(index, "doc1", "hello", "tag_a");
+  ASSERT_EQ(1, search(index, RediSearch_CreatePrefixNode(index, FIELD_NAME_1, "hel")).size());
+  ASSERT_EQ(1, searchTagPrefix(index, "ta"));
+  ASSERT_EQ(1, search(index, RediSearch_CreatePrefixNode(index, FIELD_NAME_1, "hel")).size());
+  ASSERT_EQ(1, index->prefixCache->hits);
+
+  // new terms invalidate the cached expansions of their prefixes
+  addTextAndTagDoc(index, "doc2", "help", "tag_b");
+  ASSERT_EQ(2, search(index, RediSearch_CreatePrefixNode(index, FIELD_NAME_1, "hel")).size());
+  ASSERT_EQ(2, searchTagPrefix(index, "ta"));
+
+  addTextAndTagDoc(index, "doc3", "helm", "tag_c");
+  addTextAndTagDoc(index, "doc4", "helix", "tag_d");
+  ASSERT_EQ(3, search(index, RediSearch_CreatePrefixNode(index, FIELD_NAME_1, "hel")).size());
+  ASSERT_EQ(3, searchTagPrefix(index, "ta"));
+
+  // an expansion truncated at a lower limit is not reused
+  RSGlobalConfig.maxPrefixExpansions = 10;
+  ASSERT_EQ(4, search(index, RediSearch_CreatePrefixNode(index, FIELD_NAME_1, "hel")).size());
+  ASSERT_EQ(4, searchTagPrefix(index, "ta"));
+
+  RediSearch_DropIndex(index);
+}
+
 TEST_F(LLApiTest, testPhoneticSearch) {
   // creating the index
   RSIndex* index = RediSearch_CreateIndex("index", NULL);
@@ -2,9 +2,13 @@
 #include "gtest/gtest.h"
 #include "trie/trie.h"
 #include "trie/trie_type.h"
+#include "trie/fuzzy_index.h"
+#include "util/arr.h"
 
+#include <algorithm>
 #include <set>
 #include <string>
+#include <vector>
 
 typedef std::set<std::string> ElemSet;
 
@@ -121,3 +125,87 @@ TEST_F(TrieTest, testDeepEntry) {
   ASSERT_EQ(maxbuf, ret.size());
   TrieType_Free(t);
 }
+
+static int levenshtein(const std::string &a, const std::string &b) {
+  std::vector<int> row(b.size() + 1);
+  for (size_t jj = 0; jj <= b.size(); ++jj) row[jj] = jj;
+  for (size_t ii = 1; ii <= a.size(); ++ii) {
+    int diag = row[0];
+    row[0] = ii;
+    for (size_t jj = 1; jj <= b.size(); ++jj) {
+      int up = row[jj];
+      row[jj] = std::min({diag + (a[ii - 1] != b[jj - 1]), up + 1, row[jj - 1] + 1});
+      diag = up;
+    }
+  }
+  return row[b.size()];
+}
+
+static ElemSet bruteForceFuzzy(const ElemSet &words, const std::string &s, int maxDist) {
+  ElemSet ret;
+  for (auto &w : words) {
+    if (levenshtein(w, s) <= maxDist) ret.insert(w);
+  }
+  return ret;
+}
+
+static ElemSet fuzzyIndexFind(FuzzyIndex *fi, const std::string &s, int maxDist) {
+  ElemSet ret;
+  FuzzyIndexMatch *matches = FuzzyIndex_Find(fi, s.c_str(), s.size(), maxDist);
+  for (size_t ii = 0; ii < array_len(matches); ++ii) {
+    if (ii) {
+      EXPECT_LE(matches[ii - 1].dist, matches[ii].dist);
+    }
+    ret.insert(std::string(matches[ii].str, matches[ii].len));
+  }
+  FuzzyIndex_FreeMatches(matches);
+  return ret;
+}
+
+TEST_F(TrieTest, testFuzzyIndex) {
+  FuzzyIndex *fi = NewFuzzyIndex(FUZZY_INDEX_MAX_DIST, 0);
+  std::vector<std::string> words;
+  ElemSet live;
+
+  // a small alphabet, so that most words have close neighbours. Lengths cross the prefix length
+  srand(1337);
+  for (size_t ii = 0; ii < 2000; ++ii) {
+    std::string w;
+    size_t n = 1 + rand() % 12;
+    for (size_t jj = 0; jj < n; ++jj) {
+      w += "abcd"[rand() % 4];
+    }
+    bool isNew = live.insert(w).second;
+    ASSERT_EQ(isNew, FuzzyIndex_Add(fi, w.c_str(), w.size()));
+    words.push_back(w);
+  }
+  ASSERT_EQ(live.size(), FuzzyIndex_NumTerms(fi));
+  ASSERT_TRUE(FuzzyIndex_Find(fi, "abc", 3, FUZZY_INDEX_MAX_DIST + 1) == NULL);
+
+  auto compare = [&]() {
+    for (size_t ii = 0; ii < 30; ++ii) {
+      const std::string &q = words[rand() % words.size()];
+      std::string mutated = q;
+      mutated[rand() % q.size()] = 'e';
+      for (int d = 0; d <= FUZZY_INDEX_MAX_DIST; ++d) {
+        ASSERT_EQ(bruteForceFuzzy(live, q, d), fuzzyIndexFind(fi, q, d)) << q << " " << d;
+        ASSERT_EQ(bruteForceFuzzy(live, mutated, d), fuzzyIndexFind(fi, mutated, d)) << mutated;
+      }
+    }
+  };
+  compare();
+
+  // deleted terms are not returned anymore
+  for (size_t ii = 0; ii < words.size(); ii += 3) {
+    const std::string &w = words[ii];
+    ASSERT_EQ(live.erase(w), FuzzyIndex_Delete(fi, w.c_str(), w.size()));
+  }
+  ASSERT_EQ(live.size(), FuzzyIndex_NumTerms(fi));
+  compare();
+
+  // the query is case folded
+  ASSERT_TRUE(FuzzyIndex_Add(fi, "hello", 5));
+  ASSERT_EQ(ElemSet({"hello"}), fuzzyIndexFind(fi, "HELO", 1));
+
+  FuzzyIndex_Free(fi);
+}
@@ -2,6 +2,8 @@
 
 #include "value.h"
 
+#include <vector>
+
 class ValueTest : public ::testing::Test {};
 
 TEST_F(ValueTest, testBasic) {
@@ -87,4 +89,42 @@ TEST_F(ValueTest, testNumericFormat) {
   RSValue_SetNumber(v, 1581011976800);
   ASSERT_STREQ("1581011976800", toString(v).c_str());
   RSValue_Decref(v);
-}
\ No newline at end of file
+}
+
+TEST_F(ValueTest, testSortPrefix) {
+  // prefixes which differ must order like the values
+  std::vector<RSValue *> nums = {RS_NumVal(-1e10), RS_NumVal(-2.5), RS_NumVal(-0.0), RS_NumVal(0),
+                                 RS_NumVal(1e-300), RS_NumVal(3), RS_NumVal(1e10)};
+  std::vector<RSValue *> strs = {
+      RS_StringValC(strdup("")),          RS_StringValC(strdup("a")),
+      RS_StringValC(strdup("abcdefgh")),  RS_StringValC(strdup("abcdefghij")),
+      RS_StringValC(strdup("abcdefgi")),  RS_StringValC(strdup("b")),
+      RS_StringValC(strdup("\xc3\xa9t\xc3\xa9"))};
+
+  for (auto vals : {nums, strs}) {
+    for (auto v1 : vals) {
+      for (auto v2 : vals) {
+        uint64_t p1, p2;
+        RSSortPrefixKind k1 = RSValue_SortPrefix(v1, &p1);
+        RSSortPrefixKind k2 = RSValue_SortPrefix(v2, &p2);
+        ASSERT_NE(RSSortPrefix_None, k1);
+        ASSERT_EQ(k1, k2);
+        int rc = RSValue_Cmp(v1, v2, NULL);
+        if (p1 != p2) {
+          ASSERT_EQ(p1 < p2 ? -1 : 1, rc < 0 ? -1 : 1);
+        } else if (v1->t == RSValue_Number) {
+          ASSERT_EQ(0, rc);
+        }
+      }
+    }
+    for (auto v : vals) {
+      RSValue_Decref(v);
+    }
+  }
+
+  uint64_t p;
+  ASSERT_EQ(RSSortPrefix_None, RSValue_SortPrefix(RS_NullVal(), &p));
+  RSValue *nan = RS_NumVal(NAN);
+  ASSERT_EQ(RSSortPrefix_None, RSValue_SortPrefix(nan, &p));
+  RSValue_Decref(nan);
+}
@@ -0,0 +1,92 @@
+#include "src/rs_geo.h"
+#include "rmutil/alloc.h"
+#include "test_util.h"
+
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+  double minLon, minLat, maxLon, maxLat;
+} Box;
+
+static GeoCellRelation boxRelation(const GeoHashArea *cell, const void *ctx) {
+  const Box *b = ctx;
+  if (cell->longitude.max < b->minLon || cell->longitude.min > b->maxLon ||
+      cell->latitude.max < b->minLat || cell->latitude.min > b->maxLat) {
+    return GEO_CELL_DISJOINT;
+  } else if (cell->longitude.min >= b->minLon && cell->longitude.max <= b->maxLon &&
+             cell->latitude.min >= b->minLat && cell->latitude.max <= b->maxLat) {
+    return GEO_CELL_CONTAINED;
+  }
+  return GEO_CELL_INTERSECTS;
+}
+
+static GeoCellRelation noneRelation(const GeoHashArea *cell, const void *ctx) {
+  return GEO_CELL_DISJOINT;
+}
+
+static GeoCellRelation allRelation(const GeoHashArea *cell, const void *ctx) {
+  return GEO_CELL_CONTAINED;
+}
+
+static int covered(const GeoHashRange *ranges, size_t n, double lon, double lat) {
+  double hash;
+  encodeGeo(lon, lat, &hash);
+  for (size_t i = 0; i < n; i++) {
+    if (hash >= ranges[i].min && hash < ranges[i].max) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static double randIn(double min, double max) {
+  return min + (max - min) * rand() / RAND_MAX;
+}
+
+/* The points of a box are covered, and few points around it are */
+static int testCoverBox() {
+  Box boxes[] = {{2.3, 48.8, 2.4, 48.9}, {-10, -10, 10, 10}, {179, 0, 179.5, 0.2}};
+  for (size_t b = 0; b < sizeof(boxes) / sizeof(boxes[0]); b++) {
+    const Box *box = &boxes[b];
+    GeoHashRange ranges[GEO_COVER_MAX_CELLS];
+    size_t n = calcCoverRanges(boxRelation, box, ranges, GEO_COVER_MAX_CELLS);
+    ASSERT(n > 0 && n <= GEO_COVER_MAX_CELLS);
+    for (size_t i = 0; i < n; i++) {
+      ASSERT(ranges[i].min < ranges[i].max);
+      // sorted, and adjacent ranges are merged
+      ASSERT(i == 0 || ranges[i - 1].max < ranges[i].min);
+    }
+
+    double w = box->maxLon - box->minLon, h = box->maxLat - box->minLat;
+    size_t outside = 0;
+    for (size_t i = 0; i < 10000; i++) {
+      ASSERT(covered(ranges, n, randIn(box->minLon, box->maxLon), randIn(box->minLat, box->maxLat)));
+      // the box is the center ninth of this area
+      double lon = randIn(box->minLon - w, box->maxLon + w);
+      double lat = randIn(box->minLat - h, box->maxLat + h);
+      if (lon < box->minLon || lon > box->maxLon || lat < box->minLat || lat > box->maxLat) {
+        outside += covered(ranges, n, lon, lat);
+      }
+    }
+    // a fraction of the area around the box is covered
+    ASSERT(outside < 10000 / 4);
+  }
+  return 0;
+}
+
+static int testCoverNothingOrAll() {
+  GeoHashRange ranges[GEO_COVER_MAX_CELLS];
+  ASSERT_EQUAL(0, calcCoverRanges(noneRelation, NULL, ranges, GEO_COVER_MAX_CELLS));
+  ASSERT_EQUAL(1, calcCoverRanges(allRelation, NULL, ranges, GEO_COVER_MAX_CELLS));
+  ASSERT_EQUAL(0, ranges[0].min);
+  ASSERT_EQUAL((double)(1ULL << 52), ranges[0].max);
+  return 0;
+}
+
+TEST_MAIN({
+  RMUTil_InitAlloc();
+  srand(1337);
+  TESTFUNC(testCoverBox);
+  TESTFUNC(testCoverNothingOrAll);
+})
@@ -0,0 +1,88 @@
+#include "src/hll/hll.h"
+#include "src/rmalloc.h"
+#include "rmutil/alloc.h"
+#include "test_util.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+static void addNumbers(struct HLL *hll, uint32_t from, uint32_t to) {
+  for (uint64_t ii = from; ii < to; ++ii) {
+    // splitmix64 finalizer, the reducers add well mixed value hashes too
+    uint64_t h = ii * 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    hll_add_hash(hll, (uint32_t)(h ^ (h >> 31)));
+  }
+}
+
+static int testSparse() {
+  struct HLL hll, dense;
+  hll_init(&hll, 10);
+  hll_init(&dense, 10);
+  hll_densify(&dense);
+
+  // a few values stay sparse, and estimate like the dense registers
+  addNumbers(&hll, 0, 100);
+  addNumbers(&dense, 0, 100);
+  ASSERT(hll.registers == NULL);
+  ASSERT(hll.sparse_len > 0);
+  ASSERT_EQUAL(hll_count(&dense), hll_count(&hll));
+
+  // and switch to dense registers once they are smaller
+  addNumbers(&hll, 100, 10000);
+  addNumbers(&dense, 100, 10000);
+  ASSERT(hll.registers != NULL);
+  ASSERT(hll.sparse == NULL);
+  ASSERT(!memcmp(hll.registers, dense.registers, hll.size));
+  ASSERT(fabs(hll_count(&hll) - 10000) < 10000 * 0.1);
+
+  hll_destroy(&hll);
+  hll_destroy(&dense);
+  return 0;
+}
+
+static int testMerge() {
+  struct HLL all, a, b, c;
+  hll_init(&all, 10);
+  hll_init(&a, 10);
+  hll_init(&b, 10);
+  hll_init(&c, 10);
+  addNumbers(&all, 0, 5050);
+  addNumbers(&a, 0, 50);      // sparse
+  addNumbers(&b, 50, 5000);   // dense
+  addNumbers(&c, 5000, 5050);  // sparse
+
+  // sparse into sparse, dense into sparse, sparse into dense
+  ASSERT_EQUAL(0, hll_merge(&a, &c));
+  ASSERT(a.registers == NULL);
+  ASSERT_EQUAL(0, hll_merge(&a, &b));
+  ASSERT_EQUAL(0, hll_merge(&b, &a));
+  hll_densify(&all);
+  ASSERT(!memcmp(all.registers, a.registers, all.size));
+  ASSERT(!memcmp(all.registers, b.registers, all.size));
+
+  // loading the registers gives the same counter
+  struct HLL loaded;
+  ASSERT_EQUAL(0, hll_load(&loaded, all.registers, all.size));
+  ASSERT_EQUAL(hll_count(&all), hll_count(&loaded));
+
+  struct HLL other;
+  hll_init(&other, 8);
+  ASSERT(hll_merge(&a, &other) != 0);
+
+  hll_destroy(&all);
+  hll_destroy(&a);
+  hll_destroy(&b);
+  hll_destroy(&c);
+  hll_destroy(&loaded);
+  hll_destroy(&other);
+  return 0;
+}
+
+TEST_MAIN({
+  RMUTil_InitAlloc();
+  TESTFUNC(testSparse);
+  TESTFUNC(testMerge);
+})
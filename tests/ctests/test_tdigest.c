@@ -0,0 +1,121 @@
+#include "src/util/tdigest.h"
+#include "src/rmalloc.h"
+#include "rmutil/alloc.h"
+#include "test_util.h"
+
+#include <stdint.h>
+#include <assert.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+
+static double *input;
+static double *sorted;
+static size_t numInput;
+
+static int cmpDoubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+/* Check the estimate against the exact value by rank: the estimate must fall
+ * between the values whose ranks are within `rankErr` of the expected rank */
+static int checkQuantile(TDigest *td, double q, double rankErr) {
+  double est = TD_Quantile(td, q);
+  double lo = (q - rankErr) * numInput, hi = (q + rankErr) * numInput;
+  size_t ilo = lo < 0 ? 0 : (size_t)lo;
+  size_t ihi = hi >= numInput ? numInput - 1 : (size_t)hi;
+  if (est < sorted[ilo] || est > sorted[ihi]) {
+    FAIL("q=%g: %g not in [%g, %g]", q, est, sorted[ilo], sorted[ihi]);
+  }
+  return 0;
+}
+
+static int checkAll(TDigest *td) {
+  ASSERT_EQUAL(numInput, TD_GetCount(td));
+  ASSERT_EQUAL(sorted[0], TD_Quantile(td, 0));
+  ASSERT_EQUAL(sorted[numInput - 1], TD_Quantile(td, 1));
+  double qs[] = {0.001, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 0.999};
+  for (size_t ii = 0; ii < sizeof(qs) / sizeof(qs[0]); ++ii) {
+    if (checkQuantile(td, qs[ii], 0.01)) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static int testBasic() {
+  TDigest *td = NewTDigest(100);
+  for (size_t ii = 0; ii < numInput; ++ii) {
+    TD_Insert(td, input[ii]);
+  }
+  int rc = checkAll(td);
+  TD_Free(td);
+  return rc;
+}
+
+static int testSmall() {
+  TDigest *td = NewTDigest(100);
+  ASSERT_EQUAL(0, TD_Quantile(td, 0.5));
+  for (int ii = 1; ii <= 100; ++ii) {
+    TD_Insert(td, ii);
+  }
+  // few enough values to be exact
+  ASSERT_EQUAL(50.5, TD_Quantile(td, 0.5));
+  ASSERT_EQUAL(1, TD_Quantile(td, 0));
+  ASSERT_EQUAL(100, TD_Quantile(td, 1));
+  TD_Free(td);
+  return 0;
+}
+
+static int testMerge() {
+  // split the input between several digests, as shards would
+  const size_t nparts = 5;
+  TDigest *parts[nparts];
+  for (size_t ii = 0; ii < nparts; ++ii) {
+    parts[ii] = NewTDigest(100);
+  }
+  for (size_t ii = 0; ii < numInput; ++ii) {
+    TD_Insert(parts[ii % nparts], input[ii]);
+  }
+
+  TDigest *merged = NewTDigest(100);
+  for (size_t ii = 0; ii < nparts; ++ii) {
+    // go through the serialized form
+    size_t len;
+    char *s = TD_Serialize(parts[ii], &len);
+    TDigest *loaded = TD_Deserialize(s, len);
+    ASSERT(loaded != NULL);
+    ASSERT(TD_Deserialize(s, len - 1) == NULL);
+    ASSERT_EQUAL(TD_Quantile(parts[ii], 0.5), TD_Quantile(loaded, 0.5));
+    TD_Merge(merged, loaded);
+    rm_free(s);
+    TD_Free(loaded);
+    TD_Free(parts[ii]);
+  }
+  int rc = checkAll(merged);
+  TD_Free(merged);
+  return rc;
+}
+
+TEST_MAIN({
+  RMUTil_InitAlloc();
+
+  // a skewed distribution, with a long tail
+  numInput = 100000;
+  input = malloc(numInput * sizeof(*input));
+  srand(1337);
+  for (size_t ii = 0; ii < numInput; ++ii) {
+    input[ii] = -log((rand() + 1.0) / ((double)RAND_MAX + 2)) * 100;
+  }
+  sorted = malloc(numInput * sizeof(*sorted));
+  memcpy(sorted, input, numInput * sizeof(*sorted));
+  qsort(sorted, numInput, sizeof(*sorted), cmpDoubles);
+
+  TESTFUNC(testSmall);
+  TESTFUNC(testBasic);
+  TESTFUNC(testMerge);
+
+  free(sorted);
+  free(input);
+})
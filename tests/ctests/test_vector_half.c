@@ -0,0 +1,74 @@
+#include "src/vector_half.h"
+#include "rmutil/alloc.h"
+#include "test_util.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define NUM_HALVES 65536
+
+static float reference16(uint16_t h) {
+  int exp = (h >> 10) & 0x1f, mant = h & 0x3ff;
+  double v;
+  if (exp == 0x1f) {
+    v = mant ? NAN : INFINITY;
+  } else if (exp) {
+    v = ldexp(1024 + mant, exp - 25);
+  } else {
+    v = ldexp(mant, -24);
+  }
+  return (h & 0x8000) ? -v : v;
+}
+
+/* Every FLOAT16 value converts exactly, through the vectorized and the scalar tails */
+static int testFloat16() {
+  uint16_t halves[NUM_HALVES + 3];
+  for (size_t i = 0; i < NUM_HALVES; i++) {
+    halves[i] = i;
+  }
+  halves[NUM_HALVES] = 0x3c00;      // 1
+  halves[NUM_HALVES + 1] = 0xc000;  // -2
+  halves[NUM_HALVES + 2] = 0x0001;  // the smallest subnormal
+  float out[NUM_HALVES + 3];
+  // start unaligned, and end with a partial block
+  VectorHalf_ToFloat32(VectorHalf_Float16, (char *)halves + 2, out, NUM_HALVES + 2);
+  for (size_t i = 0; i < NUM_HALVES + 2; i++) {
+    float expected = reference16(halves[i + 1]);
+    if (isnan(expected)) {
+      ASSERT(isnan(out[i]));
+    } else {
+      ASSERT_EQUAL(expected, out[i]);
+    }
+  }
+  ASSERT_EQUAL(1, out[NUM_HALVES - 1]);
+  ASSERT_EQUAL(-2, out[NUM_HALVES]);
+  ASSERT_EQUAL(ldexp(1, -24), out[NUM_HALVES + 1]);
+  return 0;
+}
+
+static int testBFloat16() {
+  float values[] = {0, -0.0, 1, -2.5, 3.140625, 1e30, -1e-30, INFINITY};
+  size_t n = sizeof(values) / sizeof(values[0]);
+  uint16_t halves[n];
+  for (size_t i = 0; i < n; i++) {
+    uint32_t bits;
+    memcpy(&bits, values + i, sizeof(bits));
+    halves[i] = bits >> 16;
+  }
+  float out[n];
+  VectorHalf_ToFloat32(VectorHalf_BFloat16, halves, out, n);
+  for (size_t i = 0; i < n; i++) {
+    // truncated to the 8 upper bits of the mantissa
+    ASSERT(out[i] == values[i] || fabs(out[i] - values[i]) <= fabs(values[i]) / 128);
+  }
+  ASSERT_EQUAL(3.140625, out[4]);
+  ASSERT(isinf(out[7]));
+  return 0;
+}
+
+TEST_MAIN({
+  RMUTil_InitAlloc();
+  TESTFUNC(testFloat16);
+  TESTFUNC(testBFloat16);
+})
@@ -0,0 +1,140 @@
+#include "src/vector_quant.h"
+#include "src/list_reader.h"
+#include "src/rmalloc.h"
+#include "rmutil/alloc.h"
+#include "test_util.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define DIM 32
+#define NUM_VECTORS 2000
+
+static float vectors[NUM_VECTORS + 1][DIM];
+
+static double exactDistance(VecSimMetric metric, const float *a, const float *b) {
+  double sum = 0, na = 0, nb = 0;
+  for (size_t i = 0; i < DIM; i++) {
+    sum += metric == VecSimMetric_L2 ? (a[i] - b[i]) * (a[i] - b[i]) : a[i] * b[i];
+    na += a[i] * a[i];
+    nb += b[i] * b[i];
+  }
+  if (metric == VecSimMetric_L2) {
+    return sum;
+  }
+  return 1 - (metric == VecSimMetric_Cosine ? sum / sqrt(na * nb) : sum);
+}
+
+static int cmpDoubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+/* The approximate distances are close to the exact ones, and the results are close to the exact
+ * K nearest */
+static int checkMetric(VecSimMetric metric) {
+  QuantizedVectors *qv = NewQuantizedVectors(VecSimType_FLOAT32, DIM, metric);
+  for (t_docId id = 1; id <= NUM_VECTORS; id++) {
+    ASSERT_EQUAL(0, QuantizedVectors_Add(qv, vectors[id], sizeof(vectors[id]), id));
+  }
+  ASSERT_EQUAL(NUM_VECTORS, QuantizedVectors_Size(qv));
+  ASSERT(QuantizedVectors_MemUsage(qv) < NUM_VECTORS * sizeof(vectors[0]) / 2);
+
+  const float *query = vectors[0];
+  size_t k = 10, n;
+  ScoredDocId *res = QuantizedVectors_Query(qv, query, sizeof(vectors[0]), k, INFINITY, NULL, &n);
+  ASSERT_EQUAL(k, n);
+
+  double *exact = malloc(NUM_VECTORS * sizeof(*exact));
+  for (t_docId id = 1; id <= NUM_VECTORS; id++) {
+    exact[id - 1] = exactDistance(metric, query, vectors[id]);
+  }
+  for (size_t i = 0; i < n; i++) {
+    double d = exact[res[i].docId - 1];
+    ASSERT(fabs(res[i].score - d) < 0.05 * (fabs(d) + 1));
+  }
+  qsort(exact, NUM_VECTORS, sizeof(*exact), cmpDoubles);
+  for (size_t i = 0; i < n; i++) {
+    // within the 3K exact nearest
+    ASSERT(exactDistance(metric, query, vectors[res[i].docId]) <= exact[3 * k]);
+  }
+  free(exact);
+  rm_free(res);
+
+  ASSERT(QuantizedVectors_Query(qv, query, sizeof(vectors[0]) - 1, k, INFINITY, NULL, &n) == NULL);
+  ASSERT_EQUAL(-1, QuantizedVectors_Add(qv, query, 3, NUM_VECTORS + 1));
+  QuantizedVectors_Free(qv);
+  return 0;
+}
+
+static int testMetrics() {
+  if (checkMetric(VecSimMetric_L2) || checkMetric(VecSimMetric_IP) ||
+      checkMetric(VecSimMetric_Cosine)) {
+    return -1;
+  }
+  return 0;
+}
+
+static int testDeleteAndFilter() {
+  QuantizedVectors *qv = NewQuantizedVectors(VecSimType_FLOAT32, DIM, VecSimMetric_L2);
+  // out of order ids are still kept sorted
+  for (t_docId id = NUM_VECTORS; id >= 1; id--) {
+    ASSERT_EQUAL(0, QuantizedVectors_Add(qv, vectors[id], sizeof(vectors[id]), id));
+  }
+  // delete the odd ids, which compacts the vectors
+  for (t_docId id = 1; id <= NUM_VECTORS; id += 2) {
+    QuantizedVectors_Delete(qv, id);
+  }
+  QuantizedVectors_Delete(qv, 1);
+  ASSERT_EQUAL(NUM_VECTORS / 2, QuantizedVectors_Size(qv));
+
+  size_t n;
+  ScoredDocId *res =
+      QuantizedVectors_Query(qv, vectors[0], sizeof(vectors[0]), SIZE_MAX, INFINITY, NULL, &n);
+  ASSERT_EQUAL(NUM_VECTORS / 2, n);
+  for (size_t i = 0; i < n; i++) {
+    ASSERT(res[i].docId % 2 == 0);
+  }
+  rm_free(res);
+
+  // re-adding a deleted id revives it
+  ASSERT_EQUAL(0, QuantizedVectors_Add(qv, vectors[1], sizeof(vectors[1]), 1));
+  ASSERT_EQUAL(NUM_VECTORS / 2 + 1, QuantizedVectors_Size(qv));
+
+  // filter by every third id, and a radius
+  size_t numFilter = NUM_VECTORS / 3;
+  ScoredDocId *ids = rm_malloc(numFilter * sizeof(*ids));
+  for (size_t i = 0; i < numFilter; i++) {
+    ids[i] = (ScoredDocId){.docId = 3 * (i + 1)};
+  }
+  IndexIterator *filter = NewScoredListIterator(ids, numFilter);
+  double radius = 4;
+  res = QuantizedVectors_Query(qv, vectors[0], sizeof(vectors[0]), SIZE_MAX, radius, filter, &n);
+  filter->Free(filter);
+  size_t expected = 0;
+  for (t_docId id = 6; id <= NUM_VECTORS; id += 6) {
+    expected += exactDistance(VecSimMetric_L2, vectors[0], vectors[id]) <= radius;
+  }
+  ASSERT(n > 0);
+  ASSERT(fabs((double)n - expected) <= expected * 0.1 + 1);
+  for (size_t i = 0; i < n; i++) {
+    ASSERT(res[i].docId % 6 == 0);
+    ASSERT(res[i].score <= radius);
+  }
+  rm_free(res);
+  QuantizedVectors_Free(qv);
+  return 0;
+}
+
+TEST_MAIN({
+  RMUTil_InitAlloc();
+  srand(1337);
+  for (size_t ii = 0; ii <= NUM_VECTORS; ++ii) {
+    for (size_t jj = 0; jj < DIM; ++jj) {
+      vectors[ii][jj] = (float)rand() / RAND_MAX - 0.5;
+    }
+  }
+  TESTFUNC(testMetrics);
+  TESTFUNC(testDeleteAndFilter);
+})
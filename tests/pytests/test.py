@@ -769,6 +769,81 @@ def testSortBy(env):
         env.assertListEqual([100L, 'doc99', '$hello099 world', 'doc98', '$hello098 world', 'doc97', '$hello097 world', 'doc96',
                               '$hello096 world', 'doc95', '$hello095 world'], res)
 
+def testSortByWithoutCount(env):
+    # WITHOUTCOUNT reads the matches by the order of the numeric index, the results must not change
+    conn = getConnectionByEnv(env)
+    env.cmd('ft.create', 'idx', 'ON', 'HASH', 'schema', 'foo', 'text', 'tag', 'tag', 'bar', 'numeric', 'sortable')
+    N = 10000
+    for i in range(N):
+        # 'w3' and the tag 't2' match only some of the documents of each numeric range
+        foo, tag = 'hello world w%d' % (i % 13), 't%d' % (i % 5)
+        if i % 10 == 0:
+            conn.execute_command('hset', 'doc%d' % i, 'foo', foo, 'tag', tag)
+        else:
+            conn.execute_command('hset', 'doc%d' % i, 'foo', foo, 'tag', tag, 'bar', (i * 7919) % N)
+    for i in range(0, N, 7):
+        conn.execute_command('del', 'doc%d' % i)
+
+    for query in (['hello'], ['*'], ['hello @bar:[100 5000]'], ['hello', 'filter', 'bar', 200, 300],
+                  ['w3'], ['@tag:{t2}'], ['w3 @bar:[100 5000]'], ['w3|w4'], ['-w3']):
+        for order in ('asc', 'desc'):
+            for limit in ([0, 10], [35, 10], [0, 1000], [N, 10]):
+                args = ['ft.search', 'idx'] + query + ['nocontent', 'sortby', 'bar', order, 'limit'] + limit
+                expected = env.cmd(*args)
+                res = env.cmd(*(args + ['withoutcount']))
+                env.assertEqual(expected[1:], res[1:])
+                env.assertLessEqual(res[0], expected[0])
+
+def testSearchAfter(env):
+    # paging with SEARCHAFTER returns the same results as a single page
+    conn = getConnectionByEnv(env)
+    env.cmd('ft.create', 'idx', 'ON', 'HASH', 'schema', 'foo', 'text', 'sortable', 'bar', 'numeric', 'sortable')
+    N = 1000
+    for i in range(N):
+        if i % 10 == 0:
+            conn.execute_command('hset', 'doc%d' % i, 'foo', 'hello w%d' % (i % 37))
+        else:
+            conn.execute_command('hset', 'doc%d' % i, 'foo', 'hello w%d' % (i % 37), 'bar', (i * 7) % 100)
+
+    for order in (['bar', 'asc'], ['bar', 'desc'], ['foo', 'asc'], ['foo', 'desc']):
+        args = ['ft.search', 'idx', 'hello', 'nocontent', 'withsortkeys', 'sortby'] + order
+        expected = env.cmd(*(args + ['limit', 0, N]))
+        res = env.cmd(*(args + ['limit', 0, 17]))
+        paged = res[1:]
+        while len(res) > 1:
+            # continue after the last document, with its sort key
+            key, sortkey = res[-2:]
+            res = env.cmd(*(args + ['limit', 0, 17, 'searchafter', 2, key, sortkey or 'null']))
+            paged += res[1:]
+        env.assertEqual(expected[1:], paged)
+
+    env.expect('ft.search', 'idx', 'hello', 'sortby', 'bar', 'searchafter', 3, 'doc1', '#7', '#8').error() \
+        .contains('SEARCHAFTER requires a sort value for each sort key')
+    env.expect('ft.search', 'idx', 'hello', 'searchafter', 1, 'doc1').error() \
+        .contains('SEARCHAFTER requires a document key and its sort values')
+
+def testCountOnly(env):
+    # LIMIT 0 0 counts the matches without building results, and should agree with a full search
+    conn = getConnectionByEnv(env)
+    env.cmd('ft.create', 'idx', 'ON', 'HASH', 'schema', 't', 'text', 'g', 'tag', 'n', 'numeric')
+    N = 300
+    for i in range(N):
+        conn.execute_command('hset', 'doc%d' % i, 't', 'alpha beta' if i % 2 else 'alpha gamma',
+                             'g', 'x' if i % 3 else 'y', 'n', i)
+
+    queries = ['*', 'alpha', 'beta', '@t:beta', 'alpha gamma', 'beta|gamma', '-beta', '@g:{x}',
+               '@n:[10 200]', '@g:{y} @n:[0 50]', 'nosuchterm']
+    for deleted in (False, True):
+        if deleted:
+            for i in range(0, N, 7):
+                conn.execute_command('del', 'doc%d' % i)
+        for q in queries:
+            # VERBATIM keeps single terms unexpanded
+            for args in ([q], [q, 'verbatim']):
+                res = env.cmd('ft.search', 'idx', *(args + ['nocontent', 'limit', 0, N]))
+                env.assertEqual([len(res) - 1], env.cmd('ft.search', 'idx', *(args + ['limit', 0, 0])),
+                                message=q)
+
 def testSortByWithoutSortable(env):
     r = env
     env.assertOk(r.execute_command(
@@ -112,6 +112,19 @@ class TestAggregate():
         row = to_dict(res[0])
         self.env.assertEqual(1484, int(row['count_distinct(title)']))
 
+        # exact up to the limit, then estimated
+        for limit, exact in (('10000', True), ('100', False)):
+            cmd = ['FT.AGGREGATE', 'games', '*',
+                   'GROUPBY', '1', '@brand',
+                   'REDUCE', 'COUNT_DISTINCT', '2', '@title', limit, 'AS', 'count_distinct(title)',
+                   'REDUCE', 'COUNT', '0'
+                   ]
+            row = to_dict(self.env.cmd(*cmd)[1])
+            if exact:
+                self.env.assertEqual(1484, int(row['count_distinct(title)']))
+            else:
+                self.env.assertAlmostEqual(1484, int(row['count_distinct(title)']), delta=50)
+
         cmd = ['FT.AGGREGATE', 'games', '*',
                'GROUPBY', '1', '@brand',
                'REDUCE', 'COUNT_DISTINCTISH', '1', '@title', 'AS', 'count_distinctish(title)',
@@ -756,3 +769,24 @@ def testLoadPosition(env):
                                            'APPLY', '@t2', 'AS', 'load_error',
                                            'LOAD', '1', 't2')
     env.assertContains('Value was not found in result', str(res[1]))
+
+def testQuantileMergedDigests(env):
+    # on a cluster, each shard sends the t-digest of its values, and the coordinator merges them
+    conn = getConnectionByEnv(env)
+    env.execute_command('ft.create', 'idx', 'SCHEMA', 'g', 'TAG', 'n', 'NUMERIC')
+    for i in range(1, 1001):
+        conn.execute_command('hset', 'doc%d' % i, 'g', 'odd' if i % 2 else 'even', 'n', i)
+
+    res = env.cmd('ft.aggregate', 'idx', '*', 'GROUPBY', '1', '@g',
+                  'REDUCE', 'QUANTILE', '2', '@n', '0', 'AS', 'q0',
+                  'REDUCE', 'QUANTILE', '2', '@n', '0.5', 'AS', 'q50',
+                  'REDUCE', 'QUANTILE', '2', '@n', '0.99', 'AS', 'q99',
+                  'REDUCE', 'QUANTILE', '2', '@n', '1', 'AS', 'q100',
+                  'SORTBY', '2', '@g', 'ASC')
+    even, odd = to_dict(res[1]), to_dict(res[2])
+    env.assertEqual([float(even['q0']), float(even['q100'])], [2, 1000])
+    env.assertEqual([float(odd['q0']), float(odd['q100'])], [1, 999])
+    env.assertAlmostEqual(float(even['q50']), 501, delta=2)
+    env.assertAlmostEqual(float(odd['q50']), 500, delta=2)
+    env.assertAlmostEqual(float(even['q99']), 990, delta=4)
+    env.assertAlmostEqual(float(odd['q99']), 989, delta=4)
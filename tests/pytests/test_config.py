@@ -27,6 +27,7 @@ def testGetConfigOptions(env):
     assert env.expect('ft.config', 'get', 'TIMEOUT').res[0][0] =='TIMEOUT'
     assert env.expect('ft.config', 'get', 'INDEX_THREADS').res[0][0] =='INDEX_THREADS'
     assert env.expect('ft.config', 'get', 'SEARCH_THREADS').res[0][0] =='SEARCH_THREADS'
+    assert env.expect('ft.config', 'get', 'VECSIM_THREADS').res[0][0] =='VECSIM_THREADS'
     assert env.expect('ft.config', 'get', 'FRISOINI').res[0][0] =='FRISOINI'
     assert env.expect('ft.config', 'get', 'MAXSEARCHRESULTS').res[0][0] =='MAXSEARCHRESULTS'
     assert env.expect('ft.config', 'get', 'MAXAGGREGATERESULTS').res[0][0] =='MAXAGGREGATERESULTS'
@@ -138,6 +139,7 @@ def testInitConfig(env):
     test_arg_num('MAXPREFIXEXPANSIONS', 5)
     test_arg_num('INDEX_THREADS', 3)
     test_arg_num('SEARCH_THREADS', 3)
+    test_arg_num('VECSIM_THREADS', 3)
     test_arg_num('GCSCANSIZE', 3)
     test_arg_num('MIN_PHONETIC_TERM_LEN', 3)
     test_arg_num('FORK_GC_RUN_INTERVAL', 3)
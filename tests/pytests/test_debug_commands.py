@@ -148,11 +148,11 @@ class TestDebugCommands(object):
 
     def testInvertedIndexSummary(self):
         self.env.expect('FT.DEBUG', 'invidx_summary', 'idx', 'meir').equal(['numDocs', 1L, 'lastId', 1L, 'flags',
-                                                                            83L, 'numberOfBlocks', 1L, 'blocks',
+                                                                            65619L, 'numberOfBlocks', 1L, 'blocks',
                                                                             ['firstId', 1L, 'lastId', 1L, 'numDocs', 1L]])
 
         self.env.expect('FT.DEBUG', 'INVIDX_SUMMARY', 'idx', 'meir').equal(['numDocs', 1L, 'lastId', 1L, 'flags',
-                                                                            83L, 'numberOfBlocks', 1L, 'blocks',
+                                                                            65619L, 'numberOfBlocks', 1L, 'blocks',
                                                                             ['firstId', 1L, 'lastId', 1L, 'numDocs', 1L]])
 
     def testUnexistsInvertedIndexSummary(self):
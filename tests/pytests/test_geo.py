@@ -1,5 +1,6 @@
 from RLTest import Env
 from common import getConnectionByEnv
+import math
 
 def testGeoHset(env):
   conn = getConnectionByEnv(env)
@@ -120,3 +121,68 @@ def testGeoDistanceFile(env):
               'APPLY', 'geodistance(@location,-0.15036,51.50566)', 'AS', 'distance',
               'GROUPBY', '1', '@distance',
               'SORTBY', 2, '@distance', 'ASC').equal(res)
+
+def testGeoShapes(env):
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE idx SCHEMA g GEO').ok()
+  points = {'paris': '2.3522,48.8566', 'london': '-0.1276,51.5072', 'berlin': '13.4050,52.5200',
+            'suva': '178.4419,-18.1416', 'apia': '-171.7514,-13.8333'}
+  for key, point in points.items():
+    conn.execute_command('HSET', key, 'g', point)
+
+  def search(*args):
+    res = env.cmd('FT.SEARCH', 'idx', '*', 'NOCONTENT', 'GEOFILTER', 'g', *args)
+    return sorted(res[1:])
+
+  env.assertEqual(search('BOX', -1, 48, 3, 52), ['london', 'paris'])
+  # a box crossing the antimeridian
+  env.assertEqual(search('BOX', 170, -20, -170, -10), ['apia', 'suva'])
+  # a triangle around paris and berlin, whose bounding box also holds london
+  env.assertEqual(search('POLYGON', 3, -1, 47, 16, 50, 12, 56), ['berlin', 'paris'])
+  env.assertEqual(search(-0.1276, 51.5072, 1000, 'km'), ['berlin', 'london', 'paris'])
+  env.assertEqual(search(179, -15, 1500, 'km'), ['apia', 'suva'])
+
+  env.expect('FT.SEARCH', 'idx', '*', 'GEOFILTER', 'g', 'BOX', 1, 48, 3).error()
+  env.expect('FT.SEARCH', 'idx', '*', 'GEOFILTER', 'g', 'BOX', 1, 52, 3, 48).error().contains('Invalid GeoFilter lat/lon')
+  env.expect('FT.SEARCH', 'idx', '*', 'GEOFILTER', 'g', 'POLYGON', 2, 1, 48, 15, 52).error().contains('at least 3 points')
+  env.expect('FT.SEARCH', 'idx', '*', 'GEOFILTER', 'g', 'POLYGON', 3, 1, 48, 15, 52, 14, 'lat').error()
+  env.expect('FT.SEARCH', 'idx', '*', 'GEOFILTER', 'g', 'POLYGON', 2147483649, 1, 1).error().contains('at least 3 points')
+  env.expect('FT.SEARCH', 'idx', '*', 'GEOFILTER', 'g', 'POLYGON', 4, 1, 48, 15, 52, 14, 56).error().contains('at least 3 points')
+
+def testGeoNearest(env):
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE idx SCHEMA g GEO t TAG').ok()
+  points = {'paris': (2.3522, 48.8566), 'london': (-0.1276, 51.5072), 'berlin': (13.4050, 52.5200),
+            'suva': (178.4419, -18.1416), 'apia': (-171.7514, -13.8333)}
+  for key, (lon, lat) in points.items():
+    conn.execute_command('HSET', key, 'g', '%f,%f' % (lon, lat), 't', 'pacific' if lon > 170 or lon < -170 else 'europe')
+
+  def distance(key, lon, lat):
+    lon1, lat1, lon2, lat2 = map(math.radians, (lon, lat) + points[key])
+    a = math.sin((lat2 - lat1) / 2) ** 2 + math.cos(lat1) * math.cos(lat2) * math.sin((lon2 - lon1) / 2) ** 2
+    return 2 * 6372.797560856 * math.asin(math.sqrt(a))
+
+  def nearest(query, lon, lat, k):
+    res = env.cmd('FT.SEARCH', 'idx', query, 'GEOFILTER', 'g', 'NEAREST', lon, lat, k, 'km',
+                  'SORTBY', 'g_distance')
+    keys = res[1::2]
+    for key, fields in zip(keys, res[2::2]):
+      fields = dict(zip(fields[::2], fields[1::2]))
+      env.assertAlmostEqual(float(fields['g_distance']), distance(key, lon, lat), delta=0.01)
+    return keys
+
+  # the nearest first, however far
+  env.assertEqual(nearest('*', 2.3522, 48.8566, 3), ['paris', 'london', 'berlin'])
+  env.assertEqual(nearest('*', 2.3522, 48.8566, 10), ['paris', 'london', 'berlin', 'apia', 'suva'])
+  # across the antimeridian
+  env.assertEqual(nearest('*', 179.9, -15, 2), ['suva', 'apia'])
+  # the nearest documents of the query, rather than the nearest overall
+  env.assertEqual(nearest('@t:{pacific}', 2.3522, 48.8566, 1), ['apia'])
+  env.assertEqual(nearest('@t:{europe}', 179.9, -15, 2), ['berlin', 'paris'])
+  # the documents a NOT filter excludes are not counted among the nearest
+  env.assertEqual(nearest('-@t:{pacific}', 179.9, -15, 2), ['berlin', 'paris'])
+  env.assertEqual(nearest('-@t:{europe}', 2.3522, 48.8566, 1), ['apia'])
+
+  env.expect('FT.SEARCH', 'idx', '*', 'GEOFILTER', 'g', 'NEAREST', 2.35, 48.85, 0, 'km').error()
+  env.expect('FT.SEARCH', 'idx', '*', 'GEOFILTER', 'g', 'NEAREST', 2.35, 48.85, 3, 'lightyears').error().contains('Unknown distance unit')
+  env.expect('FT.SEARCH', 'idx', '*', 'GEOFILTER', 'g', 'NEAREST', 2.35, 95, 3, 'km').error().contains('Invalid GeoFilter lat/lon')
@@ -204,7 +204,7 @@ def query_vector(env, idx, query_vec):
     conn = getConnectionByEnv(env)
     base64_vector = base64.b64encode(query_vec).decode('ascii')
     base64_vector_escaped = base64_vector.replace("=", r"\=").replace("/", r"\/").replace("+", r"\+")
-    return conn.execute_command('FT.SEARCH', idx, '@vector:[' + base64_vector_escaped + ' RANGE 5]',
+    return conn.execute_command('FT.SEARCH', idx, '@vector:[' + base64_vector_escaped + ' TOPK 5]',
                                 'SORTBY', 'vector_score', 'ASC', 'RETURN', 1, 'vector_score', 'LIMIT', 0, 5)
 
 def testDelReuseLarge(env):
@@ -327,3 +327,323 @@ def test_with_fields(env):
                     'NOCONTENT')
     env.assertEqual(res[1::2], res_nocontent[1:])
     env.assertEqual('t', res[2][2])
+
+def test_filtered_topk(env):
+    # TOPK of a filtered query returns the K closest vectors among the filtered documents,
+    # for selective filters (distances computed per document) and wide ones (index queries)
+    conn = getConnectionByEnv(env)
+    dimension = 16
+    qty = 2000
+    k = 10
+
+    def tag_of(i):
+        return 'rare' if i % 100 == 0 else 'common' if i % 3 == 0 else 'other'
+
+    conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'FLAT', '6', 'TYPE', 'FLOAT32',
+                         'DIM', dimension, 'DISTANCE_METRIC', 'L2', 'g', 'TAG')
+    data = np.float32(np.random.random((qty, dimension)))
+    for i, vector in enumerate(data):
+        conn.execute_command('HSET', i, 'v', vector.tobytes(), 'g', tag_of(i))
+
+    query_data = np.float32(np.random.random(dimension))
+    dists = ((data - query_data) ** 2).sum(axis=1)
+    # a NOT filter must not count the documents it excludes among the K closest
+    for query, passes in (('@g:{rare}', lambda i: tag_of(i) == 'rare'),
+                          ('@g:{common}', lambda i: tag_of(i) == 'common'),
+                          ('-@g:{other}', lambda i: tag_of(i) != 'other')):
+        ids = [i for i in range(qty) if passes(i)]
+        expected = sorted(ids, key=lambda i: dists[i])[:k]
+        res = env.cmd('FT.SEARCH', 'idx', '%s @v:[$vec_param TOPK %d]' % (query, k),
+                      'SORTBY', 'v_score', 'PARAMS', 2, 'vec_param', query_data.tobytes(), 'NOCONTENT')
+        env.assertEqual(res[0], k)
+        env.assertEqual(res[1:], [str(i) for i in expected])
+
+def test_range(env):
+    conn = getConnectionByEnv(env)
+    dimension = 4
+    qty = 1000
+
+    for algo in ['FLAT', 'HNSW']:
+        conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', algo, '6', 'TYPE', 'FLOAT32',
+                             'DIM', dimension, 'DISTANCE_METRIC', 'L2', 't', 'TEXT')
+        data = np.float32(np.random.random((qty, dimension)))
+        for i, vector in enumerate(data):
+            conn.execute_command('HSET', i, 'v', vector.tobytes(), 't', 'even' if i % 2 == 0 else 'odd')
+
+        query_data = np.float32(np.random.random(dimension))
+        dists = ((data - query_data) ** 2).sum(axis=1)
+        for radius in [0, 0.05, 0.2]:
+            expected = sorted([i for i in range(qty) if dists[i] <= radius], key=lambda i: dists[i])
+            res = env.cmd('FT.SEARCH', 'idx', '@v:[$vec_param RANGE %s]' % radius, 'SORTBY', 'v_score',
+                          'PARAMS', 2, 'vec_param', query_data.tobytes(), 'NOCONTENT', 'LIMIT', 0, qty)
+            env.assertEqual(res[1:], [str(i) for i in expected])
+
+            # composes with other filters
+            res = env.cmd('FT.SEARCH', 'idx', 'even @v:[$vec_param RANGE %s]' % radius, 'SORTBY', 'v_score',
+                          'PARAMS', 2, 'vec_param', query_data.tobytes(), 'NOCONTENT', 'LIMIT', 0, qty)
+            env.assertEqual(res[1:], [str(i) for i in expected if i % 2 == 0])
+
+        env.expect('FT.SEARCH', 'idx', '@v:[$vec_param RANGE -1]', 'PARAMS', 2, 'vec_param',
+                   query_data.tobytes()).error().contains('Invalid Vector similarity radius')
+        conn.execute_command('FT.DROPINDEX', 'idx', 'DD')
+
+def test_quantized(env):
+    conn = getConnectionByEnv(env)
+    dimension = 16
+    qty = 1000
+    k = 10
+
+    conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'FLAT', '8', 'TYPE', 'FLOAT32',
+                         'DIM', dimension, 'DISTANCE_METRIC', 'L2', 'QUANTIZE', 'INT8', 't', 'TEXT')
+    info = to_dict(env.cmd('FT.INFO', 'idx'))
+    env.assertContains('QUANTIZE', info['attributes'][0])
+    data = np.float32(np.random.random((qty, dimension)))
+    for i, vector in enumerate(data):
+        conn.execute_command('HSET', i, 'v', vector.tobytes(), 't', 'even' if i % 2 == 0 else 'odd')
+    # FT.INFO reports the quantized copy, which takes about one byte per dimension
+    info = to_dict(env.cmd('FT.INFO', 'idx'))
+    env.assertGreater(float(info['quantized_vectors_sz_mb']) * 0x100000, qty * dimension)
+    env.assertLess(float(info['quantized_vectors_sz_mb']) * 0x100000, qty * dimension * 4)
+
+    query_data = np.float32(np.random.random(dimension))
+    dists = ((data - query_data) ** 2).sum(axis=1)
+    expected = sorted(range(qty), key=lambda i: dists[i])
+
+    # the quantized distances are close, and reranking recomputes them exactly
+    res = env.cmd('FT.SEARCH', 'idx', '@v:[$vec_param TOPK %d]' % k, 'SORTBY', 'v_score',
+                  'PARAMS', 2, 'vec_param', query_data.tobytes(), 'NOCONTENT')
+    env.assertEqual(res[0], k)
+    env.assertEqual(len(set(res[1:]) & set(str(i) for i in expected[:2 * k])), k)
+    res = env.cmd('FT.SEARCH', 'idx', '@v:[$vec_param TOPK %d]=>{$rerank: true}' % k, 'SORTBY', 'v_score',
+                  'PARAMS', 2, 'vec_param', query_data.tobytes(), 'NOCONTENT')
+    env.assertEqual(res[1:], [str(i) for i in expected[:k]])
+
+    res = env.cmd('FT.SEARCH', 'idx', 'even @v:[$vec_param TOPK %d]=>{$rerank: true}' % k, 'SORTBY', 'v_score',
+                  'PARAMS', 2, 'vec_param', query_data.tobytes(), 'NOCONTENT')
+    env.assertEqual(res[1:], [str(i) for i in expected if i % 2 == 0][:k])
+
+    # deleted documents are not returned
+    conn.execute_command('DEL', expected[0])
+    res = env.cmd('FT.SEARCH', 'idx', '@v:[$vec_param TOPK %d]=>{$rerank: true}' % k, 'SORTBY', 'v_score',
+                  'PARAMS', 2, 'vec_param', query_data.tobytes(), 'NOCONTENT')
+    env.assertEqual(res[1:], [str(i) for i in expected[1:k + 1]])
+    conn.execute_command('FT.DROPINDEX', 'idx', 'DD')
+
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'HNSW', '8', 'TYPE', 'FLOAT32', 'DIM', dimension,
+               'DISTANCE_METRIC', 'L2', 'QUANTIZE', 'INT8').error().contains('QUANTIZE is only supported')
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'FLAT', '8', 'TYPE', 'FLOAT32', 'DIM', dimension,
+               'DISTANCE_METRIC', 'L2', 'QUANTIZE', 'BIT').error()
+
+def test_batch(env):
+    conn = getConnectionByEnv(env)
+    dimension = 8
+    qty = 1000
+    k = 5
+
+    conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'HNSW', '8', 'TYPE', 'FLOAT32',
+                         'DIM', dimension, 'DISTANCE_METRIC', 'L2', 'EF_RUNTIME', qty, 't', 'TEXT')
+    data = np.float32(np.random.random((qty, dimension)))
+    for i, vector in enumerate(data):
+        conn.execute_command('HSET', i, 'v', vector.tobytes(), 't', 'even' if i % 2 == 0 else 'odd')
+
+    queries = data[[0, 1, 500]]
+    blob = b''.join(q.tobytes() for q in queries)
+    for query, docs in (('@v:[$vec_param TOPK %d]' % k, range(qty)),
+                        ('even @v:[$vec_param TOPK %d]' % k, range(0, qty, 2))):
+        # the results of each query vector, without the documents closer to another query vector
+        dists = [((data - q) ** 2).sum(axis=1) for q in queries]
+        nearest = [set(sorted(docs, key=lambda i: d[i])[:k]) for d in dists]
+        expected = []
+        for qi, d in enumerate(dists):
+            group = [i for i in nearest[qi]
+                     if all(i not in nearest[qj] or (dists[qj][i], qj) > (d[i], qi)
+                            for qj in range(len(queries)) if qj != qi)]
+            expected += [(str(i), str(qi)) for i in sorted(group, key=lambda i: d[i])]
+
+        res = env.cmd('FT.SEARCH', 'idx', query + '=>{$batch: true}', 'SORTBY', 'v_score',
+                      'PARAMS', 2, 'vec_param', blob, 'LIMIT', 0, 100)
+        env.assertEqual(res[0], len(expected))
+        env.assertEqual([(res[i], to_dict(res[i + 1])['v_query']) for i in range(1, len(res), 2)],
+                        expected)
+
+    # a document is only returned with the closest query vector, so a query vector whose results
+    # are all closer to another one gets fewer than k results, here none
+    res = env.cmd('FT.SEARCH', 'idx', '@v:[$vec_param TOPK %d]=>{$batch: true}' % k, 'SORTBY', 'v_score',
+                  'PARAMS', 2, 'vec_param', queries[0].tobytes() * 2, 'LIMIT', 0, 100)
+    env.assertEqual(res[0], k)
+    env.assertEqual([to_dict(res[i + 1])['v_query'] for i in range(1, len(res), 2)], ['0'] * k)
+
+    # the vectors must be a whole number of vectors of the field
+    res = env.cmd('FT.SEARCH', 'idx', '@v:[$vec_param TOPK %d]=>{$batch: true}' % k,
+                  'PARAMS', 2, 'vec_param', blob[:-1], 'NOCONTENT')
+    env.assertEqual(res, [0])
+    env.expect('FT.SEARCH', 'idx', '@v:[$vec_param TOPK %d]=>{$batch: true}' % k, 'SORTBY', 'v_score',
+               'SEARCHAFTER', 2, '1', '0', 'PARAMS', 2, 'vec_param', blob).error().contains('SEARCHAFTER')
+    env.expect('FT.SEARCH', 'idx', 'even=>{$batch: true}').error().contains('requires vector node')
+
+def test_hybrid(env):
+    conn = getConnectionByEnv(env)
+    dimension = 8
+    qty = 1000
+    k = 10
+
+    conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'FLAT', '6', 'TYPE', 'FLOAT32',
+                         'DIM', dimension, 'DISTANCE_METRIC', 'L2', 't', 'TEXT')
+    data = np.float32(np.random.random((qty, dimension)))
+    for i, vector in enumerate(data):
+        conn.execute_command('HSET', i, 'v', vector.tobytes(), 't', 'hello' if i % 2 == 0 else 'world')
+
+    query_data = np.float32(np.random.random(dimension))
+    dists = ((data - query_data) ** 2).sum(axis=1)
+    nearest = sorted(range(qty), key=lambda i: dists[i])[:k]
+    text_only = [i for i in range(0, qty, 2) if i not in nearest][0]
+
+    for weight in [1, 5]:
+        res = env.cmd('FT.SEARCH', 'idx', 'hello | @v:[$vec_param TOPK %d]=>{$weight: %d}' % (k, weight),
+                      'SCORER', 'HYBRID', 'WITHSCORES', 'NOCONTENT', 'PARAMS', 2, 'vec_param',
+                      query_data.tobytes(), 'LIMIT', 0, qty)
+        # the text matches and the vector matches, ranked together
+        env.assertEqual(res[0], len(set(range(0, qty, 2)) | set(nearest)))
+        scores = dict((int(res[i]), float(res[i + 1])) for i in range(1, len(res), 2))
+        text_score = scores[text_only]
+        env.assertGreater(text_score, 0)
+        for i in nearest:
+            expected = weight / (1 + dists[i]) + (text_score if i % 2 == 0 else 0)
+            env.assertAlmostEqual(scores[i], expected, delta=1e-4)
+        env.assertEqual(sorted(scores.values(), reverse=True), [float(res[i + 1]) for i in range(1, len(res), 2)])
+
+def test_geo_nearest(env):
+    # the distances of a NEAREST geo filter and of a vector clause are told apart
+    conn = getConnectionByEnv(env)
+    conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'FLAT', '6', 'TYPE', 'FLOAT32',
+                         'DIM', 2, 'DISTANCE_METRIC', 'L2', 'g', 'GEO')
+    # the geo order is a, b, c, d and the vector order is a, c, d, b
+    docs = {'a': (2.35, [0, 0]), 'b': (2.36, [300, 0]), 'c': (2.38, [100, 0]), 'd': (2.40, [200, 0])}
+    for key, (lon, vector) in docs.items():
+        conn.execute_command('HSET', key, 'g', '%f,48.85' % lon, 'v', np.float32(vector).tobytes())
+    vec_dists = dict((key, float(sum(x * x for x in vector))) for key, (_, vector) in docs.items())
+
+    def search(*args):
+        return env.cmd('FT.SEARCH', 'idx', '@v:[$vec_param TOPK 4]', 'GEOFILTER', 'g', 'NEAREST', 2.35,
+                       48.85, 4, 'km', 'PARAMS', 2, 'vec_param', np.float32([0, 0]).tobytes(), *args)
+
+    res = search('SORTBY', 'g_distance')
+    env.assertEqual(res[1::2], ['a', 'b', 'c', 'd'])
+    for key, fields in zip(res[1::2], res[2::2]):
+        env.assertLess(float(to_dict(fields)['g_distance']), 5)
+    res = search('SORTBY', 'v_score')
+    env.assertEqual(res[1::2], ['a', 'c', 'd', 'b'])
+    for key, fields in zip(res[1::2], res[2::2]):
+        env.assertAlmostEqual(float(to_dict(fields)['v_score']), vec_dists[key], delta=1e-3)
+
+    # HYBRID scores the vector similarity, not the geo distance
+    res = search('SCORER', 'HYBRID', 'WITHSCORES', 'NOCONTENT')
+    scores = dict((res[i], float(res[i + 1])) for i in range(1, len(res), 2))
+    for key in docs:
+        env.assertAlmostEqual(scores[key], 1 / (1 + vec_dists[key]), delta=1e-4)
+
+def test_half_precision(env):
+    conn = getConnectionByEnv(env)
+    dimension = 16
+    qty = 500
+    k = 10
+
+    def to_half(vec_type, vectors):
+        # returns the stored 2 byte elements, and their FLOAT32 values
+        if vec_type == 'FLOAT16':
+            half = vectors.astype(np.float16)
+            return half, half.astype(np.float32)
+        bits = vectors.view(np.uint32) >> 16
+        return bits.astype(np.uint16), (bits << 16).astype(np.uint32).view(np.float32)
+
+    data = np.float32(np.random.random((qty, dimension)))
+    query_data = np.float32(np.random.random(dimension))
+    for vec_type in ['FLOAT16', 'BFLOAT16']:
+        stored, values = to_half(vec_type, data)
+        query_blob, query_values = to_half(vec_type, query_data)
+        dists = ((values - query_values) ** 2).sum(axis=1)
+        expected = sorted(range(qty), key=lambda i: dists[i])
+        for algo in ['FLAT', 'HNSW']:
+            conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', algo, '6', 'TYPE', vec_type,
+                                 'DIM', dimension, 'DISTANCE_METRIC', 'L2')
+            info = to_dict(env.cmd('FT.INFO', 'idx'))
+            env.assertContains(vec_type, info['attributes'][0])
+            for i, vector in enumerate(stored):
+                conn.execute_command('HSET', i, 'v', vector.tobytes())
+
+            res = env.cmd('FT.SEARCH', 'idx', '@v:[$vec_param TOPK %d]' % k, 'SORTBY', 'v_score',
+                          'PARAMS', 2, 'vec_param', query_blob.tobytes(), 'NOCONTENT')
+            env.assertEqual(res[1:], [str(i) for i in expected[:k]])
+
+            # a blob which isn't a whole vector of this type matches nothing
+            res = env.cmd('FT.SEARCH', 'idx', '@v:[$vec_param TOPK %d]' % k, 'PARAMS', 2,
+                          'vec_param', query_blob.tobytes()[:-2], 'NOCONTENT')
+            env.assertEqual(res[0], 0)
+            conn.execute_command('FT.DROPINDEX', 'idx', 'DD')
+
+def test_reload(env):
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    dimension = 8
+    qty = 500
+    k = 10
+
+    conn.execute_command('FT.CREATE', 'hnsw', 'PREFIX', 1, 'h:', 'SCHEMA', 'v', 'VECTOR', 'HNSW', '12',
+                         'TYPE', 'FLOAT32', 'DIM', dimension, 'DISTANCE_METRIC', 'L2', 'M', '8',
+                         'EF_CONSTRUCTION', '100', 'EF_RUNTIME', qty)
+    conn.execute_command('FT.CREATE', 'flat', 'PREFIX', 1, 'f:', 'SCHEMA', 'v', 'VECTOR', 'FLAT', '10',
+                         'TYPE', 'FLOAT32', 'DIM', dimension, 'DISTANCE_METRIC', 'IP', 'BLOCK_SIZE', '100',
+                         'QUANTIZE', 'INT8')
+    data = np.float32(np.random.random((qty, dimension)))
+    for i, vector in enumerate(data):
+        conn.execute_command('HSET', 'h:%d' % i, 'v', vector.tobytes())
+        conn.execute_command('HSET', 'f:%d' % i, 'v', vector.tobytes())
+    query_data = np.float32(np.random.random(dimension))
+
+    def state():
+        res = {}
+        for idx in ('hnsw', 'flat'):
+            res[idx] = (to_dict(env.cmd('FT.INFO', idx))['attributes'],
+                        env.cmd('FT.SEARCH', idx, '@v:[$vec_param TOPK %d]' % k, 'SORTBY', 'v_score',
+                                'PARAMS', 2, 'vec_param', query_data.tobytes(), 'NOCONTENT'))
+        return res
+
+    before = state()
+    env.assertEqual(before['hnsw'][1][0], k)
+    # the vector parameters survive the reload, and the reindexed vectors give the same results
+    for _ in env.reloading_iterator():
+        waitForIndex(env, 'hnsw')
+        waitForIndex(env, 'flat')
+        env.assertEqual(state(), before)
+
+def test_async_insert():
+    env = Env(moduleArgs='VECSIM_THREADS 4')
+    conn = getConnectionByEnv(env)
+    dimension = 8
+    qty = 2000
+    k = 10
+
+    conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'HNSW', '6', 'TYPE', 'FLOAT32',
+                         'DIM', dimension, 'DISTANCE_METRIC', 'L2')
+    data = np.float32(np.random.random((qty, dimension)))
+    query_data = np.float32(np.random.random(dimension))
+    dists = ((data - query_data) ** 2).sum(axis=1)
+    live = set()
+    for i, vector in enumerate(data):
+        conn.execute_command('HSET', i, 'v', vector.tobytes())
+        live.add(i)
+        if i % 7 == 0:
+            conn.execute_command('DEL', i)
+            live.remove(i)
+        # queries see every vector added before them, even while the workers insert
+        if i % 500 == 499:
+            expected = sorted(live, key=lambda j: dists[j])[:k]
+            res = env.cmd('FT.SEARCH', 'idx', '@v:[$vec_param TOPK %d]=>{$efRuntime: %d}' % (k, qty),
+                          'SORTBY', 'v_score', 'PARAMS', 2, 'vec_param', query_data.tobytes(), 'NOCONTENT')
+            env.assertEqual(res[1:], [str(j) for j in expected])
+            # the vectors still queued are compared with the query directly
+            radius = float(dists[expected[-1]]) * 1.0001
+            res = env.cmd('FT.SEARCH', 'idx', '@v:[$vec_param RANGE %s]' % radius, 'SORTBY', 'v_score',
+                          'PARAMS', 2, 'vec_param', query_data.tobytes(), 'NOCONTENT')
+            env.assertEqual(res[1:], [str(j) for j in expected])
+    conn.execute_command('FT.DROPINDEX', 'idx', 'DD')